@@ -0,0 +1,74 @@
+// counting_new.h : Replaces the global allocation functions with ones that count the calls, so a
+// benchmark can tell how many allocations a pipeline makes. Include it from exactly one
+// translation unit of a benchmark executable.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+#    include <malloc.h>
+#endif
+
+// ---- Replaceable global allocation functions ----
+
+// Calls to the global operator new and bytes requested since the start of the program
+inline size_t globalAllocations = 0;
+inline size_t globalBytes = 0;
+
+void* operator new(size_t size)
+{
+    ++globalAllocations;
+    globalBytes += size;
+
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+// std::pmr::new_delete_resource(), which backs the frame allocator by default, may use the
+// alignment-aware overloads
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    ++globalAllocations;
+    globalBytes += size;
+
+    const auto align = static_cast<size_t>(alignment);
+#if defined(_MSC_VER)
+    if (void* ptr = _aligned_malloc(size == 0 ? 1 : size, align))
+#else
+    if (void* ptr = std::aligned_alloc(align, (size + align) / align * align))
+#endif
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+#if defined(_MSC_VER)
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(ptr, alignment);
+}
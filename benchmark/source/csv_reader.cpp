@@ -0,0 +1,135 @@
+// csv_reader.cpp : Sums the columns of a large in-memory CSV table parsed with std::getline and
+// std::stod into strings, with gentools::csv_rows and with gentools::csv_columns, and reports the
+// throughput.
+//
+// Exits with a non-zero status when the parsers disagree on the sums.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gentools/csv_reader.h>
+
+namespace
+{
+    struct table_sums
+    {
+        size_t rows = 0;
+        int64_t ids = 0;
+        double prices = 0;
+        size_t nameBytes = 0;
+
+        bool operator==(const table_sums&) const = default;
+    };
+
+    template <typename F>
+    table_sums report(const char* name, size_t textSize, F&& parse)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const table_sums sums = parse();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::printf("%-20s %8.2f GB/s %12zu rows\n", name, textSize / seconds / 1e9, sums.rows);
+        return sums;
+    }
+}
+
+int main()
+{
+    // id,name,price records, a few names quoted
+    std::string text{};
+    text.reserve(size_t{64} << 20);
+    uint32_t state = 12345;
+    for (int64_t id = 0; text.size() < (size_t{64} << 20); ++id)
+    {
+        state = state * 1664525 + 1013904223;
+        const size_t length = 4 + (state >> 16) % 20;
+        std::string name(length, static_cast<char>('a' + state % 26));
+        if (state % 16 == 0)
+        {
+            name = "\"" + name + ", inc\"";
+        }
+        text += std::to_string(id) + "," + name + "," + std::to_string((state >> 8) % 10000) + ".25\n";
+    }
+
+    const auto strings = report("getline + stod", text.size(), [&] {
+        table_sums sums{};
+        std::istringstream in{text};
+        std::string line{};
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> fields{};
+            std::string field{};
+            bool quoted = false;
+            for (char c : line)
+            {
+                if (c == '"')
+                {
+                    quoted = !quoted;
+                }
+                else if (c == ',' && !quoted)
+                {
+                    fields.push_back(std::move(field));
+                    field.clear();
+                }
+                else
+                {
+                    field.push_back(c);
+                }
+            }
+            fields.push_back(std::move(field));
+
+            ++sums.rows;
+            sums.ids += std::stoll(fields[0]);
+            sums.nameBytes += fields[1].size();
+            sums.prices += std::stod(fields[2]);
+        }
+        return sums;
+    });
+
+    const auto rows = report("csv_rows", text.size(), [&] {
+        table_sums sums{};
+        for (auto fields : gentools::csv_rows(text))
+        {
+            ++sums.rows;
+            sums.ids += std::stoll(std::string{fields[0]});
+            sums.nameBytes += fields[1].size();
+            sums.prices += std::stod(std::string{fields[2]});
+        }
+        return sums;
+    });
+
+    const auto columns = report("csv_columns", text.size(), [&] {
+        table_sums sums{};
+        for (const auto& batch : gentools::csv_columns(
+                 text, {gentools::csv_type::int64, gentools::csv_type::string, gentools::csv_type::float64}))
+        {
+            sums.rows += batch.size();
+            for (auto id : batch.int64s(0))
+            {
+                sums.ids += id;
+            }
+            for (auto name : batch.strings(1))
+            {
+                sums.nameBytes += name.size();
+            }
+            for (auto price : batch.float64s(2))
+            {
+                sums.prices += price;
+            }
+        }
+        return sums;
+    });
+
+    if (!(rows == strings && columns == strings))
+    {
+        std::printf("the parsers disagree on the sums\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+// file_writer.cpp : Writes the 16 byte records of a pipeline to a temporary file with an ofstream
+// loop and with write_records, synchronously and through io_uring, and reports the throughput of
+// each. The file mostly ends up in the page cache, so this measures the per-record and per-write
+// overhead rather than the device.
+//
+// Exits with a non-zero status when the files differ.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <gentools.h>
+#include <gentools/file_writer.h>
+
+namespace
+{
+    constexpr uint64_t recordCount = uint64_t{4} << 20;
+
+    struct record
+    {
+        uint64_t id;
+        double value;
+    };
+
+    gentools::generator<record> records()
+    {
+        for (uint64_t id = 0; id < recordCount; ++id)
+        {
+            co_yield record{id, id * 0.25};
+        }
+    }
+
+    std::string read_all(const std::filesystem::path& path)
+    {
+        std::ifstream in{path, std::ios::binary};
+        return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    }
+
+    // Times write, then reads the file back and removes it, so the writers do not compete for the page cache
+    template <typename F>
+    std::string report(const char* name, const std::filesystem::path& path, F&& write)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        write();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::printf("%-22s %10.1f MB/s\n", name, recordCount * sizeof(record) / seconds / (1 << 20));
+
+        auto content = read_all(path);
+        std::filesystem::remove(path);
+        return content;
+    }
+}
+
+int main()
+{
+    const auto path = std::filesystem::temp_directory_path() / "gentools_benchmark_file_writer";
+
+    const auto expected = report("ofstream", path, [&] {
+        std::ofstream out{path, std::ios::binary};
+        for (const auto& r : records())
+        {
+            out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+        }
+    });
+
+    const auto pwrite = report("write_records pwrite", path, [&] {
+        gentools::write_records(records(), path, {size_t{1} << 20, 1, false});
+    });
+
+    const auto ioUring = report("write_records io_uring", path, [&] {
+        gentools::write_records(records(), path, {size_t{1} << 20, 4, true});
+    });
+
+    if (expected.size() != recordCount * sizeof(record) || pwrite != expected || ioUring != expected)
+    {
+        std::printf("the files differ\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+// frame_pool.cpp : Measures small pipelines constructed over and over on tiny inputs, with and
+// without frame recycling.
+//
+// Exits with a non-zero status when, at steady state, a pooled pipeline allocates a frame that
+// is not taken from the frame pool, or when the filter/transform pipeline, which has no internal
+// buffers, still reaches the global allocator.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include <gentools.h>
+#include <gentools/json.h>
+
+#include "counting_new.h"
+
+// ---- Benchmark ----
+
+namespace
+{
+    const nlohmann::json document = nlohmann::json::parse(R"({"a": 1, "b": {"c": 2, "d": {"e": 3}}})");
+
+    struct pipeline
+    {
+        const char* name;
+        // the pipeline allocates no internal buffer, so a pooled run must not reach operator new
+        bool bufferless;
+        std::function<long(const std::vector<int>&)> run;
+    };
+
+    const pipeline pipelines[] = {
+        {"filter(transform)", true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                auto squares = gentools::transform(input, [](int x) { return x * x; });
+                for (auto v : gentools::filter(squares, [](int x) { return x % 3 == 1; })) sum += v;
+                return sum;
+            }},
+        {"cycle", false, [](const std::vector<int>& input)
+            {
+                // a generator is an input range, so this is the cycle with a value buffer
+                long sum = 0;
+                size_t i = 0;
+                auto source = gentools::to_generator(input);
+                for (auto v : gentools::cycle(source))
+                {
+                    if (i++ == input.size() * 2) break;
+                    sum += v;
+                }
+                return sum;
+            }},
+        {"chain", false, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::chain(input, input)) sum += v;
+                return sum;
+            }},
+        {"traverse", false, [](const std::vector<int>&)
+            {
+                long sum = 0;
+                for (auto&& item : gentools::traverse(document)) sum += static_cast<long>(item.key.size());
+                return sum;
+            }},
+    };
+
+    struct result
+    {
+        double nanoseconds;
+        double allocations;
+        // frames allocated that were not taken from the frame pool
+        double unpooledFrames;
+    };
+
+    result measure(const pipeline& p, const std::vector<int>& input, size_t iterations, long& sink)
+    {
+        // warm up, so the pooled run is measured at steady state
+        sink += p.run(input);
+
+        auto& pool = gentools::thread_frame_pool();
+        const size_t allocationsBefore = globalAllocations;
+        const size_t hitsBefore = pool.stats().hits;
+        const auto framesBefore = gentools::thread_frame_counters();
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            sink += p.run(input);
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto frames = gentools::thread_frame_counters() - framesBefore;
+        const auto n = static_cast<double>(iterations);
+
+        return {std::chrono::duration<double, std::nano>(elapsed).count() / n,
+                (globalAllocations - allocationsBefore) / n,
+                (frames.allocations - (pool.stats().hits - hitsBefore)) / n};
+    }
+}
+
+int main()
+{
+    constexpr size_t iterations = 200000;
+
+    const std::vector<int> input{1, 2, 3, 4, 5, 6, 7, 8};
+    long sink = 0;
+    int failures = 0;
+
+    auto& pool = gentools::thread_frame_pool();
+    const size_t capacity = pool.capacity() > 0 ? pool.capacity() : GENTOOLS_FRAME_POOL_CAPACITY;
+
+    std::printf("%-18s %12s %14s %12s %14s %16s  %s\n", "pipeline", "new ns", "new news", "pooled ns",
+                "pooled news", "unpooled frames", "status");
+
+    for (const auto& p : pipelines)
+    {
+        pool.set_capacity(0);
+        const auto unpooled = measure(p, input, iterations, sink);
+
+        pool.set_capacity(capacity);
+        const auto pooled = measure(p, input, iterations, sink);
+
+        const bool ok = pooled.unpooledFrames == 0 && (!p.bufferless || pooled.allocations == 0);
+        failures += ok ? 0 : 1;
+
+        std::printf("%-18s %12.1f %14.2f %12.1f %14.2f %16.2f  %s\n", p.name, unpooled.nanoseconds,
+                    unpooled.allocations, pooled.nanoseconds, pooled.allocations, pooled.unpooledFrames,
+                    ok ? "ok" : "REGRESSION");
+    }
+
+    const auto& stats = pool.stats();
+    std::printf("pool: %zu hits, %zu misses, %zu recycled, %zu released, %zu cached frames\n", stats.hits,
+                stats.misses, stats.recycled, stats.released, stats.cached_frames);
+    std::printf("checksum %ld\n", sink);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
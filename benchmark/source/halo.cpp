@@ -0,0 +1,205 @@
+// halo.cpp : Counts the coroutine frames and global allocations made per call by gentools
+// pipelines, to verify which of them get their frame allocation elided (HALO).
+//
+// Exits with a non-zero status when a pipeline makes more allocations per call than its budget,
+// which is how a regression that reintroduces per-call allocations fails the benchmark target.
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <gentools.h>
+
+#include "counting_new.h"
+
+// ---- Pipelines ----
+
+namespace
+{
+#if defined(GENTOOLS_EXPECT_ELISION)
+    constexpr bool expectElision = true;
+#else
+    constexpr bool expectElision = false;
+#endif
+
+    struct pipeline
+    {
+        const char* name;
+        // frames the pipeline allocates per call when nothing is elided
+        size_t frames;
+        // global allocations made by the pipeline body itself (internal buffers)
+        size_t buffers;
+        // the frame is created and destroyed in the caller's scope without escaping,
+        // so an optimizing compiler is allowed to place it on the caller's stack
+        bool elidable;
+        std::function<long(const std::vector<int>&)> run;
+    };
+
+    struct measurement
+    {
+        double frames;
+        double frameBytes;
+        double globalAllocations;
+    };
+
+    // the input and the consumption loop are kept opaque to the optimizer through the returned
+    // sum, but each generator lives entirely inside the lambda, which is what HALO requires
+    const pipeline pipelines[] = {
+        {"to_generator", 1, 0, true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::to_generator(input)) sum += v;
+                return sum;
+            }},
+        {"transform", 1, 0, true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::transform(input, [](int x) { return x * 2; })) sum += v;
+                return sum;
+            }},
+        {"filter", 1, 0, true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::filter(input, [](int x) { return x % 2 == 0; })) sum += v;
+                return sum;
+            }},
+        {"take_while", 1, 0, true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::take_while(input, [](int x) { return x < 32; })) sum += v;
+                return sum;
+            }},
+        {"drop_while", 1, 0, true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::drop_while(input, [](int x) { return x < 32; })) sum += v;
+                return sum;
+            }},
+        {"star_transform", 1, 0, true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::star_transform(input, [](int x) { return x + 1; })) sum += v;
+                return sum;
+            }},
+        {"count", 1, 0, true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::count<int>())
+                {
+                    if (v == static_cast<int>(input.size())) break;
+                    sum += v;
+                }
+                return sum;
+            }},
+        {"repeat", 1, 0, true, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::repeat(static_cast<int>(input.front()), input.size())) sum += v;
+                return sum;
+            }},
+        {"accumulate", 1, 0, false, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::accumulate(input)) sum += v;
+                return sum;
+            }},
+        {"compress", 1, 0, false, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::compress(input, input)) sum += v;
+                return sum;
+            }},
+        {"group_by", 1, 0, false, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto&& [key, group] : gentools::group_by(input, [](int x) { return x / 8; })) sum += key;
+                return sum;
+            }},
+        {"cycle", 1, 0, false, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                size_t i = 0;
+                for (auto v : gentools::cycle(input))
+                {
+                    if (i++ == input.size() * 2) break;
+                    sum += v;
+                }
+                return sum;
+            }},
+        {"chain", 4, 1, false, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                for (auto v : gentools::chain(input, input, input)) sum += v;
+                return sum;
+            }},
+        {"chain_heterogeneous", 3, 1, false, [](const std::vector<int>& input)
+            {
+                const std::string text{"gentools"};
+                long sum = 0;
+                for (auto&& v : gentools::chain_heterogeneous(input, text)) sum += static_cast<long>(v.index());
+                return sum;
+            }},
+        {"filter(transform)", 2, 0, false, [](const std::vector<int>& input)
+            {
+                long sum = 0;
+                auto doubled = gentools::transform(input, [](int x) { return x * 2; });
+                for (auto v : gentools::filter(doubled, [](int x) { return x % 3 == 0; })) sum += v;
+                return sum;
+            }},
+    };
+
+    measurement measure(const pipeline& p, const std::vector<int>& input, size_t iterations, long& sink)
+    {
+        const auto framesBefore = gentools::thread_frame_counters();
+        const size_t globalBefore = globalAllocations;
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            sink += p.run(input);
+        }
+
+        const auto frames = gentools::thread_frame_counters() - framesBefore;
+        const auto n = static_cast<double>(iterations);
+
+        return {frames.allocations / n, frames.bytes / n, (globalAllocations - globalBefore) / n};
+    }
+}
+
+int main()
+{
+    constexpr size_t iterations = 10000;
+
+    std::vector<int> input(64);
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = static_cast<int>(i);
+    }
+
+    // recycled frames would hide the per-call allocations this benchmark is looking for
+    gentools::thread_frame_pool().set_capacity(0);
+
+    long sink = 0;
+    int failures = 0;
+
+    std::printf("%-22s %10s %12s %10s %10s  %s\n", "pipeline", "frames", "frame bytes", "news", "budget", "status");
+
+    for (const auto& p : pipelines)
+    {
+        const auto m = measure(p, input, iterations, sink);
+
+        const bool expectElided = expectElision && p.elidable;
+        const double budget = static_cast<double>((expectElided ? 0 : p.frames) + p.buffers);
+        const bool ok = m.globalAllocations <= budget;
+        failures += ok ? 0 : 1;
+
+        std::printf("%-22s %10.2f %12.1f %10.2f %10.0f  %s%s\n", p.name, m.frames, m.frameBytes,
+                    m.globalAllocations, budget, ok ? "ok" : "REGRESSION",
+                    m.frames == 0 ? " (elided)" : "");
+    }
+
+    std::printf("checksum %ld\n", sink);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+// json_index.cpp : Runs the same key queries repeatedly over a large nlohmann::json document,
+// walking the document each time and answering them from a json_index built once, and reports
+// the time to build the index and the time per query of each.
+// The document serializes to about 100 MB by default, or to the number of MB given as argument.
+//
+// Exits with a non-zero status when the document and the index disagree on the matches.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+
+#include <gentools/json_index.h>
+#include <gentools/json_query.h>
+
+namespace
+{
+    struct match_stats
+    {
+        size_t matches = 0;
+        size_t pathBytes = 0;
+
+        bool operator==(const match_stats&) const = default;
+    };
+
+    template <typename T>
+    match_stats tally(T&& matches)
+    {
+        match_stats stats{};
+        for (const auto& match : matches)
+        {
+            ++stats.matches;
+            stats.pathBytes += match.path.size();
+        }
+        return stats;
+    }
+
+    template <typename F>
+    double measure(F&& run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+
+    nlohmann::json make_document(size_t megabytes)
+    {
+        nlohmann::json records = nlohmann::json::array();
+        size_t bytes = 0;
+        for (uint64_t i = 0; bytes < (megabytes << 20); ++i)
+        {
+            nlohmann::json record = {
+                {"id", i},
+                {"name", "customer number " + std::to_string(i)},
+                {"balance", i * 0.25},
+                {"address", {{"street", "long street name " + std::to_string(i % 1000)}, {"zip", i % 100000}}},
+                {"history", {{"created", "2020-01-01"}, {"logins", {1, 2, 3, 4, 5, 6, 7, 8}}}},
+            };
+            // a rare key
+            if (i % 1000 == 0)
+            {
+                record["audit"] = {{"by", "admin"}};
+            }
+            bytes += record.dump().size() + 2;
+            records.push_back(std::move(record));
+        }
+        return {{"records", std::move(records)}};
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using gentools::json_field;
+    using gentools::json_op;
+
+    constexpr int repetitions = 5;
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const nlohmann::json document = make_document(megabytes);
+
+    std::optional<gentools::json_index> index{};
+    const double build = measure([&] { index.emplace(document); });
+    std::printf("json_index build %.1f ms, %zu nodes, %zu keys\n\n", build, index->size(), index->key_count());
+    std::printf("%-26s %14s %14s %10s\n", "query", "document ms", "index ms", "matches");
+
+    bool agree = true;
+    for (const char* key : {"zip", "audit", "by"})
+    {
+        for (bool withValue : {false, true})
+        {
+            auto builder = gentools::from(document).where(json_field::key, json_op::equals, key);
+            if (withValue)
+            {
+                builder.where(json_field::value, json_op::greater, 50000);
+            }
+            const auto query = builder.select();
+
+            match_stats walked{};
+            match_stats indexed{};
+            const double walk = measure([&] {
+                for (int i = 0; i < repetitions; ++i)
+                {
+                    walked = tally(query(document));
+                }
+            });
+            const double lookup = measure([&] {
+                for (int i = 0; i < repetitions; ++i)
+                {
+                    indexed = tally(query(*index));
+                }
+            });
+
+            const std::string name = std::string{"key == "} + key + (withValue ? ", value > 50000" : "");
+            std::printf("%-26s %14.2f %14.2f %10zu\n", name.c_str(), walk / repetitions, lookup / repetitions,
+                        indexed.matches);
+            agree = agree && walked == indexed;
+        }
+    }
+
+    if (!agree)
+    {
+        std::printf("the document and the index disagree on the matches\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
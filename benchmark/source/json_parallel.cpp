@@ -0,0 +1,134 @@
+// json_parallel.cpp : Measures how parallel_traverse and parallel_query scale with the number of
+// worker threads on a large nlohmann::json document holding one array of records, against
+// traverse_nodes and a json_query walking it on one thread. The aggregation sums the balances of
+// the records, the query selects the zip codes above 50000.
+// The document serializes to about 100 MB by default, or to the number of MB given as argument.
+//
+// Exits with a non-zero status when a parallel run disagrees with the serial one.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <gentools/json_parallel.h>
+
+namespace
+{
+    struct match_stats
+    {
+        size_t matches = 0;
+        size_t pathBytes = 0;
+
+        bool operator==(const match_stats&) const = default;
+    };
+
+    template <typename T>
+    match_stats tally(T&& matches)
+    {
+        match_stats stats{};
+        for (const auto& match : matches)
+        {
+            ++stats.matches;
+            stats.pathBytes += match.path.size();
+        }
+        return stats;
+    }
+
+    // The sum of the balances in a partition, with integers so every grouping of the sum agrees
+    uint64_t sum_balances(const gentools::json_partition& partition)
+    {
+        uint64_t sum = 0;
+        for (const auto& node : gentools::traverse_nodes(partition))
+        {
+            if (node.key() == "balance")
+            {
+                sum += static_cast<uint64_t>(node.json().get<double>() * 4);
+            }
+        }
+        return sum;
+    }
+
+    template <typename F>
+    double measure(F&& run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+
+    nlohmann::json make_document(size_t megabytes)
+    {
+        nlohmann::json records = nlohmann::json::array();
+        size_t bytes = 0;
+        for (uint64_t i = 0; bytes < (megabytes << 20); ++i)
+        {
+            nlohmann::json record = {
+                {"id", i},
+                {"name", "customer number " + std::to_string(i)},
+                {"balance", i * 0.25},
+                {"address", {{"street", "long street name " + std::to_string(i % 1000)}, {"zip", i % 100000}}},
+                {"history", {{"created", "2020-01-01"}, {"logins", {1, 2, 3, 4, 5, 6, 7, 8}}}},
+            };
+            bytes += record.dump().size() + 2;
+            records.push_back(std::move(record));
+        }
+        return {{"records", std::move(records)}};
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using gentools::json_field;
+    using gentools::json_op;
+
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const nlohmann::json document = make_document(megabytes);
+    const auto query = gentools::from(document)
+                           .where(json_field::key, json_op::equals, "zip")
+                           .where(json_field::value, json_op::greater, 50000)
+                           .select();
+
+    uint64_t expectedSum = 0;
+    const double serialSum = measure([&] { expectedSum = sum_balances(gentools::json_partition{document}); });
+    match_stats expectedMatches{};
+    const double serialQuery = measure([&] { expectedMatches = tally(query(document)); });
+
+    std::printf("%-28s %8s %10s %8s\n", "mode", "threads", "ms", "speedup");
+    std::printf("%-28s %8d %10.1f %8.2f\n", "serial sum", 1, serialSum, 1.);
+    std::printf("%-28s %8d %10.1f %8.2f\n", "serial query", 1, serialQuery, 1.);
+
+    bool agree = true;
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        gentools::thread_pool pool{threads};
+
+        for (bool ordered : {true, false})
+        {
+            uint64_t sum = 0;
+            const double parallel = measure([&] {
+                for (uint64_t partial : gentools::parallel_traverse(pool, document, sum_balances, {.ordered = ordered}))
+                {
+                    sum += partial;
+                }
+            });
+            std::printf("%-28s %8zu %10.1f %8.2f\n", ordered ? "parallel_traverse" : "parallel_traverse unordered",
+                        threads, parallel, serialSum / parallel);
+            agree = agree && sum == expectedSum;
+        }
+
+        match_stats matches{};
+        const double parallel = measure([&] { matches = tally(gentools::parallel_query(pool, query, document)); });
+        std::printf("%-28s %8zu %10.1f %8.2f\n", "parallel_query", threads, parallel, serialQuery / parallel);
+        agree = agree && matches == expectedMatches;
+    }
+
+    if (!agree)
+    {
+        std::printf("a parallel run disagrees with the serial one\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
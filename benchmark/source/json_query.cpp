@@ -0,0 +1,142 @@
+// json_query.cpp : Runs the same selections over a large nlohmann::json document as compiled
+// json_query objects and as gentools::traverse_paths filtered by hand, and reports the time of each.
+// The path and depth clauses let the query skip the subtrees that cannot match.
+// The document serializes to about 100 MB by default, or to the number of MB given as argument.
+//
+// Exits with a non-zero status when a query and its filter disagree on the values.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <gentools.h>
+#include <gentools/json.h>
+#include <gentools/json_query.h>
+
+namespace
+{
+    struct match_stats
+    {
+        size_t matches = 0;
+        size_t pathBytes = 0;
+
+        bool operator==(const match_stats&) const = default;
+    };
+
+    template <typename F>
+    match_stats report(const char* name, F&& select)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const match_stats stats = select();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("%-34s %8.1f ms %10zu matches\n", name, std::chrono::duration<double, std::milli>(elapsed).count(),
+                    stats.matches);
+        return stats;
+    }
+
+    template <typename T>
+    match_stats tally(T&& matches)
+    {
+        match_stats stats{};
+        for (const auto& match : matches)
+        {
+            ++stats.matches;
+            stats.pathBytes += match.path.size();
+        }
+        return stats;
+    }
+
+    nlohmann::json make_document(size_t megabytes)
+    {
+        nlohmann::json records = nlohmann::json::array();
+        size_t bytes = 0;
+        for (uint64_t i = 0; bytes < (megabytes << 20); ++i)
+        {
+            nlohmann::json record = {
+                {"id", i},
+                {"name", "customer number " + std::to_string(i)},
+                {"balance", i * 0.25},
+                {"address", {{"street", "long street name " + std::to_string(i % 1000)}, {"zip", i % 100000}}},
+                {"history", {{"created", "2020-01-01"}, {"logins", {1, 2, 3, 4, 5, 6, 7, 8}}}},
+            };
+            bytes += record.dump().size() + 2;
+            records.push_back(std::move(record));
+        }
+        return {{"records", std::move(records)}, {"total", bytes}};
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using gentools::json_field;
+    using gentools::json_op;
+
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const nlohmann::json document = make_document(megabytes);
+    bool agree = true;
+
+    const auto keyFilter = report("traverse_paths: key == zip", [&] {
+        match_stats stats{};
+        for (const auto& item : gentools::traverse_paths(document))
+        {
+            if (item.path.ends_with("/zip"))
+            {
+                ++stats.matches;
+                stats.pathBytes += item.path.size();
+            }
+        }
+        return stats;
+    });
+    agree = report("json_query: key == zip", [&] {
+                         return tally(gentools::from(document).where(json_field::key, json_op::equals, "zip").select()());
+                     }) == keyFilter && agree;
+
+    const auto pathFilter = report("traverse_paths: path ^= /records/7", [&] {
+        match_stats stats{};
+        for (const auto& item : gentools::traverse_paths(document))
+        {
+            if (item.path.starts_with("/records/7/"))
+            {
+                ++stats.matches;
+                stats.pathBytes += item.path.size();
+            }
+        }
+        return stats;
+    });
+    agree = report("json_query: path ^= /records/7", [&] {
+                         return tally(gentools::from(document)
+                                          .where(json_field::path, json_op::starts_with, "/records/7/")
+                                          .select()());
+                     }) == pathFilter && agree;
+
+    const auto depthFilter = report("traverse_paths: depth <= 3, >= 0", [&] {
+        match_stats stats{};
+        for (const auto& item : gentools::traverse_paths(document))
+        {
+            if (std::count(item.path.begin(), item.path.end(), '/') <= 3 &&
+                (item.value.is<uint64_t>() || item.value.is<double>()))
+            {
+                ++stats.matches;
+                stats.pathBytes += item.path.size();
+            }
+        }
+        return stats;
+    });
+    agree = report("json_query: depth <= 3, >= 0", [&] {
+                         return tally(gentools::from(document)
+                                          .where(json_field::depth, json_op::less_equal, 3)
+                                          .where(json_field::value, json_op::greater_equal, 0u)
+                                          .select()());
+                     }) == depthFilter && agree;
+
+    if (!agree)
+    {
+        std::printf("a query and its filter disagree on the values\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+// json_reader.cpp : Reads a large JSON text by parsing it into an nlohmann::json document and
+// walking it with traverse_paths, and with the json_events pull parser over 1 MB chunks, with and
+// without skipping a subtree of every record, and reports the throughput of each.
+// The text is about 100 MB by default, or the number of MB given as argument.
+//
+// Exits with a non-zero status when the readers disagree on the values.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gentools/json.h>
+#include <gentools/json_reader.h>
+
+namespace
+{
+    struct value_stats
+    {
+        size_t values = 0;
+        size_t stringBytes = 0;
+
+        bool operator==(const value_stats&) const = default;
+    };
+
+    template <typename F>
+    value_stats report(const char* name, size_t textSize, F&& read)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const value_stats stats = read();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::printf("%-28s %8.1f MB/s %12zu values\n", name, textSize / seconds / (1 << 20), stats.values);
+        return stats;
+    }
+
+    std::string make_text(size_t megabytes)
+    {
+        std::string text = "[";
+        for (uint64_t i = 0; text.size() < (megabytes << 20); ++i)
+        {
+            const auto id = std::to_string(i);
+            text += i == 0 ? "" : ",\n";
+            text += R"({"id": )" + id + R"(, "name": "customer number )" + id + R"(", "balance": )" + id + R"(.25, )" +
+                    R"("active": true, "tags": ["a", "b\"c"], )" +
+                    R"("history": {"created": "2020-01-01", "logins": [1, 2, 3, 4, 5, 6, 7, 8], "note": "é"}})";
+        }
+        text += "]";
+        return text;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const std::string text = make_text(megabytes);
+
+    std::vector<std::span<const char>> chunks{};
+    for (size_t i = 0; i < text.size(); i += size_t{1} << 20)
+    {
+        chunks.emplace_back(text.data() + i, std::min(size_t{1} << 20, text.size() - i));
+    }
+
+    const auto dom = report("nlohmann parse + traverse", text.size(), [&] {
+        value_stats stats{};
+        const auto document = nlohmann::json::parse(text);
+        for (const auto& item : gentools::traverse_paths(document))
+        {
+            ++stats.values;
+            if (item.value.is<std::string_view>())
+            {
+                stats.stringBytes += item.value.get<std::string_view>().size();
+            }
+        }
+        return stats;
+    });
+
+    const auto events = report("json_events", text.size(), [&] {
+        value_stats stats{};
+        for (const auto& event : gentools::json_events(chunks))
+        {
+            const auto token = event.token();
+            if (token != gentools::json_token::end_object && token != gentools::json_token::end_array && event.depth() > 0)
+            {
+                ++stats.values;
+            }
+            if (token == gentools::json_token::string)
+            {
+                stats.stringBytes += event.text().size();
+            }
+        }
+        return stats;
+    });
+
+    report("json_events skipping history", text.size(), [&] {
+        value_stats stats{};
+        for (const auto& event : gentools::json_events(chunks))
+        {
+            if (event.depth() == 2 && event.token() == gentools::json_token::begin_object)
+            {
+                event.skip();
+            }
+            ++stats.values;
+        }
+        return stats;
+    });
+
+    if (!(events == dom))
+    {
+        std::printf("the readers disagree on the values\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+// json_selector.cpp : Evaluates JSONPath-style selectors over a large nlohmann::json document with
+// compiled json_selector objects and with gentools::traverse_paths, matching the path of every
+// value by hand, and reports the time of each.
+// The document serializes to about 100 MB by default, or to the number of MB given as argument.
+//
+// Exits with a non-zero status when a selector and its traversal disagree on the values.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include <gentools.h>
+#include <gentools/json.h>
+#include <gentools/json_selector.h>
+
+namespace
+{
+    struct match_stats
+    {
+        size_t matches = 0;
+        size_t pathBytes = 0;
+
+        bool operator==(const match_stats&) const = default;
+    };
+
+    template <typename F>
+    match_stats report(const char* name, F&& select)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const match_stats stats = select();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("%-44s %8.1f ms %10zu matches\n", name, std::chrono::duration<double, std::milli>(elapsed).count(),
+                    stats.matches);
+        return stats;
+    }
+
+    // Whether path is a pointer like pattern, where * stands for any token
+    bool path_matches(std::string_view path, std::string_view pattern)
+    {
+        while (!path.empty() && !pattern.empty())
+        {
+            const size_t pathEnd = std::min(path.find('/', 1), path.size());
+            const size_t patternEnd = std::min(pattern.find('/', 1), pattern.size());
+            if (pattern.substr(0, patternEnd) != "/*" && path.substr(0, pathEnd) != pattern.substr(0, patternEnd))
+            {
+                return false;
+            }
+            path.remove_prefix(pathEnd);
+            pattern.remove_prefix(patternEnd);
+        }
+        return path.empty() && pattern.empty();
+    }
+
+    match_stats select(const gentools::json_selector& selector, const nlohmann::json& document)
+    {
+        match_stats stats{};
+        for (const auto& item : selector(document))
+        {
+            ++stats.matches;
+            stats.pathBytes += item.path.size();
+        }
+        return stats;
+    }
+
+    // Walks every value and keeps those whose path matches pattern and for which test holds, counting
+    // the path extended by suffix
+    match_stats filter(const nlohmann::json& document, std::string_view pattern, std::string_view suffix,
+                       const std::function<bool(const gentools::json_value&)>& test)
+    {
+        match_stats stats{};
+        for (const auto& item : gentools::traverse_paths(document))
+        {
+            if (path_matches(item.path, pattern) && test(item.value))
+            {
+                ++stats.matches;
+                stats.pathBytes += item.path.size() + suffix.size();
+            }
+        }
+        return stats;
+    }
+
+    nlohmann::json make_document(size_t megabytes)
+    {
+        nlohmann::json orders = nlohmann::json::array();
+        size_t bytes = 0;
+        for (uint64_t i = 0; bytes < (megabytes << 20); ++i)
+        {
+            nlohmann::json items = nlohmann::json::array();
+            for (uint64_t j = 0; j < 4; ++j)
+            {
+                items.push_back({{"sku", "sku-" + std::to_string(i * 4 + j)},
+                                 {"qty", (i + j * 7) % 20},
+                                 {"attributes", {{"color", "blue"}, {"size", j}, {"weights", {1.5, 2.5, 3.5}}}}});
+            }
+            nlohmann::json order = {
+                {"id", i},
+                {"customer", {{"name", "customer number " + std::to_string(i)}, {"zip", i % 100000}}},
+                {"items", std::move(items)},
+                {"history", {{"created", "2020-01-01"}, {"events", {"placed", "paid", "shipped", "delivered"}}}},
+            };
+            bytes += order.dump().size() + 2;
+            orders.push_back(std::move(order));
+        }
+        return {{"orders", std::move(orders)}, {"store", "north"}};
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const nlohmann::json document = make_document(megabytes);
+    bool agree = true;
+
+    const auto qtyFilter = report("traverse_paths: items with qty > 10", [&] {
+        return filter(document, "/orders/*/items/*", "/sku", [](const gentools::json_value& value) {
+            const auto& item = value.get<gentools::json_ref>().get();
+            const auto qty = item.find("qty");
+            return qty != item.cend() && qty->is_number() && qty->get<double>() > 10;
+        });
+    });
+    agree = report("$.orders[*].items[?(@.qty > 10)].sku", [&] {
+                return select(gentools::json_selector{"$.orders[*].items[?(@.qty > 10)].sku"}, document);
+            }) == qtyFilter && agree;
+
+    const auto zipFilter = report("traverse_paths: customer zips", [&] {
+        return filter(document, "/orders/*/customer/zip", "", [](const gentools::json_value&) { return true; });
+    });
+    agree = report("$.orders[*].customer.zip", [&] {
+                return select(gentools::json_selector{"$.orders[*].customer.zip"}, document);
+            }) == zipFilter && agree;
+
+    if (!agree)
+    {
+        std::printf("a selector and its traversal disagree on the values\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,298 @@
+// json_traverse.cpp : Walks a large nlohmann::json document with the traversals of the sample,
+// which copy every key and string value, and with gentools::traverse, gentools::traverse_paths and
+// gentools::traverse_nodes, the last depth first, breadth first, and down to the members of the
+// records only, by max_depth and by skip_children(), and reports the time of each. It then buffers
+// every value of the document as gentools::json_value and as the std::variant it replaced, and
+// reports the time to fill and to scan each buffer.
+// The document serializes to about 100 MB by default, or to the number of MB given as argument.
+//
+// Exits with a non-zero status when the traversals disagree on the members.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <gentools.h>
+#include <gentools/json.h>
+
+namespace
+{
+    // The traversals of sample/source/main.cpp
+    namespace sample
+    {
+        using json_ref = std::reference_wrapper<nlohmann::json>;
+        using json_value = std::variant<double, uint64_t, int64_t, bool, std::nullptr_t, std::string, json_ref>;
+
+        json_value convert(nlohmann::json& json)
+        {
+            if (json.is_structured()) return {std::ref(json)};
+            if (json.is_null()) return {nullptr};
+            if (json.is_boolean()) return {json.get<bool>()};
+            if (json.is_number_float()) return {json.get<double>()};
+            if (json.is_number_unsigned()) return {json.get<uint64_t>()};
+            if (json.is_number_integer()) return {json.get<int64_t>()};
+            if (json.is_string()) return {json.get<std::string>()};
+            return {nullptr};
+        }
+
+        gentools::generator<std::pair<std::string, json_value>> traverse_recursive(nlohmann::json& jsonRoot)
+        {
+            for (auto&& item : jsonRoot.items())
+            {
+                co_yield std::make_pair(item.key(), convert(item.value()));
+
+                if (item.value().is_object())
+                {
+                    for (auto&& [key, value] : traverse_recursive(item.value()))
+                    {
+                        co_yield std::make_pair(std::move(key), std::move(value));
+                    }
+                }
+            }
+        }
+
+        gentools::generator<std::pair<std::string, json_value>> traverse(nlohmann::json& jsonRoot)
+        {
+            std::vector<std::pair<std::string, json_ref>> stack{};
+            stack.reserve(jsonRoot.size());
+
+            auto pushToStack = [&stack](nlohmann::json& jsonObject) {
+                for (auto&& item : jsonObject.items())
+                {
+                    stack.emplace_back(item.key(), item.value());
+                }
+            };
+
+            pushToStack(jsonRoot);
+
+            while (!stack.empty())
+            {
+                auto [jsonKey, jsonRef] = stack.back();
+                stack.pop_back();
+
+                if (jsonRef.get().is_object())
+                {
+                    pushToStack(jsonRef.get());
+                }
+
+                co_yield std::make_pair(jsonKey, convert(jsonRef.get()));
+            }
+        }
+    }
+
+    struct member_stats
+    {
+        size_t members = 0;
+        size_t keyBytes = 0;
+        size_t stringBytes = 0;
+
+        template <typename Key, typename Value>
+        void add(const Key& key, const Value& value)
+        {
+            ++members;
+            keyBytes += key.size();
+            auto count = [this](const auto& v) {
+                if constexpr (requires { v.size(); v.data(); })
+                {
+                    stringBytes += v.size();
+                }
+            };
+            if constexpr (requires { value.visit(count); })
+            {
+                value.visit(count);
+            }
+            else
+            {
+                std::visit(count, value);
+            }
+        }
+
+        bool operator==(const member_stats&) const = default;
+    };
+
+    // The former gentools::json_value, 24 bytes
+    using variant_value = std::variant<double, uint64_t, int64_t, bool, std::nullptr_t, std::string_view, gentools::json_ref>;
+
+    size_t string_size(const gentools::json_value& value)
+    {
+        return value.is<std::string_view>() ? value.get<std::string_view>().size() : 0;
+    }
+
+    size_t string_size(const variant_value& value)
+    {
+        const auto* string = std::get_if<std::string_view>(&value);
+        return string != nullptr ? string->size() : 0;
+    }
+
+    // Buffers every value of the document, then reads the strings back from the buffer
+    template <typename Value>
+    void report_buffer(const char* name, const nlohmann::json& document)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<Value> values{};
+        for (const auto& item : gentools::traverse_paths(document))
+        {
+            if constexpr (std::is_same_v<Value, gentools::json_value>)
+            {
+                values.push_back(item.value);
+            }
+            else
+            {
+                values.push_back(item.value.visit([](const auto& v) { return Value{v}; }));
+            }
+        }
+
+        size_t stringBytes = 0;
+        const auto scan = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < 10; ++pass)
+        {
+            for (const auto& value : values)
+            {
+                stringBytes += string_size(value);
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+        std::printf("%-26s %8.1f ms buffer, %8.1f ms for 10 scans of %zu MB (%zu bytes per value)\n", name,
+                    std::chrono::duration<double, std::milli>(scan - start).count(),
+                    std::chrono::duration<double, std::milli>(end - scan).count(),
+                    values.size() * sizeof(Value) >> 20, sizeof(Value));
+        if (stringBytes == 0)
+        {
+            std::printf("no strings were read\n");
+        }
+    }
+
+    template <typename F>
+    member_stats report(const char* name, F&& walk)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const member_stats stats = walk();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("%-26s %8.1f ms %12zu members\n", name, std::chrono::duration<double, std::milli>(elapsed).count(),
+                    stats.members);
+        return stats;
+    }
+
+    nlohmann::json make_document(size_t megabytes)
+    {
+        nlohmann::json document = nlohmann::json::object();
+        size_t bytes = 0;
+        for (uint64_t i = 0; bytes < (megabytes << 20); ++i)
+        {
+            nlohmann::json record = {
+                {"id", i},
+                {"name", "customer number " + std::to_string(i)},
+                {"balance", i * 0.25},
+                {"active", i % 3 == 0},
+                {"address", {{"street", "long street name " + std::to_string(i % 1000)}, {"zip", i % 100000}}},
+                {"tags", {"a", "b", "c"}},
+                {"history", {{"created", "2020-01-01"}, {"logins", i % 97}, {"last", {{"ip", "10.0.0.1"}}}}},
+            };
+            bytes += record.dump().size() + 16;
+            document["record" + std::to_string(i)] = std::move(record);
+        }
+        return document;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    nlohmann::json document = make_document(megabytes);
+
+    const auto stack = report("sample traverse", [&] {
+        member_stats stats{};
+        for (auto&& [key, value] : sample::traverse(document))
+        {
+            stats.add(key, value);
+        }
+        return stats;
+    });
+
+    const auto recursive = report("sample traverse_recursive", [&] {
+        member_stats stats{};
+        for (auto&& [key, value] : sample::traverse_recursive(document))
+        {
+            stats.add(key, value);
+        }
+        return stats;
+    });
+
+    const auto views = report("gentools::traverse", [&] {
+        member_stats stats{};
+        for (const auto& item : gentools::traverse(document))
+        {
+            stats.add(item.key, item.value);
+        }
+        return stats;
+    });
+
+    // also walks the arrays, so it yields more values than the others
+    report("gentools::traverse_paths", [&] {
+        member_stats stats{};
+        for (const auto& item : gentools::traverse_paths(document))
+        {
+            stats.add(item.path, item.value);
+        }
+        return stats;
+    });
+
+    const auto depthFirst = report("traverse_nodes", [&] {
+        member_stats stats{};
+        for (const auto& node : gentools::traverse_nodes(document))
+        {
+            stats.add(node.key(), node.value());
+        }
+        return stats;
+    });
+
+    const auto breadthFirst = report("traverse_nodes breadth", [&] {
+        member_stats stats{};
+        for (const auto& node : gentools::traverse_nodes(document, {gentools::traversal_order::breadth_first}))
+        {
+            stats.add(node.key(), node.value());
+        }
+        return stats;
+    });
+
+    // the members of the records only, which do not need the nested objects and arrays
+    const auto limited = report("traverse_nodes max_depth 2", [&] {
+        member_stats stats{};
+        for (const auto& node : gentools::traverse_nodes(document, {gentools::traversal_order::depth_first, 2}))
+        {
+            stats.add(node.key(), node.value());
+        }
+        return stats;
+    });
+
+    const auto skipped = report("traverse_nodes skip", [&] {
+        member_stats stats{};
+        for (const auto& node : gentools::traverse_nodes(document))
+        {
+            stats.add(node.key(), node.value());
+            if (node.depth() == 2)
+            {
+                node.skip_children();
+            }
+        }
+        return stats;
+    });
+
+    report_buffer<variant_value>("buffered std::variant", document);
+    report_buffer<gentools::json_value>("buffered json_value", document);
+
+    if (!(recursive == stack && views == stack && breadthFirst == depthFirst && skipped == limited))
+    {
+        std::printf("the traversals disagree on the members\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
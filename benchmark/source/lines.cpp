@@ -0,0 +1,119 @@
+// lines.cpp : Splits a large in-memory text into lines with std::getline, with a memchr loop and
+// with gentools::lines, over the whole buffer and over 1 MB chunks, and reports the throughput.
+//
+// Exits with a non-zero status when the splitters disagree on the lines.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gentools/lines.h>
+
+namespace
+{
+    struct line_stats
+    {
+        size_t lines = 0;
+        size_t bytes = 0;
+
+        void add(std::string_view line) noexcept
+        {
+            ++lines;
+            bytes += line.size();
+        }
+
+        bool operator==(const line_stats&) const = default;
+    };
+
+    template <typename F>
+    line_stats report(const char* name, size_t textSize, F&& split)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const line_stats stats = split();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::printf("%-20s %8.2f GB/s %12zu lines\n", name, textSize / seconds / 1e9, stats.lines);
+        return stats;
+    }
+}
+
+int main()
+{
+    // log-like lines of 20 to 150 characters
+    std::string text{};
+    text.reserve(size_t{256} << 20);
+    uint32_t state = 12345;
+    while (text.size() < (size_t{256} << 20))
+    {
+        state = state * 1664525 + 1013904223;
+        const size_t length = 20 + (state >> 16) % 130;
+        for (size_t i = 0; i < length; ++i)
+        {
+            text.push_back(static_cast<char>('a' + (i + state) % 26));
+        }
+        text.push_back('\n');
+    }
+
+    const auto getline = report("std::getline", text.size(), [&] {
+        line_stats stats{};
+        std::istringstream in{text};
+        std::string line{};
+        while (std::getline(in, line))
+        {
+            stats.add(line);
+        }
+        return stats;
+    });
+
+    const auto memchrLoop = report("memchr loop", text.size(), [&] {
+        line_stats stats{};
+        const char* start = text.data();
+        const char* end = text.data() + text.size();
+        while (start < end)
+        {
+            const auto* newline = static_cast<const char*>(std::memchr(start, '\n', static_cast<size_t>(end - start)));
+            newline = newline != nullptr ? newline : end;
+            stats.add({start, static_cast<size_t>(newline - start)});
+            start = newline + 1;
+        }
+        return stats;
+    });
+
+    const auto buffer = report("lines(buffer)", text.size(), [&] {
+        line_stats stats{};
+        for (auto line : gentools::lines(text))
+        {
+            stats.add(line);
+        }
+        return stats;
+    });
+
+    std::vector<std::span<const char>> chunks{};
+    for (size_t i = 0; i < text.size(); i += size_t{1} << 20)
+    {
+        chunks.emplace_back(text.data() + i, std::min(size_t{1} << 20, text.size() - i));
+    }
+
+    const auto chunked = report("lines(chunks)", text.size(), [&] {
+        line_stats stats{};
+        for (auto line : gentools::lines(chunks))
+        {
+            stats.add(line);
+        }
+        return stats;
+    });
+
+    if (!(memchrLoop == getline && buffer == getline && chunked == getline))
+    {
+        std::printf("the splitters disagree on the lines\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
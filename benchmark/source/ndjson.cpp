@@ -0,0 +1,110 @@
+// ndjson.cpp : Measures how ndjson_documents and ndjson_transform scale with the number of worker
+// threads on newline-delimited JSON text, against parsing its lines one after the other.
+// The text is about 100 MB by default, or the number of MB given as argument.
+//
+// Exits with a non-zero status when a parallel run yields different documents than the serial one.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include <gentools/lines.h>
+#include <gentools/ndjson.h>
+
+namespace
+{
+    struct document_stats
+    {
+        size_t documents = 0;
+        uint64_t idSum = 0;
+
+        void add(const nlohmann::json& document)
+        {
+            ++documents;
+            idSum += document["id"].get<uint64_t>();
+        }
+
+        bool operator==(const document_stats&) const = default;
+    };
+
+    template <typename F>
+    double measure(F&& run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+    std::string make_text(size_t megabytes)
+    {
+        std::string text{};
+        for (uint64_t i = 0; text.size() < (megabytes << 20); ++i)
+        {
+            const auto id = std::to_string(i);
+            text += R"({"id": )" + id + R"(, "name": "customer number )" + id + R"(", "balance": )" + id + R"(.25, )" +
+                    R"("tags": ["a", "b"], "history": {"created": "2020-01-01", "logins": [1, 2, 3, 4, 5, 6, 7, 8]}})" +
+                    "\n";
+        }
+        return text;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    const std::string text = make_text(megabytes);
+    const double size = static_cast<double>(text.size()) / (1 << 20);
+
+    document_stats expected{};
+    const double serial = measure([&] {
+        for (const auto line : gentools::lines(text))
+        {
+            expected.add(nlohmann::json::parse(line));
+        }
+    });
+
+    std::printf("%-18s %8s %10s %10s %8s\n", "mode", "threads", "ms", "MB/s", "speedup");
+    std::printf("%-18s %8d %10.1f %10.1f %8.2f\n", "serial", 1, serial * 1000, size / serial, 1.);
+
+    bool correct = true;
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        gentools::thread_pool pool{threads};
+
+        document_stats documents{};
+        const double parallel = measure([&] {
+            for (const auto& document : gentools::ndjson_documents(pool, text))
+            {
+                documents.add(document);
+            }
+        });
+        std::printf("%-18s %8zu %10.1f %10.1f %8.2f\n", "ndjson_documents", threads, parallel * 1000, size / parallel,
+                    serial / parallel);
+
+        // the ids are extracted on the workers, so the documents never leave them
+        document_stats ids{};
+        const double transform = measure([&] {
+            for (uint64_t id : gentools::ndjson_transform(
+                     pool, text, [](nlohmann::json& document) { return document["id"].get<uint64_t>(); }))
+            {
+                ++ids.documents;
+                ids.idSum += id;
+            }
+        });
+        std::printf("%-18s %8zu %10.1f %10.1f %8.2f\n", "ndjson_transform", threads, transform * 1000,
+                    size / transform, serial / transform);
+
+        correct = correct && documents == expected && ids == expected;
+    }
+
+    if (!correct)
+    {
+        std::printf("a parallel run yielded different documents\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
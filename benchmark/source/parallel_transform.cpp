@@ -0,0 +1,106 @@
+// parallel_transform.cpp : Measures how parallel_transform scales with the number of worker
+// threads on an expensive per-element function, in ordered and unordered mode, against a serial
+// transform of the same input.
+//
+// Exits with a non-zero status when a parallel run yields different results than the serial one.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <gentools/parallel.h>
+
+namespace
+{
+    // A few microseconds of arithmetic per element, with a cost that varies between elements so
+    // the reorder window has something to absorb
+    uint64_t expensive(int x)
+    {
+        uint64_t state = static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull + 1;
+        const int rounds = 2000 + (x % 7) * 500;
+        for (int i = 0; i < rounds; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+        }
+        return state;
+    }
+
+    template <typename F>
+    double measure(F&& run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+}
+
+int main()
+{
+    constexpr int elements = 20000;
+
+    std::vector<int> input(elements);
+    for (int i = 0; i < elements; ++i)
+    {
+        input[i] = i;
+    }
+
+    auto func = [](int x) { return expensive(x); };
+
+    std::vector<uint64_t> expected{};
+    expected.reserve(elements);
+    const double serial = measure([&] {
+        for (auto v : gentools::transform(input, func))
+        {
+            expected.push_back(v);
+        }
+    });
+
+    std::vector<uint64_t> sortedExpected = expected;
+    std::sort(sortedExpected.begin(), sortedExpected.end());
+
+    std::printf("%-10s %8s %12s %14s %8s\n", "mode", "threads", "ms", "elements/ms", "speedup");
+    std::printf("%-10s %8d %12.1f %14.1f %8.2f\n", "serial", 1, serial, elements / serial, 1.);
+
+    bool correct = true;
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        gentools::thread_pool pool{threads};
+
+        std::vector<uint64_t> results{};
+        results.reserve(elements);
+        const double ordered = measure([&] {
+            for (auto v : gentools::parallel_transform(pool, input, func))
+            {
+                results.push_back(v);
+            }
+        });
+        correct = correct && results == expected;
+        std::printf("%-10s %8zu %12.1f %14.1f %8.2f\n", "ordered", threads, ordered, elements / ordered,
+                    serial / ordered);
+
+        results.clear();
+        const double unordered = measure([&] {
+            for (auto v : gentools::parallel_transform_unordered(pool, input, func))
+            {
+                results.push_back(v);
+            }
+        });
+        std::sort(results.begin(), results.end());
+        correct = correct && results == sortedExpected;
+        std::printf("%-10s %8zu %12.1f %14.1f %8.2f\n", "unordered", threads, unordered, elements / unordered,
+                    serial / unordered);
+    }
+
+    if (!correct)
+    {
+        std::printf("parallel results differ from the serial ones\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+// scheduler.cpp : Runs thousands of small independent pipelines, each driven from its own loop
+// on the calling thread, then multiplexed by a scheduler over 1, 2, 4 and 8 workers.
+//
+// Exits with a non-zero status when the scheduled pipelines produce a different total.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <gentools/scheduler.h>
+
+namespace
+{
+    constexpr int pipelines = 5000;
+    constexpr int elements = 200;
+
+    uint64_t square(int x)
+    {
+        return static_cast<uint64_t>(x) * static_cast<uint64_t>(x);
+    }
+
+    bool odd(uint64_t x)
+    {
+        return x % 2 == 1;
+    }
+
+    // The adaptors reference their upstream, so the stages are built inside a generator whose
+    // frame keeps them alive for as long as the scheduler holds it
+    gentools::generator<uint64_t> odd_squares(const std::vector<int>& input)
+    {
+        auto squares = gentools::transform(input, square);
+        for (auto v : gentools::filter(squares, odd))
+        {
+            co_yield v;
+        }
+    }
+
+    template <typename F>
+    double measure(F&& run)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::milli>(elapsed).count();
+    }
+}
+
+int main()
+{
+    std::vector<int> input(elements);
+    for (int i = 0; i < elements; ++i)
+    {
+        input[i] = i;
+    }
+
+    uint64_t expected = 0;
+    const double loops = measure([&] {
+        for (int p = 0; p < pipelines; ++p)
+        {
+            for (auto v : odd_squares(input))
+            {
+                expected += v;
+            }
+        }
+    });
+
+    std::printf("%-10s %8s %12s %16s %8s\n", "driver", "threads", "ms", "pipelines/ms", "slices");
+    std::printf("%-10s %8d %12.1f %16.1f %8s\n", "loops", 1, loops, pipelines / loops, "-");
+
+    bool correct = true;
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        std::atomic<uint64_t> total{0};
+        size_t slices = 0;
+
+        const double scheduled = measure([&] {
+            gentools::scheduler scheduler{threads, {64, std::chrono::microseconds{200}}};
+            for (int p = 0; p < pipelines; ++p)
+            {
+                scheduler.spawn(odd_squares(input),
+                                [&total](uint64_t v) { total.fetch_add(v, std::memory_order_relaxed); });
+            }
+            scheduler.wait();
+            slices = scheduler.stats().slices;
+        });
+
+        correct = correct && total == expected;
+        std::printf("%-10s %8zu %12.1f %16.1f %8zu\n", "scheduler", threads, scheduled, pipelines / scheduled, slices);
+    }
+
+    if (!correct)
+    {
+        std::printf("scheduled pipelines produced a different total\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
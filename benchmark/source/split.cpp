@@ -0,0 +1,110 @@
+// split.cpp : Tokenizes a large comma separated text into a std::vector<std::string>, with
+// gentools::split and with gentools::split_batches, and reports the throughput.
+//
+// Exits with a non-zero status when the tokenizers disagree on the tokens.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gentools/split.h>
+
+namespace
+{
+    struct token_stats
+    {
+        size_t tokens = 0;
+        size_t bytes = 0;
+
+        void add(std::string_view token) noexcept
+        {
+            ++tokens;
+            bytes += token.size();
+        }
+
+        bool operator==(const token_stats&) const = default;
+    };
+
+    template <typename F>
+    token_stats report(const char* name, size_t textSize, F&& tokenize)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const token_stats stats = tokenize();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        std::printf("%-20s %8.2f GB/s %12zu tokens\n", name, textSize / seconds / 1e9, stats.tokens);
+        return stats;
+    }
+}
+
+int main()
+{
+    // fields of 1 to 24 characters
+    std::string text{};
+    text.reserve(size_t{128} << 20);
+    uint32_t state = 12345;
+    while (text.size() < (size_t{128} << 20))
+    {
+        state = state * 1664525 + 1013904223;
+        const size_t length = 1 + (state >> 16) % 24;
+        for (size_t i = 0; i < length; ++i)
+        {
+            text.push_back(static_cast<char>('a' + (i + state) % 26));
+        }
+        text.push_back(',');
+    }
+
+    const auto strings = report("vector<string>", text.size(), [&] {
+        std::vector<std::string> tokens{};
+        size_t start = 0;
+        while (true)
+        {
+            const size_t end = text.find(',', start);
+            tokens.push_back(text.substr(start, end == std::string::npos ? std::string::npos : end - start));
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            start = end + 1;
+        }
+
+        token_stats stats{};
+        for (const auto& token : tokens)
+        {
+            stats.add(token);
+        }
+        return stats;
+    });
+
+    const auto views = report("split", text.size(), [&] {
+        token_stats stats{};
+        for (auto token : gentools::split(text, ','))
+        {
+            stats.add(token);
+        }
+        return stats;
+    });
+
+    const auto batches = report("split_batches", text.size(), [&] {
+        token_stats stats{};
+        for (auto batch : gentools::split_batches(text, ','))
+        {
+            for (const auto& offsets : batch)
+            {
+                stats.add(offsets.in(text));
+            }
+        }
+        return stats;
+    });
+
+    if (!(views == strings && batches == strings))
+    {
+        std::printf("the tokenizers disagree on the tokens\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
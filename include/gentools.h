@@ -1,9 +1,15 @@
+#pragma once
+
 #include <array>
 #include <concepts>
 #include <experimental/coroutine>
 #include <experimental/generator>
+#include <gentools/frame_allocator.h>
+#include <gentools/stats.h>
 #include <iostream>
 #include <functional>
+#include <memory>
+#include <memory_resource>
 #include <optional>
 #include <numeric>
 #include <range/v3/range/primitives.hpp>
@@ -27,7 +33,7 @@
 namespace gentools
 {
     template <typename T>
-    using generator = std::experimental::generator<T>;
+    using generator = std::experimental::generator<T, frame_allocator<char, T>>;
 
     template <typename T>
     using range_value_t = ranges::range_value_t<T>;
@@ -38,74 +44,195 @@ namespace gentools
     template <typename T>
     concept arithmetic = requires { std::is_arithmetic_v<T>; };
 
-    template <ranges::range T>
-    generator<range_value_t<T>> to_generator(T&& range)
+    namespace detail
     {
-        for (auto&& value : range)
+        template <ranges::range T>
+        generator<range_value_t<T>> to_generator(T&& range)
         {
-            co_yield value;
+            detail::stage_probe probe{"to_generator"};
+            for (auto&& value : range)
+            {
+                probe.element_in();
+                co_yield probe.yield(value);
+                probe.resume();
+            }
         }
     }
 
+    template <ranges::range T>
+    generator<range_value_t<T>> to_generator(T&& range)
+    {
+        detail::frame_name_scope name{"to_generator"};
+        return detail::to_generator(std::forward<T>(range));
+    }
+
+    /*
+       Every adaptor has an overload taking std::allocator_arg and a memory resource first, which
+       allocates the coroutine frame, and any internal buffer, from that resource.
+    */
+    template <ranges::range T>
+    generator<range_value_t<T>> to_generator(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& range)
+    {
+        frame_resource_scope scope{resource};
+        return to_generator(std::forward<T>(range));
+    }
+
     template <ranges::range T, invocable F>
     using range_value_invoke_result_t = std::invoke_result_t<F, range_value_t<T>>;
 
+    namespace detail
+    {
+        template <ranges::range T, invocable F>
+        generator<range_value_invoke_result_t<T, F>> transform(T&& range, F&& func)
+        {
+            detail::stage_probe probe{"transform"};
+            for (auto&& value : range)
+            {
+                probe.element_in();
+                co_yield probe.yield(func(value));
+                probe.resume();
+            }
+        }
+    }
+
     template <ranges::range T, invocable F>
     generator<range_value_invoke_result_t<T, F>> transform(T&& range, F&& func)
     {
-        for (auto&& value : range)
+        detail::frame_name_scope name{"transform"};
+        return detail::transform(std::forward<T>(range), std::forward<F>(func));
+    }
+
+    template <ranges::range T, invocable F>
+    generator<range_value_invoke_result_t<T, F>> transform(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                                           T&& range, F&& func)
+    {
+        frame_resource_scope scope{resource};
+        return transform(std::forward<T>(range), std::forward<F>(func));
+    }
+
+    namespace detail
+    {
+        template <arithmetic T>
+        generator<T> count(T&& start, T&& step)
         {
-            co_yield func(value);
+            detail::stage_probe probe{"count"};
+            for (auto value = start;; value = value + step)
+            {
+                co_yield probe.yield(value);
+                probe.resume();
+            }
         }
     }
 
     template <arithmetic T>
     generator<T> count(T&& start = {}, T&& step = T{1})
     {
-        for (auto value = start;; value = value + step)
-        {
-            co_yield value;
-        }
+        detail::frame_name_scope name{"count"};
+        return detail::count(std::forward<T>(start), std::forward<T>(step));
     }
 
-    template <ranges::range T>
-    generator<range_value_t<T>> cycle(T&& range)
+    template <arithmetic T>
+    generator<T> count(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& start = {}, T&& step = T{1})
+    {
+        frame_resource_scope scope{resource};
+        return count(std::forward<T>(start), std::forward<T>(step));
+    }
+
+    namespace detail
     {
-        if (ranges::begin(range) == ranges::end(range))
+        template <ranges::range T>
+        generator<range_value_t<T>> cycle(std::pmr::memory_resource* resource, T&& range)
         {
-            return;
-        }
+            detail::stage_probe probe{"cycle"};
+            if (ranges::begin(range) == ranges::end(range))
+            {
+                co_return;
+            }
 
-        std::vector<range_value_t<T>> values;
-        values.reserve(ranges::size(range));
+            std::pmr::vector<range_value_t<T>> values{resource};
+            values.reserve(ranges::size(range));
+            probe.allocated(values.capacity() * sizeof(range_value_t<T>));
 
-        for (auto&& v : range)
-        {
-            co_yield v;
-            values.push_back(v);
+            for (auto&& v : range)
+            {
+                probe.element_in();
+                co_yield probe.yield(v);
+                probe.resume();
+                values.push_back(v);
+            }
+
+            while (true)
+            {
+                for (auto&& v : values)
+                {
+                    co_yield probe.yield(v);
+                    probe.resume();
+                }
+            }
         }
+    }
+
+    template <ranges::range T>
+    generator<range_value_t<T>> cycle(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& range)
+    {
+        frame_resource_scope scope{resource};
+        detail::frame_name_scope name{"cycle"};
+        return detail::cycle(resource, std::forward<T>(range));
+    }
 
-        while (true)
+    template <ranges::range T>
+    generator<range_value_t<T>> cycle(T&& range)
+    {
+        detail::frame_name_scope name{"cycle"};
+        return detail::cycle(current_frame_resource(), std::forward<T>(range));
+    }
+
+    namespace detail
+    {
+        /* 
+           cycle function specialization for bidirectional ranges. 
+           This implementation doesn't use an auxilliary buffer.
+        */
+        template <ranges::bidirectional_range T>
+        generator<range_value_t<T>> cycle(T&& range)
         {
-            for (auto&& v : values)
+            detail::stage_probe probe{"cycle"};
+            while (true)
             {
-                co_yield v;
+                for (auto&& v : range)
+                {
+                    probe.element_in();
+                    co_yield probe.yield(v);
+                    probe.resume();
+                }
             }
         }
     }
 
-    /* 
-       cycle function specialization for bidirectional ranges. 
-       This implementation doesn't use an auxilliary buffer.
-    */
     template <ranges::bidirectional_range T>
     generator<range_value_t<T>> cycle(T&& range)
     {
-        while (true)
+        detail::frame_name_scope name{"cycle"};
+        return detail::cycle(std::forward<T>(range));
+    }
+
+    template <ranges::bidirectional_range T>
+    generator<range_value_t<T>> cycle(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& range)
+    {
+        frame_resource_scope scope{resource};
+        return cycle(std::forward<T>(range));
+    }
+
+    namespace detail
+    {
+        template <typename T>
+        generator<T> repeat(T&& value)
         {
-            for (auto&& v : range)
+            detail::stage_probe probe{"repeat"};
+            while (true)
             {
-                co_yield v;
+                co_yield probe.yield(value);
+                probe.resume();
             }
         }
     }
@@ -113,43 +240,90 @@ namespace gentools
     template <typename T>
     generator<T> repeat(T&& value)
     {
-        while (true)
+        detail::frame_name_scope name{"repeat"};
+        return detail::repeat(std::forward<T>(value));
+    }
+
+    template <typename T>
+    generator<T> repeat(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& value)
+    {
+        frame_resource_scope scope{resource};
+        return repeat(std::forward<T>(value));
+    }
+
+    namespace detail
+    {
+        template <typename T>
+        generator<T> repeat(T&& value, size_t times)
         {
-            co_yield value;
+            detail::stage_probe probe{"repeat"};
+            for (size_t i = 0; i < times; ++i)
+            {
+                co_yield probe.yield(value);
+                probe.resume();
+            }
         }
     }
 
     template <typename T>
     generator<T> repeat(T&& value, size_t times)
     {
-        for (size_t i = 0; i < times; ++i)
-        {
-            co_yield value;
-        }
+        detail::frame_name_scope name{"repeat"};
+        return detail::repeat(std::forward<T>(value), times);
     }
 
-    template <ranges::range T, invocable F>
-    inline constexpr generator<range_value_t<T>> accumulate(T&& range, F&& func, std::optional<range_value_t<T>> initial)
-        //requires requires { ranges::is_invocable_v<F, range_value_t<T>, range_value_t<T>>; }
+    template <typename T>
+    generator<T> repeat(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& value, size_t times)
     {
-        auto rangeStart = ranges::begin(range);
-        const auto rangeEnd = ranges::end(range);
+        frame_resource_scope scope{resource};
+        return repeat(std::forward<T>(value), times);
+    }
 
-        if (rangeStart != rangeEnd)
+    namespace detail
+    {
+        template <ranges::range T, invocable F>
+        inline constexpr generator<range_value_t<T>> accumulate(T&& range, F&& func, std::optional<range_value_t<T>> initial)
         {
-            range_value_t<T> accum = initial.value_or(*rangeStart);
-            auto rangeIter = initial.has_value() ? rangeStart : ++rangeStart;
+            detail::stage_probe probe{"accumulate"};
+            auto rangeStart = ranges::begin(range);
+            const auto rangeEnd = ranges::end(range);
 
-            for (; rangeIter != rangeEnd; ++rangeIter)
+            if (rangeStart != rangeEnd)
             {
-                co_yield accum;
-                accum = func(accum, *rangeIter);
+                range_value_t<T> accum = initial.value_or(*rangeStart);
+                auto rangeIter = initial.has_value() ? rangeStart : ++rangeStart;
+                probe.element_in(initial.has_value() ? 0 : 1);
+
+                for (; rangeIter != rangeEnd; ++rangeIter)
+                {
+                    co_yield probe.yield(accum);
+                    probe.resume();
+                    probe.element_in();
+                    accum = func(accum, *rangeIter);
+                }
+
+                co_yield probe.yield(accum);
+                probe.resume();
             }
-
-            co_yield accum;
         }
     }
 
+    template <ranges::range T, invocable F>
+    inline constexpr generator<range_value_t<T>> accumulate(T&& range, F&& func, std::optional<range_value_t<T>> initial)
+        //requires requires { ranges::is_invocable_v<F, range_value_t<T>, range_value_t<T>>; }
+    {
+        detail::frame_name_scope name{"accumulate"};
+        return detail::accumulate(std::forward<T>(range), std::forward<F>(func), std::move(initial));
+    }
+
+    template <ranges::range T, invocable F>
+    inline constexpr generator<range_value_t<T>> accumulate(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                                            T&& range, F&& func, std::optional<range_value_t<T>> initial)
+    {
+        frame_resource_scope scope{resource};
+        return accumulate(std::forward<T>(range), std::forward<F>(func), std::move(initial));
+    }
+
     template <ranges::range T>
     inline constexpr generator<range_value_t<T>> accumulate(T&& range)
     {
@@ -157,15 +331,46 @@ namespace gentools
         return accumulate(range, [](auto x, auto y) { return x + y; }, initialValue);
     }
 
+    template <ranges::range T>
+    inline constexpr generator<range_value_t<T>> accumulate(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                                            T&& range)
+    {
+        frame_resource_scope scope{resource};
+        return accumulate(std::forward<T>(range));
+    }
+
+    namespace detail
+    {
+        template <ranges::range DataT, ranges::range SelectorsT>
+        generator<range_value_t<DataT>> compress(DataT&& data, SelectorsT&& selectors)
+            requires ranges::convertible_to<range_value_t<SelectorsT>, bool>
+        {
+            detail::stage_probe probe{"compress"};
+            auto selected = [](auto&& pair) { return static_cast<bool>(pair.second); };
+            for (auto&& [value, _] : ranges::views::zip(data, selectors) | 
+                                     ranges::views::filter(probe.count_in(selected)))
+            {
+                co_yield probe.yield(value);
+                probe.resume();
+            }
+        }
+    }
+
     template <ranges::range DataT, ranges::range SelectorsT>
     generator<range_value_t<DataT>> compress(DataT&& data, SelectorsT&& selectors)
         requires ranges::convertible_to<range_value_t<SelectorsT>, bool>
     {
-        for (auto&& [value, _] : ranges::views::zip(data, selectors) | 
-                                 ranges::views::filter([](auto&& pair) { return static_cast<bool>(pair.second); }))
-        {
-            co_yield value;
-        }
+        detail::frame_name_scope name{"compress"};
+        return detail::compress(std::forward<DataT>(data), std::forward<SelectorsT>(selectors));
+    }
+
+    template <ranges::range DataT, ranges::range SelectorsT>
+    generator<range_value_t<DataT>> compress(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                             DataT&& data, SelectorsT&& selectors)
+        requires ranges::convertible_to<range_value_t<SelectorsT>, bool>
+    {
+        frame_resource_scope scope{resource};
+        return compress(std::forward<DataT>(data), std::forward<SelectorsT>(selectors));
     }
 
     template <int N, typename ... Ts>
@@ -174,28 +379,56 @@ namespace gentools
     template <int N, typename ... Ts>
     using ranges_element_value_t = range_value_t<param_list_element_t<N, Ts...>>;
 
-    // TODO: require the same range_value_t for all input ranges (with concepts)
-    template <ranges::range ... Ts>
-    generator<ranges_element_value_t<0, Ts...>> chain(Ts&& ... ranges)
+    namespace detail
     {
-        using gen_t = generator<ranges_element_value_t<0, Ts...>>;
-        using gen_list_t = std::vector<gen_t>;
-        constexpr size_t rangesSize = std::tuple_size_v<std::tuple<Ts...>>;
+        // The frames of the generators over the input ranges come from frames, or the thread_frame_pool() when null
+        template <ranges::range ... Ts>
+        generator<ranges_element_value_t<0, Ts...>> chain(std::pmr::memory_resource* resource,
+                                                          std::pmr::memory_resource* frames, Ts&& ... ranges)
+        {
+            using gen_t = generator<ranges_element_value_t<0, Ts...>>;
+            using gen_list_t = std::pmr::vector<gen_t>;
+            constexpr size_t rangesSize = std::tuple_size_v<std::tuple<Ts...>>;
 
-        gen_list_t generators;
-        generators.reserve(rangesSize);
+            detail::stage_probe probe{"chain"};
+            gen_list_t generators{resource};
+            generators.reserve(rangesSize);
+            probe.allocated(generators.capacity() * sizeof(gen_t));
 
-        (generators.push_back(std::move(to_generator(ranges))), ...);
+            {
+                frame_resource_scope scope{frames};
+                (generators.push_back(std::move(gentools::to_generator(ranges))), ...);
+            }
 
-        for (auto&& gen : generators)
-        {
-            for (auto&& v : gen)
+            for (auto&& gen : generators)
             {
-                co_yield v;
+                for (auto&& v : gen)
+                {
+                    probe.element_in();
+                    co_yield probe.yield(v);
+                    probe.resume();
+                }
             }
         }
     }
 
+    // TODO: require the same range_value_t for all input ranges (with concepts)
+    template <ranges::range ... Ts>
+    generator<ranges_element_value_t<0, Ts...>> chain(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                                      Ts&& ... ranges)
+    {
+        frame_resource_scope scope{resource};
+        detail::frame_name_scope name{"chain"};
+        return detail::chain(resource, resource, std::forward<Ts>(ranges)...);
+    }
+
+    template <ranges::range ... Ts>
+    generator<ranges_element_value_t<0, Ts...>> chain(Ts&& ... ranges)
+    {
+        detail::frame_name_scope name{"chain"};
+        return detail::chain(current_frame_resource(), detail::thread_frame_resource(), std::forward<Ts>(ranges)...);
+    }
+
     template <typename ... Ts>
     struct typelist {};
 
@@ -223,26 +456,71 @@ namespace gentools
     template <template<typename> typename MetaFunc, typename ... Ts>
     using transform_t = typename transform_impl<MetaFunc, Ts...>::type;
 
+    template <ranges::range ... Ts>
+    using chain_heterogeneous_value_t = rename_t<transform_t<range_value_t, Ts...>, std::variant>;
+
+    namespace detail
+    {
+        // Same as chain, the frames of the nested generators come from frames or the thread_frame_pool()
+        template <ranges::range ... Ts>
+        auto chain_heterogeneous(std::pmr::memory_resource* resource, std::pmr::memory_resource* frames,
+                                 Ts&& ... ranges) -> generator<chain_heterogeneous_value_t<Ts...>>
+        {
+            using gen_value_t = chain_heterogeneous_value_t<Ts...>;
+            using gen_list_t = std::pmr::vector<generator<gen_value_t>>;
+            constexpr size_t rangesSize = std::tuple_size_v<std::tuple<Ts...>>;
+
+            detail::stage_probe probe{"chain_heterogeneous"};
+            gen_list_t generators{resource};
+            generators.reserve(rangesSize);
+            probe.allocated(generators.capacity() * sizeof(generator<gen_value_t>));
+
+            {
+                frame_resource_scope scope{frames};
+                auto rangeValueToVariantFunc = [](auto&& v) { return gen_value_t(v); };
+                (generators.push_back(std::move(gentools::transform(ranges, rangeValueToVariantFunc))), ...);
+            }
+
+            for (auto&& gen : generators)
+            {
+                for (auto&& v : gen)
+                {
+                    probe.element_in();
+                    co_yield probe.yield(v);
+                    probe.resume();
+                }
+            }
+        }
+    }
+
     // TODO: name this just 'chain' like the one above
     template <ranges::range ... Ts>
-    auto chain_heterogeneous(Ts&& ... ranges) -> generator<rename_t<transform_t<range_value_t, Ts...>, std::variant>>
+    auto chain_heterogeneous(std::allocator_arg_t, std::pmr::memory_resource* resource, Ts&& ... ranges)
+        -> generator<chain_heterogeneous_value_t<Ts...>>
     {
-        using ranges_value_type_list_t = transform_t<range_value_t, Ts...>;
-        using gen_value_t = rename_t<ranges_value_type_list_t, std::variant>;
-        using gen_list_t = std::vector<generator<gen_value_t>>;
-        constexpr size_t rangesSize = std::tuple_size_v<std::tuple<Ts...>>;
+        frame_resource_scope scope{resource};
+        detail::frame_name_scope name{"chain_heterogeneous"};
+        return detail::chain_heterogeneous(resource, resource, std::forward<Ts>(ranges)...);
+    }
 
-        gen_list_t generators;
-        generators.reserve(rangesSize);
-        
-        auto rangeValueToVariantFunc = [](auto&& v) { return gen_value_t(v); };
-        (generators.push_back(std::move(transform(ranges, rangeValueToVariantFunc))), ...);
+    template <ranges::range ... Ts>
+    auto chain_heterogeneous(Ts&& ... ranges) -> generator<chain_heterogeneous_value_t<Ts...>>
+    {
+        detail::frame_name_scope name{"chain_heterogeneous"};
+        return detail::chain_heterogeneous(current_frame_resource(), detail::thread_frame_resource(),
+                                           std::forward<Ts>(ranges)...);
+    }
 
-        for (auto&& gen : generators)
+    namespace detail
+    {
+        template <ranges::range T, invocable F>
+        generator<range_value_t<T>> take_while(T&& range, F&& pred)
         {
-            for (auto&& v : gen)
+            detail::stage_probe probe{"take_while"};
+            for (auto&& value : ranges::views::take_while(range, probe.count_in(pred)))
             {
-                co_yield v;
+                co_yield probe.yield(value);
+                probe.resume();
             }
         }
     }
@@ -250,28 +528,72 @@ namespace gentools
     template <ranges::range T, invocable F>
     generator<range_value_t<T>> take_while(T&& range, F&& pred)
     {
-        for (auto&& value : ranges::views::take_while(range, pred))
+        detail::frame_name_scope name{"take_while"};
+        return detail::take_while(std::forward<T>(range), std::forward<F>(pred));
+    }
+
+    template <ranges::range T, invocable F>
+    generator<range_value_t<T>> take_while(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& range, F&& pred)
+    {
+        frame_resource_scope scope{resource};
+        return take_while(std::forward<T>(range), std::forward<F>(pred));
+    }
+
+    namespace detail
+    {
+        template <ranges::range T, invocable F>
+        generator<range_value_t<T>> drop_while(T&& range, F&& pred)
         {
-            co_yield value;
+            detail::stage_probe probe{"drop_while"};
+            for (auto&& value : ranges::views::drop_while(range, probe.count_in_while(pred)))
+            {
+                probe.element_in();
+                co_yield probe.yield(value);
+                probe.resume();
+            }
         }
     }
 
     template <ranges::range T, invocable F>
     generator<range_value_t<T>> drop_while(T&& range, F&& pred)
     {
-        for (auto&& value : ranges::views::drop_while(range, pred))
+        detail::frame_name_scope name{"drop_while"};
+        return detail::drop_while(std::forward<T>(range), std::forward<F>(pred));
+    }
+
+    template <ranges::range T, invocable F>
+    generator<range_value_t<T>> drop_while(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& range, F&& pred)
+    {
+        frame_resource_scope scope{resource};
+        return drop_while(std::forward<T>(range), std::forward<F>(pred));
+    }
+
+    namespace detail
+    {
+        template <ranges::range T, invocable F>
+        generator<range_value_t<T>> filter(T&& range, F&& pred)
         {
-            co_yield value;
+            detail::stage_probe probe{"filter"};
+            for (auto&& value : ranges::views::filter(range, probe.count_in(pred)))
+            {
+                co_yield probe.yield(value);
+                probe.resume();
+            }
         }
     }
 
     template <ranges::range T, invocable F>
     generator<range_value_t<T>> filter(T&& range, F&& pred)
     {
-        for (auto&& value : ranges::views::filter(range, pred))
-        {
-            co_yield value;
-        }
+        detail::frame_name_scope name{"filter"};
+        return detail::filter(std::forward<T>(range), std::forward<F>(pred));
+    }
+
+    template <ranges::range T, invocable F>
+    generator<range_value_t<T>> filter(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& range, F&& pred)
+    {
+        frame_resource_scope scope{resource};
+        return filter(std::forward<T>(range), std::forward<F>(pred));
     }
 
     template <ranges::range T, invocable F>
@@ -289,43 +611,89 @@ namespace gentools
         }
     };
 
+    namespace detail
+    {
+        template <ranges::range T, invocable F>
+        generator<group_t<T, F>> group_by(T&& range, F&& keyFunc)
+        {
+            detail::stage_probe probe{"group_by"};
+            auto iter = ranges::begin(range);
+            const auto rangeEnd = ranges::end(range);
+            if (iter == rangeEnd)
+            {
+                return;
+            }
+
+            auto groupStartIter = iter;
+            auto currentKey = keyFunc(*iter);
+            probe.element_in();
+
+            while ((++iter) != rangeEnd)
+            {
+                probe.element_in();
+                const auto newKey = keyFunc(*iter);
+                if (newKey != currentKey)
+                {
+                    co_yield probe.yield(std::make_pair(currentKey, ranges::make_subrange(groupStartIter, iter)));
+                    probe.resume();
+                
+                    currentKey = newKey;
+                    groupStartIter = iter;
+                }
+            }
+
+            co_yield probe.yield(std::make_pair(currentKey, ranges::make_subrange(groupStartIter, iter)));
+            probe.resume();
+        }
+    }
+
     // Input range should be already ordered by the key
     template <ranges::range T, invocable F>
     generator<group_t<T, F>> group_by(T&& range, F&& keyFunc = Identity<T>{})
     {
-        auto iter = ranges::begin(range);
-        const auto rangeEnd = ranges::end(range);
-        if (iter == rangeEnd)
-        {
-            return;
-        }
+        detail::frame_name_scope name{"group_by"};
+        return detail::group_by(std::forward<T>(range), std::forward<F>(keyFunc));
+    }
 
-        auto groupStartIter = iter;
-        auto currentKey = keyFunc(*iter);
+    template <ranges::range T, invocable F>
+    generator<group_t<T, F>> group_by(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                      T&& range, F&& keyFunc = Identity<T>{})
+    {
+        frame_resource_scope scope{resource};
+        return group_by(std::forward<T>(range), std::forward<F>(keyFunc));
+    }
 
-        while ((++iter) != rangeEnd)
+    namespace detail
+    {
+        template <ranges::range T, invocable F>
+        generator<range_value_invoke_result_t<T, F>> star_transform(T&& range, F&& func)
+            requires ranges::is_invocable_v<F, range_value_t<T>>
         {
-            const auto newKey = keyFunc(*iter);
-            if (newKey != currentKey)
+            detail::stage_probe probe{"star_transform"};
+            for (auto&& value : range)
             {
-                co_yield std::make_pair(currentKey, ranges::make_subrange(groupStartIter, iter));
-                
-                currentKey = newKey;
-                groupStartIter = iter;
+                probe.element_in();
+                co_yield probe.yield(func(value));
+                probe.resume();
             }
         }
-
-        co_yield std::make_pair(currentKey, ranges::make_subrange(groupStartIter, iter));
     }
 
     template <ranges::range T, invocable F>
     generator<range_value_invoke_result_t<T, F>> star_transform(T&& range, F&& func)
         requires ranges::is_invocable_v<F, range_value_t<T>>
     {
-        for (auto&& value : range)
-        {
-            co_yield func(value);
-        }
+        detail::frame_name_scope name{"star_transform"};
+        return detail::star_transform(std::forward<T>(range), std::forward<F>(func));
+    }
+
+    template <ranges::range T, invocable F>
+    generator<range_value_invoke_result_t<T, F>> star_transform(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                                                T&& range, F&& func)
+        requires ranges::is_invocable_v<F, range_value_t<T>>
+    {
+        frame_resource_scope scope{resource};
+        return star_transform(std::forward<T>(range), std::forward<F>(func));
     }
 
 } //namespace gentools
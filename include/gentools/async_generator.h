@@ -0,0 +1,268 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <exception>
+#include <gentools.h>
+#include <gentools/task.h>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace gentools
+{
+    template <typename T>
+    class async_generator;
+
+    namespace detail
+    {
+        template <typename T>
+        class async_generator_promise : public frame_allocated<T>
+        {
+        public:
+            // Suspends the producer and resumes the consumer waiting for the next element
+            struct yield_awaiter
+            {
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                coroutine_handle<> await_suspend(coroutine_handle<async_generator_promise> handle) noexcept
+                {
+                    return handle.promise().mConsumer;
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            async_generator<T> get_return_object() noexcept;
+
+            suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            yield_awaiter final_suspend() noexcept
+            {
+                mValue = nullptr;
+                return {};
+            }
+
+            // The element lives in the producer frame, or is a temporary of the co_yield
+            // expression, until the producer is resumed
+            yield_awaiter yield_value(const T& value) noexcept
+            {
+                mValue = std::addressof(value);
+                return {};
+            }
+
+            void unhandled_exception() noexcept
+            {
+                mException = std::current_exception();
+            }
+
+            void return_void() noexcept {}
+
+            void set_consumer(coroutine_handle<> consumer) noexcept
+            {
+                mConsumer = consumer;
+            }
+
+            const T* value() const
+            {
+                if (mException)
+                {
+                    std::rethrow_exception(mException);
+                }
+                return mValue;
+            }
+
+        private:
+            coroutine_handle<> mConsumer{};
+            const T* mValue = nullptr;
+            std::exception_ptr mException;
+        };
+    }
+
+    /*
+       Generator whose body may co_await, for sources and stages that wait on I/O or timers.
+       Its consumer, another coroutine, pulls each element with
+
+           while (const T* value = co_await gen.next())
+
+       which runs the producer until its next co_yield; when the producer co_awaits something that
+       suspends, such as an event_loop awaitable, the consumer stays suspended too and the thread
+       goes back to the event loop, which runs other tasks until the awaited event happens.
+       The pointer is valid until the next call to next(), which returns nullptr once the
+       producer is done and rethrows the exception it failed with, if any.
+    */
+    template <typename T>
+    class [[nodiscard]] async_generator
+    {
+    public:
+        using promise_type = detail::async_generator_promise<T>;
+        using handle_type = detail::coroutine_handle<promise_type>;
+        using value_type = T;
+
+        async_generator() noexcept = default;
+
+        explicit async_generator(handle_type handle) noexcept
+            : mHandle(handle)
+        {
+        }
+
+        async_generator(async_generator&& other) noexcept
+            : mHandle(std::exchange(other.mHandle, nullptr))
+        {
+        }
+
+        async_generator& operator=(async_generator&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (mHandle)
+                {
+                    mHandle.destroy();
+                }
+                mHandle = std::exchange(other.mHandle, nullptr);
+            }
+            return *this;
+        }
+
+        ~async_generator()
+        {
+            if (mHandle)
+            {
+                mHandle.destroy();
+            }
+        }
+
+        auto next() noexcept
+        {
+            struct awaiter
+            {
+                handle_type handle;
+
+                bool await_ready() noexcept
+                {
+                    return !handle || handle.done();
+                }
+
+                detail::coroutine_handle<> await_suspend(detail::coroutine_handle<> consumer) noexcept
+                {
+                    handle.promise().set_consumer(consumer);
+                    return handle;
+                }
+
+                const T* await_resume()
+                {
+                    return handle ? handle.promise().value() : nullptr;
+                }
+            };
+
+            return awaiter{mHandle};
+        }
+
+    private:
+        handle_type mHandle{};
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        async_generator<T> async_generator_promise<T>::get_return_object() noexcept
+        {
+            return async_generator<T>{async_generator<T>::handle_type::from_promise(*this)};
+        }
+
+        // Result of func for an element, with the task unwrapped when func is asynchronous
+        template <typename F, typename T>
+        struct async_invoke_result
+        {
+            using type = std::invoke_result_t<F&, const T&>;
+        };
+
+        template <typename F, typename T>
+            requires is_task_v<std::invoke_result_t<F&, const T&>>
+        struct async_invoke_result<F, T>
+        {
+            using type = typename std::invoke_result_t<F&, const T&>::value_type;
+        };
+
+        template <typename F, typename T>
+        using async_invoke_result_t = std::remove_cvref_t<typename async_invoke_result<F, T>::type>;
+    }
+
+    /*
+       The async adaptors take their sources and functions by value: an async pipeline outlives
+       the expression that builds it, since its stages run whenever their I/O completes.
+       func and pred may be asynchronous themselves, returning a task that is awaited for each
+       element. They are not instrumented by stats.h, whose stage probes assume stages resume
+       each other in nested order.
+    */
+
+    // Lifts a synchronous range into an async pipeline
+    template <ranges::range T>
+    async_generator<range_value_t<T>> to_async(T range)
+    {
+        for (auto&& value : range)
+        {
+            co_yield value;
+        }
+    }
+
+    template <typename T, typename F>
+    async_generator<detail::async_invoke_result_t<F, T>> async_transform(async_generator<T> source, F func)
+    {
+        while (const T* value = co_await source.next())
+        {
+            if constexpr (is_task_v<std::invoke_result_t<F&, const T&>>)
+            {
+                co_yield co_await func(*value);
+            }
+            else
+            {
+                co_yield func(*value);
+            }
+        }
+    }
+
+    template <typename T, typename F>
+    async_generator<T> async_filter(async_generator<T> source, F pred)
+    {
+        while (const T* value = co_await source.next())
+        {
+            bool selected = false;
+            if constexpr (is_task_v<std::invoke_result_t<F&, const T&>>)
+            {
+                selected = co_await pred(*value);
+            }
+            else
+            {
+                selected = pred(*value);
+            }
+
+            if (selected)
+            {
+                co_yield *value;
+            }
+        }
+    }
+
+    // Yields the elements of every source, one source after the other
+    template <typename T, typename ... Ts>
+        requires (std::same_as<T, Ts> && ...)
+    async_generator<T> async_chain(async_generator<T> first, async_generator<Ts> ... rest)
+    {
+        std::array<async_generator<T>, 1 + sizeof...(Ts)> sources{std::move(first), std::move(rest)...};
+        for (auto& source : sources)
+        {
+            while (const T* value = co_await source.next())
+            {
+                co_yield *value;
+            }
+        }
+    }
+
+} //namespace gentools
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define GENTOOLS_SCANNER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define GENTOOLS_SCANNER_SSE2 1
+#endif
+
+namespace gentools
+{
+    namespace detail
+    {
+        /*
+           Finds the occurrences of a small set of characters in a buffer 64 bytes at a time: each
+           block is compared against every character of the set with SIMD instructions into a 64
+           bit mask, whose set bits are then consumed one by one, so frequent matches cost a few
+           instructions each instead of a call to memchr each.
+        */
+        class char_scanner
+        {
+        public:
+            static constexpr size_t block_size = 64;
+            static constexpr size_t max_chars = 8;
+
+            char_scanner(const char* first, const char* last, std::string_view chars)
+                : mBlock(first)
+                , mLast(last)
+                , mCount(chars.size())
+            {
+                if (chars.empty() || chars.size() > max_chars)
+                {
+                    throw std::invalid_argument("char_scanner: between 1 and 8 characters to search for");
+                }
+                std::memcpy(mChars.data(), chars.data(), chars.size());
+                mMask = first != last ? block_mask(first) : 0;
+            }
+
+            // Position of the next occurrence, or nullptr when there are none left
+            const char* next() noexcept
+            {
+                while (mMask == 0)
+                {
+                    if (static_cast<size_t>(mLast - mBlock) <= block_size)
+                    {
+                        return nullptr;
+                    }
+                    mBlock += block_size;
+                    mMask = block_mask(mBlock);
+                }
+
+                const char* match = mBlock + std::countr_zero(mMask);
+                mMask &= mMask - 1;
+                return match;
+            }
+
+            // Skips the occurrences before position
+            void skip_to(const char* position) noexcept
+            {
+                while (position > mBlock && static_cast<size_t>(position - mBlock) >= block_size &&
+                       static_cast<size_t>(mLast - mBlock) > block_size)
+                {
+                    mBlock += block_size;
+                    mMask = block_mask(mBlock);
+                }
+
+                if (position > mBlock)
+                {
+                    const auto skipped = static_cast<size_t>(position - mBlock);
+                    mMask &= skipped >= block_size ? 0 : ~uint64_t{0} << skipped;
+                }
+            }
+
+        private:
+            uint64_t block_mask(const char* block) const noexcept
+            {
+                if (static_cast<size_t>(mLast - block) < block_size)
+                {
+                    // the tail is copied so the vector loads never read past the buffer; the
+                    // padding bytes may match and are masked out
+                    const auto length = static_cast<size_t>(mLast - block);
+                    char tail[block_size] = {};
+                    std::memcpy(tail, block, length);
+                    return full_block_mask(tail) & ((uint64_t{1} << length) - 1);
+                }
+                return full_block_mask(block);
+            }
+
+            uint64_t full_block_mask(const char* block) const noexcept
+            {
+#if defined(GENTOOLS_SCANNER_AVX2)
+                const auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+                const auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+                auto lowMatches = _mm256_setzero_si256();
+                auto highMatches = _mm256_setzero_si256();
+                for (size_t i = 0; i < mCount; ++i)
+                {
+                    const auto c = _mm256_set1_epi8(mChars[i]);
+                    lowMatches = _mm256_or_si256(lowMatches, _mm256_cmpeq_epi8(low, c));
+                    highMatches = _mm256_or_si256(highMatches, _mm256_cmpeq_epi8(high, c));
+                }
+                const auto lowMask = static_cast<uint32_t>(_mm256_movemask_epi8(lowMatches));
+                const auto highMask = static_cast<uint32_t>(_mm256_movemask_epi8(highMatches));
+                return lowMask | (static_cast<uint64_t>(highMask) << 32);
+#elif defined(GENTOOLS_SCANNER_SSE2)
+                __m128i bytes[4];
+                __m128i matches[4];
+                for (size_t j = 0; j < 4; ++j)
+                {
+                    bytes[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * j));
+                    matches[j] = _mm_setzero_si128();
+                }
+                for (size_t i = 0; i < mCount; ++i)
+                {
+                    const auto c = _mm_set1_epi8(mChars[i]);
+                    for (size_t j = 0; j < 4; ++j)
+                    {
+                        matches[j] = _mm_or_si128(matches[j], _mm_cmpeq_epi8(bytes[j], c));
+                    }
+                }
+
+                uint64_t mask = 0;
+                for (size_t j = 0; j < 4; ++j)
+                {
+                    mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(matches[j]))) << (16 * j);
+                }
+                return mask;
+#else
+                // simple enough for the compiler to vectorize
+                uint64_t mask = 0;
+                for (size_t i = 0; i < mCount; ++i)
+                {
+                    for (size_t j = 0; j < block_size; ++j)
+                    {
+                        mask |= static_cast<uint64_t>(block[j] == mChars[i]) << j;
+                    }
+                }
+                return mask;
+#endif
+            }
+
+            const char* mBlock;
+            const char* mLast;
+            std::array<char, max_chars> mChars{};
+            size_t mCount;
+            uint64_t mMask = 0;
+        };
+    }
+
+} //namespace gentools
@@ -0,0 +1,657 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <gentools.h>
+#include <gentools/char_scanner.h>
+#include <gentools/lines.h>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gentools
+{
+    struct csv_options
+    {
+        char delimiter = ',';
+        char quote = '"';
+        // true to drop the first record
+        bool skip_header = false;
+        // a record carried across chunks longer than this throws, such as the rest of the input
+        // after an unterminated quote
+        size_t max_record_bytes = size_t{64} << 20;
+    };
+
+    namespace detail
+    {
+        // The fields of the record being parsed
+        class csv_record
+        {
+        public:
+            // Adds the raw field [first, last), without its quotes and with its doubled quotes unescaped
+            void add(const char* first, const char* last, bool quoted, bool escaped, char quote)
+            {
+                if (quoted && last - first >= 2 && *(last - 1) == quote)
+                {
+                    ++first;
+                    --last;
+                }
+
+                if (!escaped)
+                {
+                    mFields.emplace_back(first, static_cast<size_t>(last - first));
+                    return;
+                }
+
+                // the unescaped field is a view into the scratch buffer, resolved by fields() once
+                // the buffer stops growing
+                const size_t offset = mScratch.size();
+                for (const char* c = first; c != last; ++c)
+                {
+                    mScratch.push_back(*c);
+                    if (*c == quote && c + 1 != last && *(c + 1) == quote)
+                    {
+                        ++c;
+                    }
+                }
+                mEscaped.push_back({mFields.size(), offset});
+                mFields.emplace_back(nullptr, mScratch.size() - offset);
+            }
+
+            std::span<const std::string_view> fields() noexcept
+            {
+                for (const auto& [field, offset] : mEscaped)
+                {
+                    mFields[field] = {mScratch.data() + offset, mFields[field].size()};
+                }
+                mEscaped.clear();
+                return mFields;
+            }
+
+            void clear() noexcept
+            {
+                mFields.clear();
+                mScratch.clear();
+                mEscaped.clear();
+            }
+
+        private:
+            std::vector<std::string_view> mFields{};
+            std::string mScratch{};
+            std::vector<std::pair<size_t, size_t>> mEscaped{};
+        };
+
+        // Quoting state of a csv_scanner within the record it stopped in, relative to the record start
+        struct csv_scan_state
+        {
+            size_t field_start = 0;
+            bool in_quotes = false;
+            bool quoted = false;
+            bool escaped = false;
+            bool skip_blank_lines = true;
+        };
+
+        /*
+           Splits a buffer into records: the delimiters, quotes and newlines are found by a
+           char_scanner, and only those positions go through the quoting state machine.
+        */
+        class csv_scanner
+        {
+        public:
+            csv_scanner(const char* first, const char* last, const csv_options& options, const csv_scan_state& state = {})
+                : csv_scanner(first, last, options, state, 0)
+            {
+            }
+
+            /*
+               Resumes scanning a record starting at first, whose first scanned bytes were already
+               scanned by a scanner that stopped in state, possibly on a shorter copy of the record.
+            */
+            csv_scanner(const char* first, const char* last, const csv_options& options, const csv_scan_state& state,
+                        size_t scanned)
+                : mScanner(first + scanned, last,
+                           std::string_view{std::array{options.delimiter, options.quote, '\n'}.data(), 3})
+                , mRecordStart(first)
+                , mFieldStart(first + state.field_start)
+                , mLast(last)
+                , mDelimiter(options.delimiter)
+                , mQuote(options.quote)
+                , mInQuotes(state.in_quotes)
+                , mQuoted(state.quoted)
+                , mEscaped(state.escaped)
+                , mSkipBlankLines(state.skip_blank_lines)
+            {
+            }
+
+            /*
+               Parses the next record into record and returns true, or returns false when the rest
+               of the buffer holds no complete record. When final, the rest of the buffer is the
+               last record even without a newline. Blank lines are skipped, until keep_blank_lines().
+            */
+            bool next(csv_record& record, bool final)
+            {
+                while (const char* found = mScanner.next())
+                {
+                    const char c = *found;
+                    if (mInQuotes)
+                    {
+                        mInQuotes = c != mQuote;
+                    }
+                    else if (c == mQuote)
+                    {
+                        if (found == mFieldStart)
+                        {
+                            mInQuotes = mQuoted = true;
+                        }
+                        else if (mQuoted && *(found - 1) == mQuote)
+                        {
+                            // a doubled quote within a quoted field; a quote within an unquoted
+                            // field is kept as is
+                            mInQuotes = mEscaped = true;
+                        }
+                    }
+                    else if (c == mDelimiter)
+                    {
+                        add_field(record, found);
+                        mFieldStart = found + 1;
+                    }
+                    else if (mSkipBlankLines && found - mRecordStart <= 1 &&
+                             (found == mRecordStart || *mRecordStart == '\r'))
+                    {
+                        record.clear();
+                        start_record(found + 1);
+                    }
+                    else
+                    {
+                        add_field(record, found != mFieldStart && *(found - 1) == '\r' ? found - 1 : found);
+                        start_record(found + 1);
+                        return true;
+                    }
+                }
+
+                if (!final || mRecordStart == mLast || (mLast - mRecordStart == 1 && *mRecordStart == '\r'))
+                {
+                    return false;
+                }
+                if (mInQuotes)
+                {
+                    throw std::runtime_error("csv: unterminated quoted field");
+                }
+                add_field(record, mLast != mFieldStart && *(mLast - 1) == '\r' ? mLast - 1 : mLast);
+                start_record(mLast);
+                return true;
+            }
+
+            // Start of the record being parsed when next() returned false
+            const char* record_start() const noexcept
+            {
+                return mRecordStart;
+            }
+
+            // State to resume scanning the record being parsed when next() returned false
+            csv_scan_state state() const noexcept
+            {
+                return {static_cast<size_t>(mFieldStart - mRecordStart), mInQuotes, mQuoted, mEscaped, mSkipBlankLines};
+            }
+
+            // Parses blank lines as records with a single empty field
+            void keep_blank_lines() noexcept
+            {
+                mSkipBlankLines = false;
+            }
+
+        private:
+            void add_field(csv_record& record, const char* fieldEnd)
+            {
+                record.add(mFieldStart, fieldEnd, mQuoted, mEscaped, mQuote);
+                mQuoted = mEscaped = false;
+            }
+
+            void start_record(const char* recordStart) noexcept
+            {
+                mRecordStart = mFieldStart = recordStart;
+                mQuoted = mEscaped = false;
+            }
+
+            char_scanner mScanner;
+            const char* mRecordStart;
+            const char* mFieldStart;
+            const char* mLast;
+            const char mDelimiter;
+            const char mQuote;
+            bool mInQuotes;
+            bool mQuoted;
+            bool mEscaped;
+            bool mSkipBlankLines;
+        };
+    }
+
+    /*
+       Parses CSV text and yields the fields of each record. Fields may be quoted, with doubled
+       quotes standing for a quote, and contain delimiters and newlines; records end with "\n" or
+       "\r\n". Blank lines are skipped, unless the first record has a single field: then a blank
+       line is a record with one empty field. The fields are views into text, except the ones with
+       doubled quotes which are unescaped into a buffer the generator reuses; they are valid until
+       the next record is requested.
+    */
+    inline generator<std::span<const std::string_view>> csv_rows(std::string_view text, csv_options options = {})
+    {
+        detail::stage_probe probe{"csv_rows"};
+        detail::csv_record record{};
+        bool skipHeader = options.skip_header;
+        bool firstRecord = true;
+
+        detail::csv_scanner scanner{text.data(), text.data() + text.size(), options};
+        while (scanner.next(record, true))
+        {
+            probe.element_in();
+            if (std::exchange(firstRecord, false) && record.fields().size() == 1)
+            {
+                scanner.keep_blank_lines();
+            }
+            if (!std::exchange(skipHeader, false))
+            {
+                co_yield probe.yield(record.fields());
+                probe.resume();
+            }
+            record.clear();
+        }
+    }
+
+    namespace detail
+    {
+        // Takes T by value when csv_rows is given an rvalue, so an upstream generator lives in this frame
+        template <ranges::range T>
+        generator<std::span<const std::string_view>> csv_rows(T chunks, csv_options options)
+        {
+            detail::stage_probe probe{"csv_rows"};
+            detail::csv_record record{};
+            // fields of the partial scans of a carried record, which are thrown away
+            detail::csv_record partial{};
+            bool skipHeader = options.skip_header;
+            bool firstRecord = true;
+            // state every record starts in, which keeps blank lines once the first record has a single field
+            detail::csv_scan_state fresh{};
+
+            // the start of a record whose end is in a later chunk, and the state its scan stopped in
+            std::string carry{};
+            detail::csv_scan_state carryState{};
+            size_t carryScanned = 0;
+
+            auto check_carry = [&carry, &options]
+            {
+                if (carry.size() > options.max_record_bytes)
+                {
+                    throw std::runtime_error("csv: a record is longer than max_record_bytes");
+                }
+            };
+            auto track_first_record = [&firstRecord, &fresh, &record](detail::csv_scanner& scanner)
+            {
+                if (std::exchange(firstRecord, false) && record.fields().size() == 1)
+                {
+                    scanner.keep_blank_lines();
+                    fresh.skip_blank_lines = false;
+                }
+            };
+
+            for (auto&& chunk : chunks)
+            {
+                const auto text = detail::as_text(chunk);
+                const char* first = text.data();
+                const char* last = text.data() + text.size();
+
+                // the carried record is extended one line at a time and only the new line is
+                // scanned, resuming from the state the previous lines left; the record is parsed
+                // from its start once, when a line ends it
+                while (!carry.empty() && first != last)
+                {
+                    const char* newline = static_cast<const char*>(std::memchr(first, '\n', last - first));
+                    const char* lineEnd = newline != nullptr ? newline + 1 : last;
+                    carry.append(first, lineEnd);
+                    first = lineEnd;
+                    check_carry();
+                    if (newline == nullptr)
+                    {
+                        break;
+                    }
+
+                    detail::csv_scanner carried{carry.data(), carry.data() + carry.size(), options, carryState,
+                                                carryScanned};
+                    const bool ended = carried.next(partial, false);
+                    partial.clear();
+                    if (!ended)
+                    {
+                        // still open, or a blank line that was skipped
+                        carry.erase(0, carried.record_start() - carry.data());
+                        carryState = carried.state();
+                        carryScanned = carry.size();
+                        continue;
+                    }
+
+                    // the only newline scanned ends the record, so it spans the whole carry
+                    detail::csv_scanner whole{carry.data(), carry.data() + carry.size(), options, fresh};
+                    if (whole.next(record, false))
+                    {
+                        probe.element_in();
+                        track_first_record(whole);
+                        if (!std::exchange(skipHeader, false))
+                        {
+                            co_yield probe.yield(record.fields());
+                            probe.resume();
+                        }
+                    }
+                    record.clear();
+                    carry.clear();
+                }
+                if (!carry.empty())
+                {
+                    continue;
+                }
+
+                detail::csv_scanner scanner{first, last, options, fresh};
+                while (scanner.next(record, false))
+                {
+                    probe.element_in();
+                    track_first_record(scanner);
+                    if (!std::exchange(skipHeader, false))
+                    {
+                        co_yield probe.yield(record.fields());
+                        probe.resume();
+                    }
+                    record.clear();
+                }
+                record.clear();
+
+                carry.assign(scanner.record_start(), last);
+                carryState = scanner.state();
+                carryScanned = carry.size();
+                check_carry();
+            }
+
+            detail::csv_scanner carried{carry.data(), carry.data() + carry.size(), options, fresh};
+            if (carried.next(record, true))
+            {
+                probe.element_in();
+                if (!std::exchange(skipHeader, false))
+                {
+                    co_yield probe.yield(record.fields());
+                    probe.resume();
+                }
+            }
+        }
+    }
+
+    /*
+       Same as above over a range of text chunks, such as file_chunks() or mapped_array::chunks().
+       Fields within a chunk are views into it; only a record straddling chunk boundaries is
+       copied, into a buffer the generator reuses, and one longer than options.max_record_bytes
+       throws std::runtime_error. Rvalue ranges, such as generators, are moved into the
+       generator; lvalue ranges are referenced.
+    */
+    template <ranges::range T>
+        requires detail::text_chunk<range_value_t<T>>
+    generator<std::span<const std::string_view>> csv_rows(T&& chunks, csv_options options = {})
+    {
+        return detail::csv_rows<T>(std::forward<T>(chunks), options);
+    }
+
+    enum class csv_type
+    {
+        int64,
+        float64,
+        string
+    };
+
+    namespace detail
+    {
+        class csv_batch_builder;
+    }
+
+    /*
+       Rows of CSV in columns, one array per column of the type given by the schema. The strings
+       are views into a buffer of the batch. A batch, and everything it refers to, is valid until
+       the next one is requested.
+    */
+    class csv_batch
+    {
+    public:
+        size_t size() const noexcept
+        {
+            return mRows;
+        }
+
+        size_t columns() const noexcept
+        {
+            return mColumns.size();
+        }
+
+        csv_type type(size_t column) const
+        {
+            return mColumns.at(column).type;
+        }
+
+        std::span<const int64_t> int64s(size_t column) const
+        {
+            return typed(column, csv_type::int64).int64s;
+        }
+
+        std::span<const double> float64s(size_t column) const
+        {
+            return typed(column, csv_type::float64).float64s;
+        }
+
+        std::span<const std::string_view> strings(size_t column) const
+        {
+            return typed(column, csv_type::string).strings;
+        }
+
+    private:
+        friend class detail::csv_batch_builder;
+
+        struct column
+        {
+            csv_type type;
+            std::pmr::vector<int64_t> int64s;
+            std::pmr::vector<double> float64s;
+            std::pmr::vector<std::string_view> strings;
+            // offset of each string in the text buffer, until it stops growing
+            std::pmr::vector<size_t> offsets;
+        };
+
+        explicit csv_batch(std::pmr::memory_resource* resource)
+            : mText(resource)
+            , mColumns(resource)
+        {
+        }
+
+        const column& typed(size_t column, csv_type type) const
+        {
+            const auto& found = mColumns.at(column);
+            if (found.type != type)
+            {
+                throw std::invalid_argument("csv_batch: the column has another type");
+            }
+            return found;
+        }
+
+        size_t mRows = 0;
+        std::pmr::string mText;
+        std::pmr::vector<column> mColumns;
+    };
+
+    namespace detail
+    {
+        // Fills a csv_batch record by record, parsing the numbers with std::from_chars
+        class csv_batch_builder
+        {
+        public:
+            csv_batch_builder(std::pmr::memory_resource* resource, const std::vector<csv_type>& schema,
+                              size_t capacity)
+                : mBatch(resource)
+            {
+                mBatch.mColumns.reserve(schema.size());
+                for (auto type : schema)
+                {
+                    auto& added = mBatch.mColumns.emplace_back(
+                        csv_batch::column{type, std::pmr::vector<int64_t>{resource}, std::pmr::vector<double>{resource},
+                                          std::pmr::vector<std::string_view>{resource},
+                                          std::pmr::vector<size_t>{resource}});
+                    switch (type)
+                    {
+                    case csv_type::int64:
+                        added.int64s.reserve(capacity);
+                        break;
+                    case csv_type::float64:
+                        added.float64s.reserve(capacity);
+                        break;
+                    case csv_type::string:
+                        added.strings.reserve(capacity);
+                        added.offsets.reserve(capacity);
+                        break;
+                    }
+                }
+            }
+
+            size_t size() const noexcept
+            {
+                return mBatch.mRows;
+            }
+
+            void add(std::span<const std::string_view> fields)
+            {
+                auto& columns = mBatch.mColumns;
+                if (fields.size() != columns.size())
+                {
+                    throw std::runtime_error("csv: a record has " + std::to_string(fields.size()) +
+                                             " fields instead of " + std::to_string(columns.size()));
+                }
+
+                for (size_t i = 0; i < fields.size(); ++i)
+                {
+                    auto& column = columns[i];
+                    switch (column.type)
+                    {
+                    case csv_type::int64:
+                        column.int64s.push_back(parse<int64_t>(fields[i], i));
+                        break;
+                    case csv_type::float64:
+                        column.float64s.push_back(parse<double>(fields[i], i));
+                        break;
+                    case csv_type::string:
+                        column.offsets.push_back(mBatch.mText.size());
+                        column.strings.emplace_back(nullptr, fields[i].size());
+                        mBatch.mText.append(fields[i]);
+                        break;
+                    }
+                }
+                ++mBatch.mRows;
+            }
+
+            // Points the strings into the text buffer, which no longer grows, and returns the batch
+            const csv_batch& seal() noexcept
+            {
+                for (auto& column : mBatch.mColumns)
+                {
+                    for (size_t i = 0; i < column.strings.size(); ++i)
+                    {
+                        column.strings[i] = {mBatch.mText.data() + column.offsets[i], column.strings[i].size()};
+                    }
+                }
+                return mBatch;
+            }
+
+            void clear() noexcept
+            {
+                mBatch.mRows = 0;
+                mBatch.mText.clear();
+                for (auto& column : mBatch.mColumns)
+                {
+                    column.int64s.clear();
+                    column.float64s.clear();
+                    column.strings.clear();
+                    column.offsets.clear();
+                }
+            }
+
+        private:
+            template <typename V>
+            static V parse(std::string_view field, size_t column)
+            {
+                V value{};
+                const char* last = field.data() + field.size();
+                const auto [end, error] = std::from_chars(field.data(), last, value);
+                if (field.empty() || error != std::errc{} || end != last)
+                {
+                    throw std::runtime_error("csv: invalid number \"" + std::string{field} + "\" in column " +
+                                             std::to_string(column));
+                }
+                return value;
+            }
+
+            csv_batch mBatch;
+        };
+
+        template <typename Rows>
+        generator<csv_batch> csv_columns(std::pmr::memory_resource* resource, Rows rows,
+                                         std::vector<csv_type> schema, size_t batchSize)
+        {
+            detail::stage_probe probe{"csv_columns"};
+            batchSize = batchSize > 0 ? batchSize : 1;
+            csv_batch_builder builder{resource, schema, batchSize};
+
+            for (auto fields : rows)
+            {
+                probe.element_in();
+                builder.add(fields);
+                if (builder.size() == batchSize)
+                {
+                    co_yield probe.yield(builder.seal());
+                    probe.resume();
+                    builder.clear();
+                }
+            }
+
+            if (builder.size() > 0)
+            {
+                co_yield probe.yield(builder.seal());
+                probe.resume();
+            }
+        }
+    }
+
+    /*
+       Parses CSV like csv_rows into batches of up to batchSize records, with a column per entry
+       of schema. Numbers are parsed with std::from_chars: an empty or malformed number, or a
+       record without one field per column, throws std::runtime_error. The buffers of the batch
+       are allocated once and reused, so a batch allocates nothing per field.
+    */
+    template <typename T>
+        requires std::is_convertible_v<T, std::string_view> || detail::text_chunk<range_value_t<T>>
+    generator<csv_batch> csv_columns(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& text,
+                                     std::vector<csv_type> schema, csv_options options = {},
+                                     size_t batchSize = 1024)
+    {
+        frame_resource_scope scope{resource};
+        return detail::csv_columns(resource, csv_rows(std::forward<T>(text), options), std::move(schema), batchSize);
+    }
+
+    template <typename T>
+        requires std::is_convertible_v<T, std::string_view> || detail::text_chunk<range_value_t<T>>
+    generator<csv_batch> csv_columns(T&& text, std::vector<csv_type> schema, csv_options options = {},
+                                     size_t batchSize = 1024)
+    {
+        return detail::csv_columns(current_frame_resource(), csv_rows(std::forward<T>(text), options), std::move(schema),
+                                   batchSize);
+    }
+
+} //namespace gentools
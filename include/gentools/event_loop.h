@@ -0,0 +1,510 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <gentools/task.h>
+#include <optional>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#if defined(__linux__)
+#    include <cerrno>
+#    include <sys/epoll.h>
+#    include <unistd.h>
+#endif
+
+namespace gentools
+{
+    class event_loop;
+
+    namespace detail
+    {
+        // Coroutine owned by an event_loop, which destroys it once it is done
+        class loop_task
+        {
+        public:
+            struct promise_type : frame_allocated<void>
+            {
+                struct final_awaiter
+                {
+                    bool await_ready() noexcept
+                    {
+                        return false;
+                    }
+
+                    void await_suspend(coroutine_handle<promise_type> handle) noexcept;
+
+                    void await_resume() noexcept {}
+                };
+
+                loop_task get_return_object() noexcept
+                {
+                    return loop_task{coroutine_handle<promise_type>::from_promise(*this)};
+                }
+
+                suspend_always initial_suspend() noexcept
+                {
+                    return {};
+                }
+
+                final_awaiter final_suspend() noexcept
+                {
+                    return {};
+                }
+
+                // the body of a loop_task catches everything itself
+                void unhandled_exception() noexcept
+                {
+                    std::terminate();
+                }
+
+                void return_void() noexcept {}
+
+                event_loop* loop = nullptr;
+            };
+
+            coroutine_handle<promise_type> handle;
+        };
+    }
+
+    /*
+       Single-threaded event loop driving tasks and async generators that wait on timers and, on
+       Linux, on file descriptors through epoll. Tasks run on the thread calling run() and take
+       turns whenever one of them co_awaits a loop awaitable, so I/O-bound stages overlap without
+       extra threads.
+       The descriptors awaited with readable() and writable() should be non-blocking pipes,
+       sockets, eventfds or terminals: epoll does not support regular files, which never block.
+       Destroying the loop destroys the tasks still waiting on it.
+    */
+    class event_loop
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        event_loop()
+        {
+#if defined(__linux__)
+            mEpoll = epoll_create1(EPOLL_CLOEXEC);
+            if (mEpoll < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "epoll_create1");
+            }
+#endif
+        }
+
+        ~event_loop()
+        {
+            for (void* address : mTasks)
+            {
+                detail::coroutine_handle<>::from_address(address).destroy();
+            }
+#if defined(__linux__)
+            close(mEpoll);
+#endif
+        }
+
+        event_loop(const event_loop&) = delete;
+        event_loop& operator=(const event_loop&) = delete;
+
+        // Starts work in the background of the loop. run() rethrows the first exception a spawned task throws.
+        void spawn(task<void> work)
+        {
+            start(run_spawned(std::move(work)));
+        }
+
+        // Runs the loop until work is done and returns its result; spawned tasks progress meanwhile
+        template <typename T>
+        T run(task<T> work)
+        {
+            using result_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+            std::optional<result_t> result;
+            std::exception_ptr exception;
+
+            start(run_main<T>(std::move(work), result, exception));
+            while (!result && !exception)
+            {
+                if (!run_once())
+                {
+                    throw std::logic_error("event_loop::run: the task waits for an event that cannot happen");
+                }
+            }
+
+            rethrow_if_spawned_failed();
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+            if constexpr (!std::is_void_v<T>)
+            {
+                return std::move(*result);
+            }
+        }
+
+        // Runs the loop until every spawned task is done, or waits for an event that cannot happen
+        void run()
+        {
+            while (run_once())
+            {
+            }
+            rethrow_if_spawned_failed();
+        }
+
+        // Resumes the awaiting coroutine after the other ready ones
+        auto schedule() noexcept
+        {
+            struct awaiter
+            {
+                event_loop& loop;
+
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                void await_suspend(detail::coroutine_handle<> handle)
+                {
+                    loop.mReady.push_back(handle);
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            return awaiter{*this};
+        }
+
+        auto sleep_until(clock::time_point time) noexcept
+        {
+            struct awaiter
+            {
+                event_loop& loop;
+                clock::time_point time;
+
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                void await_suspend(detail::coroutine_handle<> handle)
+                {
+                    loop.mTimers.push({time, loop.mTimerSequence++, handle});
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            return awaiter{*this, time};
+        }
+
+        auto sleep_for(clock::duration duration) noexcept
+        {
+            return sleep_until(clock::now() + duration);
+        }
+
+#if defined(__linux__)
+        // Resumes the awaiting coroutine once fd can be read without blocking, or is closed or failed
+        auto readable(int fd) noexcept
+        {
+            return fd_awaiter{*this, fd, false};
+        }
+
+        // Resumes the awaiting coroutine once fd can be written without blocking, or failed
+        auto writable(int fd) noexcept
+        {
+            return fd_awaiter{*this, fd, true};
+        }
+#endif
+
+    private:
+        friend struct detail::loop_task::promise_type::final_awaiter;
+
+        struct timer
+        {
+            clock::time_point time;
+            uint64_t sequence;
+            detail::coroutine_handle<> handle;
+
+            // earliest first, then in the order they were set
+            friend bool operator>(const timer& left, const timer& right) noexcept
+            {
+                return left.time != right.time ? left.time > right.time : left.sequence > right.sequence;
+            }
+        };
+
+        void start(detail::loop_task task)
+        {
+            task.handle.promise().loop = this;
+            mTasks.insert(task.handle.address());
+            mReady.push_back(task.handle);
+        }
+
+        void retire(detail::coroutine_handle<> handle) noexcept
+        {
+            mTasks.erase(handle.address());
+            handle.destroy();
+        }
+
+        detail::loop_task run_spawned(task<void> work)
+        {
+            try
+            {
+                co_await work;
+            }
+            catch (...)
+            {
+                if (!mSpawnedException)
+                {
+                    mSpawnedException = std::current_exception();
+                }
+            }
+        }
+
+        template <typename T, typename R>
+        detail::loop_task run_main(task<T> work, std::optional<R>& result, std::exception_ptr& exception)
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    co_await work;
+                    result.emplace();
+                }
+                else
+                {
+                    result.emplace(co_await work);
+                }
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+        }
+
+        void rethrow_if_spawned_failed()
+        {
+            if (mSpawnedException)
+            {
+                std::rethrow_exception(std::exchange(mSpawnedException, nullptr));
+            }
+        }
+
+        // Resumes what is ready, or waits for the next event. Returns false when nothing can happen anymore.
+        bool run_once()
+        {
+            if (!mReady.empty())
+            {
+                // the ones scheduled while these run wait for the next round
+                auto ready = std::exchange(mReady, {});
+                for (auto handle : ready)
+                {
+                    handle.resume();
+                }
+                return true;
+            }
+
+            if (!mTimers.empty() && mTimers.top().time <= clock::now())
+            {
+                while (!mTimers.empty() && mTimers.top().time <= clock::now())
+                {
+                    mReady.push_back(mTimers.top().handle);
+                    mTimers.pop();
+                }
+                return true;
+            }
+
+#if defined(__linux__)
+            if (!mWaiters.empty())
+            {
+                wait_for_descriptors();
+                return true;
+            }
+#endif
+
+            if (!mTimers.empty())
+            {
+                std::this_thread::sleep_until(mTimers.top().time);
+                return true;
+            }
+
+            return false;
+        }
+
+#if defined(__linux__)
+        struct fd_waiters
+        {
+            detail::coroutine_handle<> reader{};
+            detail::coroutine_handle<> writer{};
+            bool registered = false;
+        };
+
+        struct fd_awaiter
+        {
+            event_loop& loop;
+            int fd;
+            bool write;
+
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(detail::coroutine_handle<> handle)
+            {
+                loop.wait_for(fd, write, handle);
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        void wait_for(int fd, bool write, detail::coroutine_handle<> handle)
+        {
+            auto& waiters = mWaiters[fd];
+            auto& slot = write ? waiters.writer : waiters.reader;
+            if (slot)
+            {
+                throw std::logic_error("event_loop: two coroutines wait on the same descriptor");
+            }
+
+            slot = handle;
+            try
+            {
+                update(fd, waiters);
+            }
+            catch (...)
+            {
+                slot = nullptr;
+                if (!waiters.reader && !waiters.writer)
+                {
+                    mWaiters.erase(fd);
+                }
+                throw;
+            }
+        }
+
+        // Registers the events fd is awaited for, or unregisters it when nobody waits anymore
+        void update(int fd, fd_waiters& waiters)
+        {
+            epoll_event event{};
+            event.events = (waiters.reader ? EPOLLIN : 0u) | (waiters.writer ? EPOLLOUT : 0u);
+            event.data.fd = fd;
+
+            int op = EPOLL_CTL_MOD;
+            if (event.events == 0)
+            {
+                op = EPOLL_CTL_DEL;
+            }
+            else if (!waiters.registered)
+            {
+                op = EPOLL_CTL_ADD;
+            }
+
+            if (epoll_ctl(mEpoll, op, fd, &event) < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+            }
+            waiters.registered = op != EPOLL_CTL_DEL;
+        }
+
+        void wait_for_descriptors()
+        {
+            int timeout = -1;
+            if (!mTimers.empty())
+            {
+                const auto remaining = mTimers.top().time - clock::now();
+                timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+                timeout = timeout < 0 ? 0 : timeout;
+            }
+
+            epoll_event events[64];
+            const int count = epoll_wait(mEpoll, events, 64, timeout);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    return;
+                }
+                throw std::system_error(errno, std::generic_category(), "epoll_wait");
+            }
+
+            for (int i = 0; i < count; ++i)
+            {
+                const int fd = events[i].data.fd;
+                const auto flags = events[i].events;
+                auto& waiters = mWaiters[fd];
+
+                // a hang up or an error wakes both sides, whose next read or write reports it
+                if (waiters.reader && (flags & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0)
+                {
+                    mReady.push_back(std::exchange(waiters.reader, nullptr));
+                }
+                if (waiters.writer && (flags & (EPOLLOUT | EPOLLHUP | EPOLLERR)) != 0)
+                {
+                    mReady.push_back(std::exchange(waiters.writer, nullptr));
+                }
+
+                update(fd, waiters);
+                if (!waiters.registered)
+                {
+                    mWaiters.erase(fd);
+                }
+            }
+        }
+
+        int mEpoll = -1;
+        std::unordered_map<int, fd_waiters> mWaiters;
+#endif
+
+        std::deque<detail::coroutine_handle<>> mReady;
+        std::priority_queue<timer, std::vector<timer>, std::greater<>> mTimers;
+        uint64_t mTimerSequence = 0;
+        std::unordered_set<void*> mTasks;
+        std::exception_ptr mSpawnedException;
+    };
+
+    namespace detail
+    {
+        inline void loop_task::promise_type::final_awaiter::await_suspend(
+            coroutine_handle<promise_type> handle) noexcept
+        {
+            handle.promise().loop->retire(handle);
+        }
+    }
+
+#if defined(__linux__)
+    /*
+       Reads what is available from the non-blocking descriptor fd into buffer, waiting on loop
+       while nothing is. Returns the number of bytes read, 0 at the end of the input.
+    */
+    inline task<size_t> async_read_some(event_loop& loop, int fd, std::span<std::byte> buffer)
+    {
+        while (true)
+        {
+            const auto count = read(fd, buffer.data(), buffer.size());
+            if (count >= 0)
+            {
+                co_return static_cast<size_t>(count);
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                throw std::system_error(errno, std::generic_category(), "read");
+            }
+            if (errno != EINTR)
+            {
+                co_await loop.readable(fd);
+            }
+        }
+    }
+#endif
+
+} //namespace gentools
@@ -0,0 +1,531 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <gentools.h>
+#include <memory>
+#include <new>
+#include <span>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#    include <linux/io_uring.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <sys/uio.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <cerrno>
+#    include <fcntl.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define GENTOOLS_HAS_PREAD 1
+#else
+#    define GENTOOLS_HAS_PREAD 0
+#endif
+
+namespace gentools
+{
+    struct file_chunk_options
+    {
+        // bytes per chunk, every chunk but the last one of the file is full unless the file grows
+        // while it is read
+        size_t chunk_size = size_t{1} << 20;
+        // reads in flight, and buffers in the pool, with io_uring
+        size_t queue_depth = 4;
+        // false to always read synchronously
+        bool use_io_uring = true;
+    };
+
+    namespace detail
+    {
+        // queue_depth buffers of chunk_size bytes, page aligned, in one block
+        class chunk_buffers
+        {
+        public:
+            static constexpr size_t alignment = 4096;
+
+            chunk_buffers(size_t count, size_t size)
+                : mSize((size + alignment - 1) / alignment * alignment)
+                , mBlock(static_cast<std::byte*>(::operator new(count * mSize, std::align_val_t{alignment})))
+            {
+            }
+
+            ~chunk_buffers()
+            {
+                ::operator delete(mBlock, std::align_val_t{alignment});
+            }
+
+            chunk_buffers(const chunk_buffers&) = delete;
+            chunk_buffers& operator=(const chunk_buffers&) = delete;
+
+            std::byte* operator[](size_t index) const noexcept
+            {
+                return mBlock + index * mSize;
+            }
+
+        private:
+            const size_t mSize;
+            std::byte* mBlock;
+        };
+
+#if GENTOOLS_HAS_PREAD
+        class chunk_file
+        {
+        public:
+            explicit chunk_file(const std::filesystem::path& path)
+                : mFd(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+            {
+                struct stat info{};
+                if (mFd < 0 || ::fstat(mFd, &info) < 0)
+                {
+                    const int error = errno;
+                    if (mFd >= 0)
+                    {
+                        ::close(mFd);
+                    }
+                    throw std::system_error(error, std::generic_category(), path.string());
+                }
+                mRegular = S_ISREG(info.st_mode);
+                mSize = mRegular ? static_cast<uint64_t>(info.st_size) : 0;
+            }
+
+            ~chunk_file()
+            {
+                ::close(mFd);
+            }
+
+            chunk_file(const chunk_file&) = delete;
+            chunk_file& operator=(const chunk_file&) = delete;
+
+            int fd() const noexcept
+            {
+                return mFd;
+            }
+
+            // false for pipes, sockets and devices, which can only be read in order
+            bool regular() const noexcept
+            {
+                return mRegular;
+            }
+
+            // Size when the file was opened, 0 if it is not a regular file
+            uint64_t size() const noexcept
+            {
+                return mSize;
+            }
+
+            // Reads up to length bytes at offset, fewer only at the end of the file. The offset is
+            // ignored for files that are not regular, which are read in order.
+            size_t read(std::byte* buffer, size_t length, uint64_t offset)
+            {
+                size_t filled = 0;
+                while (filled < length)
+                {
+                    const auto count = mRegular
+                        ? ::pread(mFd, buffer + filled, length - filled, static_cast<off_t>(offset + filled))
+                        : ::read(mFd, buffer + filled, length - filled);
+                    if (count < 0)
+                    {
+                        if (errno == EINTR)
+                        {
+                            continue;
+                        }
+                        throw std::system_error(errno, std::generic_category(), mRegular ? "pread" : "read");
+                    }
+                    if (count == 0)
+                    {
+                        break;
+                    }
+                    filled += static_cast<size_t>(count);
+                }
+                return filled;
+            }
+
+        private:
+            int mFd = -1;
+            bool mRegular = false;
+            uint64_t mSize = 0;
+        };
+#else
+        class chunk_file
+        {
+        public:
+            explicit chunk_file(const std::filesystem::path& path)
+                : mFile(std::fopen(path.string().c_str(), "rb"))
+            {
+                if (mFile == nullptr)
+                {
+                    throw std::system_error(errno, std::generic_category(), path.string());
+                }
+                std::error_code error{};
+                mSize = std::filesystem::is_regular_file(path, error) ? std::filesystem::file_size(path, error) : 0;
+            }
+
+            ~chunk_file()
+            {
+                std::fclose(mFile);
+            }
+
+            chunk_file(const chunk_file&) = delete;
+            chunk_file& operator=(const chunk_file&) = delete;
+
+            bool regular() const noexcept
+            {
+                return false;
+            }
+
+            // Size when the file was opened, 0 if it is not a regular file
+            uint64_t size() const noexcept
+            {
+                return mSize;
+            }
+
+            // Chunks are read in order, so the stream position is always at offset
+            size_t read(std::byte* buffer, size_t length, uint64_t)
+            {
+                const size_t filled = std::fread(buffer, 1, length, mFile);
+                if (filled < length && std::ferror(mFile))
+                {
+                    throw std::system_error(errno, std::generic_category(), "fread");
+                }
+                return filled;
+            }
+
+        private:
+            std::FILE* mFile = nullptr;
+            uint64_t mSize = 0;
+        };
+#endif
+
+#if defined(__linux__)
+        /*
+           Minimal io_uring submitting vectored reads or writes of one file, through the raw
+           system calls. Slots are the indices of the buffers a request uses, returned with its
+           completion. The destructor waits for the requests still in flight, which the kernel
+           would otherwise complete with freed buffers.
+        */
+        class io_uring_file
+        {
+        public:
+            struct completion
+            {
+                size_t slot;
+                int result;
+            };
+
+            // nullptr when the kernel does not support io_uring, or forbids it
+            static std::unique_ptr<io_uring_file> create(int fd, unsigned entries)
+            {
+                io_uring_params params{};
+                const int ring = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+                if (ring < 0)
+                {
+                    return nullptr;
+                }
+
+                std::unique_ptr<io_uring_file> reader{new io_uring_file(ring, fd, entries)};
+                if (!reader->map(params))
+                {
+                    return nullptr;
+                }
+                return reader;
+            }
+
+            ~io_uring_file()
+            {
+                while (mInFlight > 0)
+                {
+                    try
+                    {
+                        wait();
+                    }
+                    catch (...)
+                    {
+                        break;
+                    }
+                }
+
+                if (mSqes != nullptr)
+                {
+                    ::munmap(mSqes, mSqesSize);
+                }
+                if (mCqRing != nullptr && mCqRing != mSqRing)
+                {
+                    ::munmap(mCqRing, mCqRingSize);
+                }
+                if (mSqRing != nullptr)
+                {
+                    ::munmap(mSqRing, mSqRingSize);
+                }
+                ::close(mRing);
+            }
+
+            io_uring_file(const io_uring_file&) = delete;
+            io_uring_file& operator=(const io_uring_file&) = delete;
+
+            void read(size_t slot, std::byte* buffer, size_t length, uint64_t offset)
+            {
+                submit(IORING_OP_READV, slot, buffer, length, offset);
+            }
+
+            void write(size_t slot, const std::byte* buffer, size_t length, uint64_t offset)
+            {
+                submit(IORING_OP_WRITEV, slot, const_cast<std::byte*>(buffer), length, offset);
+            }
+
+            // Waits for the next completed request, in any order. result is the number of bytes
+            // transferred, or -errno.
+            completion wait()
+            {
+                auto head = std::atomic_ref{*mCqHead};
+                auto tail = std::atomic_ref{*mCqTail};
+
+                while (true)
+                {
+                    const unsigned current = head.load(std::memory_order_relaxed);
+                    if (current != tail.load(std::memory_order_acquire))
+                    {
+                        const auto& cqe = mCqes[current & mCqMask];
+                        const completion result{static_cast<size_t>(cqe.user_data), cqe.res};
+                        head.store(current + 1, std::memory_order_release);
+                        --mInFlight;
+                        return result;
+                    }
+
+                    if (::syscall(__NR_io_uring_enter, mRing, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                        errno != EINTR)
+                    {
+                        throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+                    }
+                }
+            }
+
+        private:
+            io_uring_file(int ring, int fd, unsigned entries)
+                : mRing(ring)
+                , mFd(fd)
+                , mIovecs(entries)
+            {
+            }
+
+            void submit(uint8_t opcode, size_t slot, std::byte* buffer, size_t length, uint64_t offset)
+            {
+                // the kernel may read the iovec after io_uring_enter returns, so it lives in the ring
+                mIovecs[slot] = {buffer, length};
+
+                auto tail = std::atomic_ref{*mSqTail};
+                const unsigned index = tail.load(std::memory_order_relaxed) & mSqMask;
+
+                auto& sqe = mSqes[index];
+                sqe = {};
+                sqe.opcode = opcode;
+                sqe.fd = mFd;
+                sqe.off = offset;
+                sqe.addr = reinterpret_cast<uint64_t>(&mIovecs[slot]);
+                sqe.len = 1;
+                sqe.user_data = slot;
+
+                mSqArray[index] = index;
+                tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+                while (::syscall(__NR_io_uring_enter, mRing, 1, 0, 0, nullptr, 0) < 0)
+                {
+                    if (errno != EINTR && errno != EAGAIN)
+                    {
+                        throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+                    }
+                }
+                ++mInFlight;
+            }
+
+            bool map(const io_uring_params& params)
+            {
+                mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+                if (singleMap)
+                {
+                    mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+                }
+
+                mSqRing = map_region(mSqRingSize, IORING_OFF_SQ_RING);
+                mCqRing = singleMap ? mSqRing : map_region(mCqRingSize, IORING_OFF_CQ_RING);
+                mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                mSqes = static_cast<io_uring_sqe*>(map_region(mSqesSize, IORING_OFF_SQES));
+                if (mSqRing == nullptr || mCqRing == nullptr || mSqes == nullptr)
+                {
+                    return false;
+                }
+
+                auto* sq = static_cast<std::byte*>(mSqRing);
+                mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                mSqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+                auto* cq = static_cast<std::byte*>(mCqRing);
+                mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+                mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+                mCqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+                mCqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+                return true;
+            }
+
+            void* map_region(size_t size, off_t offset) const noexcept
+            {
+                void* region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, offset);
+                return region == MAP_FAILED ? nullptr : region;
+            }
+
+            const int mRing;
+            const int mFd;
+            std::vector<iovec> mIovecs;
+            size_t mInFlight = 0;
+
+            void* mSqRing = nullptr;
+            size_t mSqRingSize = 0;
+            unsigned* mSqTail = nullptr;
+            unsigned mSqMask = 0;
+            unsigned* mSqArray = nullptr;
+            io_uring_sqe* mSqes = nullptr;
+            size_t mSqesSize = 0;
+
+            void* mCqRing = nullptr;
+            size_t mCqRingSize = 0;
+            unsigned* mCqHead = nullptr;
+            unsigned* mCqTail = nullptr;
+            unsigned mCqMask = 0;
+            io_uring_cqe* mCqes = nullptr;
+        };
+#endif
+    }
+
+    /*
+       Reads the file at path in chunks of options.chunk_size bytes and yields each as a span over
+       a buffer of a recycled pool. A chunk is only valid until the next one is requested.
+       On Linux, options.queue_depth reads of a regular file are kept in flight through io_uring, so
+       the next chunks are read while the consumer works on the current one; where io_uring is
+       unavailable the chunks are read synchronously with pread. Either way the file is read until a
+       read returns no bytes, so pipes, sockets, files of /proc and files growing while they are read
+       are read in full, and a file truncated meanwhile ends at the first empty read. Throws
+       std::system_error on I/O errors.
+    */
+    inline generator<std::span<const std::byte>> file_chunks(std::filesystem::path path,
+                                                             file_chunk_options options = {})
+    {
+        detail::stage_probe probe{"file_chunks"};
+        detail::chunk_file file{path};
+
+        const size_t chunkSize = std::max<size_t>(options.chunk_size, 1);
+        const uint64_t fileSize = file.size();
+        const uint64_t chunks = (fileSize + chunkSize - 1) / chunkSize;
+        const size_t depth = static_cast<size_t>(std::clamp<uint64_t>(options.queue_depth, 1, std::max<uint64_t>(chunks, 1)));
+
+        detail::chunk_buffers buffers{depth, chunkSize};
+        probe.allocated(depth * chunkSize);
+
+        // bytes yielded so far, and whether a read found the end of the file
+        uint64_t yielded = 0;
+        bool ended = false;
+
+#if defined(__linux__)
+        // declared after the buffers, so it is destroyed, and drained, before them
+        auto ring = options.use_io_uring && file.regular() && chunks > 1
+            ? detail::io_uring_file::create(file.fd(), static_cast<unsigned>(depth))
+            : nullptr;
+        if (ring)
+        {
+            struct pending_read
+            {
+                uint64_t offset = 0;
+                size_t length = 0;
+                size_t filled = 0;
+                bool done = false;
+            };
+
+            std::vector<pending_read> reads(depth);
+            uint64_t submitted = 0;
+
+            auto submit = [&](size_t slot)
+            {
+                const uint64_t offset = submitted * chunkSize;
+                reads[slot] = {offset, static_cast<size_t>(std::min<uint64_t>(chunkSize, fileSize - offset)), 0, false};
+                ring->read(slot, buffers[slot], reads[slot].length, offset);
+                ++submitted;
+            };
+
+            for (size_t slot = 0; slot < depth && submitted < chunks; ++slot)
+            {
+                submit(slot);
+            }
+
+            for (uint64_t chunk = 0; chunk < chunks; ++chunk)
+            {
+                const size_t slot = chunk % depth;
+                while (!reads[slot].done)
+                {
+                    const auto completion = ring->wait();
+                    if (completion.result < 0)
+                    {
+                        throw std::system_error(-completion.result, std::generic_category(), "io_uring read");
+                    }
+
+                    auto& pending = reads[completion.slot];
+                    pending.filled += static_cast<size_t>(completion.result);
+                    if (completion.result == 0 || pending.filled == pending.length)
+                    {
+                        // a read of 0 bytes means the file was truncated meanwhile
+                        pending.done = true;
+                    }
+                    else
+                    {
+                        // short read, the rest of the chunk is read into the same buffer
+                        ring->read(completion.slot, buffers[completion.slot] + pending.filled,
+                                   pending.length - pending.filled, pending.offset + pending.filled);
+                    }
+                }
+
+                // the file was truncated before this chunk, the reads still in flight are drained
+                // by the ring
+                if (reads[slot].filled == 0)
+                {
+                    ended = true;
+                    break;
+                }
+                yielded += reads[slot].filled;
+
+                probe.element_in();
+                co_yield probe.yield(std::span<const std::byte>{buffers[slot], reads[slot].filled});
+                probe.resume();
+
+                if (submitted < chunks)
+                {
+                    submit(slot);
+                }
+            }
+        }
+#endif
+        // all of the file without io_uring, or what it grew by since it was opened
+        while (!ended)
+        {
+            const size_t filled = file.read(buffers[0], chunkSize, yielded);
+            if (filled == 0)
+            {
+                break;
+            }
+            yielded += filled;
+
+            probe.element_in();
+            co_yield probe.yield(std::span<const std::byte>{buffers[0], filled});
+            probe.resume();
+        }
+    }
+
+} //namespace gentools
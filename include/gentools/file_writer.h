@@ -0,0 +1,340 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <gentools.h>
+#include <gentools/file_chunks.h>
+#include <memory>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace gentools
+{
+    enum class fsync_policy
+    {
+        // leave the data to the page cache
+        none,
+        // flush the file to the device once everything is written
+        on_close,
+        // flush the file to the device after every buffer, which makes the writes synchronous
+        every_flush
+    };
+
+    struct file_write_options
+    {
+        // bytes per buffer, every write but the last one is a full buffer
+        size_t buffer_size = size_t{1} << 20;
+        // writes in flight, and buffers in the pool, with io_uring
+        size_t queue_depth = 4;
+        // false to always write synchronously
+        bool use_io_uring = true;
+        fsync_policy sync = fsync_policy::none;
+    };
+
+    namespace detail
+    {
+#if GENTOOLS_HAS_PREAD
+        class output_file
+        {
+        public:
+            explicit output_file(const std::filesystem::path& path)
+                : mFd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644))
+            {
+                if (mFd < 0)
+                {
+                    throw std::system_error(errno, std::generic_category(), path.string());
+                }
+            }
+
+            ~output_file()
+            {
+                ::close(mFd);
+            }
+
+            output_file(const output_file&) = delete;
+            output_file& operator=(const output_file&) = delete;
+
+            int fd() const noexcept
+            {
+                return mFd;
+            }
+
+            void write(const std::byte* buffer, size_t length, uint64_t offset)
+            {
+                size_t written = 0;
+                while (written < length)
+                {
+                    const auto count =
+                        ::pwrite(mFd, buffer + written, length - written, static_cast<off_t>(offset + written));
+                    if (count < 0)
+                    {
+                        if (errno == EINTR)
+                        {
+                            continue;
+                        }
+                        throw std::system_error(errno, std::generic_category(), "pwrite");
+                    }
+                    written += static_cast<size_t>(count);
+                }
+            }
+
+            void sync()
+            {
+#    if defined(__linux__)
+                const int result = ::fdatasync(mFd);
+#    else
+                const int result = ::fsync(mFd);
+#    endif
+                if (result < 0)
+                {
+                    throw std::system_error(errno, std::generic_category(), "fsync");
+                }
+            }
+
+        private:
+            int mFd = -1;
+        };
+#else
+        class output_file
+        {
+        public:
+            explicit output_file(const std::filesystem::path& path)
+                : mFile(std::fopen(path.string().c_str(), "wb"))
+            {
+                if (mFile == nullptr)
+                {
+                    throw std::system_error(errno, std::generic_category(), path.string());
+                }
+            }
+
+            ~output_file()
+            {
+                std::fclose(mFile);
+            }
+
+            output_file(const output_file&) = delete;
+            output_file& operator=(const output_file&) = delete;
+
+            // Buffers are written in order, so the stream position is always at offset
+            void write(const std::byte* buffer, size_t length, uint64_t)
+            {
+                if (std::fwrite(buffer, 1, length, mFile) < length)
+                {
+                    throw std::system_error(errno, std::generic_category(), "fwrite");
+                }
+            }
+
+            // Only hands the data to the operating system
+            void sync()
+            {
+                if (std::fflush(mFile) != 0)
+                {
+                    throw std::system_error(errno, std::generic_category(), "fflush");
+                }
+            }
+
+        private:
+            std::FILE* mFile = nullptr;
+        };
+#endif
+
+        /*
+           Accumulates bytes into page aligned buffers and writes each one at the end of the file
+           once full. On Linux, up to queue_depth buffers are written through io_uring while the
+           next one is filled; otherwise, or with fsync_policy::every_flush, with pwrite.
+           close() writes what is left and must be called for the data to be complete; the
+           destructor only waits for the writes in flight.
+        */
+        class file_writer
+        {
+        public:
+            file_writer(const std::filesystem::path& path, const file_write_options& options)
+                : mFile(path)
+                , mBufferSize(std::max<size_t>(options.buffer_size, 1))
+                , mDepth(std::max<size_t>(options.queue_depth, 1))
+                , mSync(options.sync)
+                , mBuffers(mDepth, mBufferSize)
+                , mWrites(mDepth)
+            {
+#if defined(__linux__)
+                if (options.use_io_uring && mSync != fsync_policy::every_flush)
+                {
+                    mRing = io_uring_file::create(mFile.fd(), static_cast<unsigned>(mDepth));
+                }
+#endif
+            }
+
+            file_writer(const file_writer&) = delete;
+            file_writer& operator=(const file_writer&) = delete;
+
+            void append(const void* data, size_t length)
+            {
+                const auto* bytes = static_cast<const std::byte*>(data);
+                while (length > 0)
+                {
+                    const size_t count = std::min(length, mBufferSize - mFill);
+                    std::memcpy(mBuffers[mSlot] + mFill, bytes, count);
+                    mFill += count;
+                    bytes += count;
+                    length -= count;
+
+                    if (mFill == mBufferSize)
+                    {
+                        flush();
+                    }
+                }
+            }
+
+            void close()
+            {
+                flush();
+                for (size_t slot = 0; slot < mDepth; ++slot)
+                {
+                    wait_for(slot);
+                }
+                if (mSync != fsync_policy::none)
+                {
+                    mFile.sync();
+                }
+            }
+
+        private:
+            struct pending_write
+            {
+                uint64_t offset = 0;
+                size_t length = 0;
+                size_t written = 0;
+                bool busy = false;
+            };
+
+            void flush()
+            {
+                if (mFill == 0)
+                {
+                    return;
+                }
+
+#if defined(__linux__)
+                if (mRing)
+                {
+                    mWrites[mSlot] = {mOffset, mFill, 0, true};
+                    mRing->write(mSlot, mBuffers[mSlot], mFill, mOffset);
+                    mOffset += mFill;
+                    mFill = 0;
+
+                    // the next buffer may still be in flight from queue_depth flushes ago
+                    mSlot = (mSlot + 1) % mDepth;
+                    wait_for(mSlot);
+                    return;
+                }
+#endif
+
+                mFile.write(mBuffers[mSlot], mFill, mOffset);
+                mOffset += mFill;
+                mFill = 0;
+                if (mSync == fsync_policy::every_flush)
+                {
+                    mFile.sync();
+                }
+            }
+
+            void wait_for([[maybe_unused]] size_t slot)
+            {
+#if defined(__linux__)
+                while (mWrites[slot].busy)
+                {
+                    const auto completion = mRing->wait();
+                    if (completion.result <= 0)
+                    {
+                        // a write of 0 bytes would never complete the buffer
+                        throw std::system_error(completion.result < 0 ? -completion.result : EIO,
+                                                std::generic_category(), "io_uring write");
+                    }
+
+                    auto& pending = mWrites[completion.slot];
+                    pending.written += static_cast<size_t>(completion.result);
+                    if (pending.written == pending.length)
+                    {
+                        pending.busy = false;
+                    }
+                    else
+                    {
+                        // short write, the rest of the buffer is written from the same slot
+                        mRing->write(completion.slot, mBuffers[completion.slot] + pending.written,
+                                     pending.length - pending.written, pending.offset + pending.written);
+                    }
+                }
+#endif
+            }
+
+            output_file mFile;
+            const size_t mBufferSize;
+            const size_t mDepth;
+            const fsync_policy mSync;
+            chunk_buffers mBuffers;
+            std::vector<pending_write> mWrites;
+#if defined(__linux__)
+            // declared after the buffers, so it is destroyed, and drained, before them
+            std::unique_ptr<io_uring_file> mRing{};
+#endif
+            size_t mSlot = 0;
+            size_t mFill = 0;
+            uint64_t mOffset = 0;
+        };
+    }
+
+    /*
+       Writes the bytes of every element of range, which must be trivially copyable, one after
+       the other to the file at path, which is created or truncated. The elements are batched
+       into large buffers, see file_write_options. Returns the number of records written, and
+       throws std::system_error on I/O errors. The file can be read back with mmap_array<T>.
+    */
+    template <ranges::range T>
+        requires std::is_trivially_copyable_v<range_value_t<T>>
+    uint64_t write_records(T&& range, const std::filesystem::path& path, file_write_options options = {})
+    {
+        detail::file_writer writer{path, options};
+        uint64_t count = 0;
+        for (auto&& record : range)
+        {
+            if constexpr (std::is_lvalue_reference_v<ranges::range_reference_t<T>>)
+            {
+                writer.append(std::addressof(record), sizeof(range_value_t<T>));
+            }
+            else
+            {
+                // a proxy or a prvalue, such as an element of std::vector<bool>
+                const range_value_t<T> value = record;
+                writer.append(std::addressof(value), sizeof(value));
+            }
+            ++count;
+        }
+        writer.close();
+        return count;
+    }
+
+    // Same as above for text, writing each element of range followed by '\n'. Returns the number of lines written.
+    template <ranges::range T>
+        requires std::is_convertible_v<range_value_t<T>, std::string_view>
+    uint64_t write_lines(T&& range, const std::filesystem::path& path, file_write_options options = {})
+    {
+        detail::file_writer writer{path, options};
+        uint64_t count = 0;
+        for (auto&& element : range)
+        {
+            const std::string_view line = element;
+            writer.append(line.data(), line.size());
+            writer.append("\n", 1);
+            ++count;
+        }
+        writer.close();
+        return count;
+    }
+
+} //namespace gentools
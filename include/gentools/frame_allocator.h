@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <gentools/frame_introspection.h>
+#include <gentools/frame_pool.h>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+// Define to the largest coroutine frame, in bytes, a generator may allocate. Every frame allocation
+// asserts against it, so a stage whose frame grows past the budget is caught in debug builds. The
+// budget is per frame, not per pipeline: a pipeline of n stages may use up to n times the budget.
+// #define GENTOOLS_MAX_FRAME_BYTES 256
+
+namespace gentools
+{
+    /*
+       Per-thread counters updated by the promise of every gentools generator when it allocates
+       or frees its coroutine frame. A frame whose allocation was elided by the compiler (HALO)
+       never reaches the allocator, so it does not show up here.
+    */
+    struct frame_counters
+    {
+        size_t allocations = 0;
+        size_t deallocations = 0;
+        size_t bytes = 0;
+        size_t live_bytes = 0;
+    };
+
+    inline frame_counters operator-(const frame_counters& lhs, const frame_counters& rhs) noexcept
+    {
+        return {lhs.allocations - rhs.allocations,
+                lhs.deallocations - rhs.deallocations,
+                lhs.bytes - rhs.bytes,
+                lhs.live_bytes - rhs.live_bytes};
+    }
+
+    inline frame_counters& thread_frame_counters() noexcept
+    {
+        thread_local frame_counters counters{};
+        return counters;
+    }
+
+    namespace detail
+    {
+        inline std::pmr::memory_resource*& thread_frame_resource() noexcept
+        {
+            thread_local std::pmr::memory_resource* resource = nullptr;
+            return resource;
+        }
+    }
+
+    /*
+       Memory resource of the innermost frame_resource_scope of this thread, or else
+       std::pmr::get_default_resource(). The adaptors that need internal buffers take them from
+       it. Coroutine frames only come from it inside a frame_resource_scope, or when the capacity
+       of thread_frame_pool() is 0; otherwise they are recycled through that pool.
+    */
+    inline std::pmr::memory_resource* current_frame_resource() noexcept
+    {
+        auto* resource = detail::thread_frame_resource();
+        return resource != nullptr ? resource : std::pmr::get_default_resource();
+    }
+
+    /*
+       Makes a memory resource the current frame resource of this thread until the end of the scope.
+       Must not be kept alive across a co_yield, since the consumer would observe it.
+    */
+    class frame_resource_scope
+    {
+    public:
+        explicit frame_resource_scope(std::pmr::memory_resource* resource) noexcept
+            : mPrevious(std::exchange(detail::thread_frame_resource(), resource))
+        {
+        }
+
+        ~frame_resource_scope()
+        {
+            detail::thread_frame_resource() = mPrevious;
+        }
+
+        frame_resource_scope(const frame_resource_scope&) = delete;
+        frame_resource_scope& operator=(const frame_resource_scope&) = delete;
+
+    private:
+        std::pmr::memory_resource* mPrevious;
+    };
+
+    /*
+       Stateless allocator plugged into the generator promise. The promise rebinds it to char and
+       default constructs it for every frame, so all the state it needs must be reachable without
+       an instance.
+       Inside a frame_resource_scope frames are taken from that resource, which is stored in a
+       header in front of the frame so it can be returned to it from any thread or scope.
+       Otherwise frames are recycled through the thread_frame_pool() (a null header), or taken from
+       std::pmr::get_default_resource() when the pool capacity is 0. Pooled frames freed after the
+       pool of their thread is destroyed are released with operator delete.
+       Tag is the value type of the generator, used to attribute frame sizes in the report of
+       frame_introspection.h.
+    */
+    template <typename T, typename Tag = void>
+    struct frame_allocator
+    {
+        using value_type = T;
+
+        static constexpr size_t header_size = alignof(std::max_align_t);
+
+        frame_allocator() noexcept = default;
+
+        template <typename U>
+        frame_allocator(const frame_allocator<U, Tag>&) noexcept {}
+
+        T* allocate(size_t n)
+        {
+            const size_t bytes = n * sizeof(T);
+#if defined(GENTOOLS_MAX_FRAME_BYTES)
+            assert(bytes <= GENTOOLS_MAX_FRAME_BYTES && "coroutine frame exceeds GENTOOLS_MAX_FRAME_BYTES");
+#endif
+            record_frame_size<Tag>(bytes);
+
+            auto* resource = detail::thread_frame_resource();
+            std::byte* block = nullptr;
+
+            if (resource == nullptr && thread_frame_pool_alive() && thread_frame_pool().capacity() > 0)
+            {
+                block = static_cast<std::byte*>(thread_frame_pool().allocate(header_size + bytes));
+            }
+            else
+            {
+                resource = current_frame_resource();
+                block = static_cast<std::byte*>(resource->allocate(header_size + bytes, header_size));
+            }
+            *reinterpret_cast<std::pmr::memory_resource**>(block) = resource;
+
+            auto& counters = thread_frame_counters();
+            ++counters.allocations;
+            counters.bytes += bytes;
+            counters.live_bytes += bytes;
+
+            return reinterpret_cast<T*>(block + header_size);
+        }
+
+        void deallocate(T* frame, size_t n) noexcept
+        {
+            const size_t bytes = n * sizeof(T);
+            auto* block = reinterpret_cast<std::byte*>(frame) - header_size;
+            auto* resource = *reinterpret_cast<std::pmr::memory_resource**>(block);
+
+            auto& counters = thread_frame_counters();
+            ++counters.deallocations;
+            counters.live_bytes -= bytes;
+
+            if (resource == nullptr)
+            {
+                if (thread_frame_pool_alive())
+                {
+                    thread_frame_pool().deallocate(block, header_size + bytes);
+                }
+                else
+                {
+                    frame_pool::release(block, header_size + bytes);
+                }
+            }
+            else
+            {
+                resource->deallocate(block, header_size + bytes, header_size);
+            }
+        }
+
+        template <typename U>
+        friend bool operator==(const frame_allocator&, const frame_allocator<U, Tag>&) noexcept
+        {
+            return true;
+        }
+    };
+
+} //namespace gentools
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUG__)
+#    include <cstdlib>
+#    include <cxxabi.h>
+#endif
+
+// Define to 1 to record frame sizes from the start of the program, instead of calling
+// enable_frame_introspection() at runtime.
+#ifndef GENTOOLS_FRAME_INTROSPECTION
+#    define GENTOOLS_FRAME_INTROSPECTION 0
+#endif
+
+namespace gentools
+{
+    /*
+       One line of the frame size report: how many frames of a given size the gentools function
+       named function allocated for generators of a given value type. Frames of generators that
+       are not created by a named gentools function have an empty function name.
+    */
+    struct frame_size_entry
+    {
+        std::string function;
+        std::string type_name;
+        size_t frame_bytes = 0;
+        size_t allocations = 0;
+    };
+
+    namespace detail
+    {
+        struct frame_size_registry
+        {
+            std::atomic<bool> enabled{GENTOOLS_FRAME_INTROSPECTION != 0};
+            std::mutex mutex;
+            std::map<std::tuple<std::string, std::type_index, size_t>, size_t> allocations;
+        };
+
+        // Name of the gentools function whose coroutine is being called on this thread
+        inline const char*& thread_frame_name() noexcept
+        {
+            thread_local const char* name = nullptr;
+            return name;
+        }
+
+        /*
+           Names the frames allocated until the end of the scope, for the report. The adaptors
+           open one around the call of their coroutine, which allocates the frame before the
+           body runs, so nested generators created later by the body get their own name.
+        */
+        class frame_name_scope
+        {
+        public:
+            explicit frame_name_scope(const char* name) noexcept
+                : mPrevious(std::exchange(thread_frame_name(), name))
+            {
+            }
+
+            ~frame_name_scope()
+            {
+                thread_frame_name() = mPrevious;
+            }
+
+            frame_name_scope(const frame_name_scope&) = delete;
+            frame_name_scope& operator=(const frame_name_scope&) = delete;
+
+        private:
+            const char* mPrevious;
+        };
+
+        inline frame_size_registry& shared_frame_size_registry()
+        {
+            static frame_size_registry registry{};
+            return registry;
+        }
+
+        inline std::string type_name(const std::type_index& type)
+        {
+#if defined(__GNUG__)
+            int status = 0;
+            char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+            if (status == 0 && demangled != nullptr)
+            {
+                std::string name{demangled};
+                std::free(demangled);
+                return name;
+            }
+#endif
+            return type.name();
+        }
+    }
+
+    inline void enable_frame_introspection(bool enable = true) noexcept
+    {
+        detail::shared_frame_size_registry().enabled.store(enable, std::memory_order_relaxed);
+    }
+
+    inline bool frame_introspection_enabled() noexcept
+    {
+        return detail::shared_frame_size_registry().enabled.load(std::memory_order_relaxed);
+    }
+
+    /*
+       Called by the frame allocator of generator<T> (Tag = T) for every frame it allocates.
+       Frames are attributed to the innermost detail::frame_name_scope of the thread.
+    */
+    template <typename Tag>
+    void record_frame_size(size_t bytes)
+    {
+        auto& registry = detail::shared_frame_size_registry();
+        if (!registry.enabled.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        const char* name = detail::thread_frame_name();
+
+        std::lock_guard lock{registry.mutex};
+        ++registry.allocations[{name != nullptr ? name : "", std::type_index{typeid(Tag)}, bytes}];
+    }
+
+    inline std::vector<frame_size_entry> frame_size_report()
+    {
+        auto& registry = detail::shared_frame_size_registry();
+        std::lock_guard lock{registry.mutex};
+
+        std::vector<frame_size_entry> report;
+        report.reserve(registry.allocations.size());
+
+        for (auto&& [key, allocations] : registry.allocations)
+        {
+            auto&& [function, type, bytes] = key;
+            report.push_back({function, detail::type_name(type), bytes, allocations});
+        }
+
+        return report;
+    }
+
+    inline void reset_frame_size_report()
+    {
+        auto& registry = detail::shared_frame_size_registry();
+        std::lock_guard lock{registry.mutex};
+        registry.allocations.clear();
+    }
+
+    inline void print_frame_size_report(std::ostream& out)
+    {
+        for (auto&& entry : frame_size_report())
+        {
+            if (!entry.function.empty())
+            {
+                out << entry.function << ' ';
+            }
+            out << "generator<" << entry.type_name << ">: " << entry.frame_bytes << " bytes x "
+                << entry.allocations << '\n';
+        }
+    }
+
+} //namespace gentools
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+
+// Maximum number of recycled frames kept per size class and thread. 0 disables the pool.
+#ifndef GENTOOLS_FRAME_POOL_CAPACITY
+#    define GENTOOLS_FRAME_POOL_CAPACITY 32
+#endif
+
+namespace gentools
+{
+    struct frame_pool_stats
+    {
+        // allocations served from a free list
+        size_t hits = 0;
+        // allocations that had to go to operator new
+        size_t misses = 0;
+        // frames returned to a free list on destruction
+        size_t recycled = 0;
+        // frames freed because their free list was full or too large to be pooled
+        size_t released = 0;
+        size_t cached_frames = 0;
+        size_t cached_bytes = 0;
+    };
+
+    /*
+       Per-thread free lists of coroutine frames. Every coroutine function has a fixed frame size,
+       so bucketing by size class gives each generator type its own list: destroying a pipeline
+       puts its frames back and building the same pipeline again takes them without calling
+       operator new. Each list is bounded by capacity(); frames larger than max_frame_size are
+       never pooled.
+    */
+    class frame_pool
+    {
+    public:
+        static constexpr size_t granularity = alignof(std::max_align_t);
+        static constexpr size_t max_frame_size = 4096;
+
+        frame_pool() noexcept = default;
+
+        frame_pool(const frame_pool&) = delete;
+        frame_pool& operator=(const frame_pool&) = delete;
+
+        ~frame_pool()
+        {
+            trim();
+            // frames freed after this point go straight to operator delete
+            mCapacity = 0;
+        }
+
+        void* allocate(size_t bytes)
+        {
+            if (bytes <= max_frame_size)
+            {
+                auto& list = mLists[size_class(bytes)];
+                if (list.head != nullptr)
+                {
+                    auto* node = list.head;
+                    list.head = node->next;
+                    --list.count;
+
+                    ++mStats.hits;
+                    --mStats.cached_frames;
+                    mStats.cached_bytes -= rounded_size(bytes);
+
+                    return node;
+                }
+            }
+
+            ++mStats.misses;
+            return ::operator new(rounded_size(bytes));
+        }
+
+        void deallocate(void* frame, size_t bytes) noexcept
+        {
+            if (bytes <= max_frame_size)
+            {
+                auto& list = mLists[size_class(bytes)];
+                if (list.count < mCapacity)
+                {
+                    list.head = ::new (frame) node{list.head};
+                    ++list.count;
+
+                    ++mStats.recycled;
+                    ++mStats.cached_frames;
+                    mStats.cached_bytes += rounded_size(bytes);
+
+                    return;
+                }
+            }
+
+            ++mStats.released;
+            ::operator delete(frame, rounded_size(bytes));
+        }
+
+        // Frees a frame taken from allocate() without going through any pool
+        static void release(void* frame, size_t bytes) noexcept
+        {
+            ::operator delete(frame, rounded_size(bytes));
+        }
+
+        // Frees every cached frame
+        void trim() noexcept
+        {
+            for (size_t sizeClass = 0; sizeClass < mLists.size(); ++sizeClass)
+            {
+                auto& list = mLists[sizeClass];
+                while (list.head != nullptr)
+                {
+                    auto* next = list.head->next;
+                    ::operator delete(list.head, (sizeClass + 1) * granularity);
+                    list.head = next;
+                }
+                list.count = 0;
+            }
+
+            mStats.cached_frames = 0;
+            mStats.cached_bytes = 0;
+        }
+
+        size_t capacity() const noexcept
+        {
+            return mCapacity;
+        }
+
+        // Changes the number of frames kept per size class, 0 disables recycling
+        void set_capacity(size_t capacity) noexcept
+        {
+            mCapacity = capacity;
+            if (capacity == 0)
+            {
+                trim();
+            }
+        }
+
+        const frame_pool_stats& stats() const noexcept
+        {
+            return mStats;
+        }
+
+        // Number of frames of the given size waiting for reuse
+        size_t cached(size_t bytes) const noexcept
+        {
+            return bytes <= max_frame_size ? mLists[size_class(bytes)].count : 0;
+        }
+
+    private:
+        struct node
+        {
+            node* next;
+        };
+
+        struct free_list
+        {
+            node* head = nullptr;
+            size_t count = 0;
+        };
+
+        static constexpr size_t size_class(size_t bytes) noexcept
+        {
+            return bytes == 0 ? 0 : (bytes - 1) / granularity;
+        }
+
+        static constexpr size_t rounded_size(size_t bytes) noexcept
+        {
+            return bytes <= max_frame_size ? (size_class(bytes) + 1) * granularity : bytes;
+        }
+
+        std::array<free_list, max_frame_size / granularity> mLists{};
+        size_t mCapacity = GENTOOLS_FRAME_POOL_CAPACITY;
+        frame_pool_stats mStats{};
+    };
+
+    namespace detail
+    {
+        // Trivially destructible, so it can still be read while thread_local and static objects
+        // are being destroyed
+        inline bool& thread_frame_pool_destroyed() noexcept
+        {
+            thread_local bool destroyed = false;
+            return destroyed;
+        }
+
+        struct thread_frame_pool_holder
+        {
+            ~thread_frame_pool_holder()
+            {
+                thread_frame_pool_destroyed() = true;
+            }
+
+            frame_pool pool{};
+        };
+    }
+
+    inline frame_pool& thread_frame_pool() noexcept
+    {
+        thread_local detail::thread_frame_pool_holder holder{};
+        return holder.pool;
+    }
+
+    /*
+       False once the thread_frame_pool() of this thread has been destroyed. On the main thread
+       that happens before static objects are destroyed, so generators owned by statics must not
+       touch the pool anymore when they are freed.
+    */
+    inline bool thread_frame_pool_alive() noexcept
+    {
+        return !detail::thread_frame_pool_destroyed();
+    }
+
+} //namespace gentools
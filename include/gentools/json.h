@@ -0,0 +1,810 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <gentools.h>
+#include <gentools/json_pointer.h>
+#include <json/json.hpp>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/*
+   Traversal of nlohmann::json documents. The header needs nlohmann/json on the include path as
+   <json/json.hpp>, like the sample, which ships a copy in sample/thirdparty/json/include.
+*/
+
+namespace gentools
+{
+    // A structured value, an object or an array, of the document
+    using json_ref = std::reference_wrapper<const nlohmann::json>;
+
+    /*
+       A value of the document in 16 bytes: an 8 byte payload, the length of strings and a tag.
+       Strings are views into the document, objects and arrays references to it. The value is
+       read with is<T>(), get<T>() or visit() as T is one of double, uint64_t, int64_t, bool,
+       std::nullptr_t, std::string_view or json_ref; get() throws std::bad_variant_access for
+       another type. Two values are equal when their types are the same and their numbers or
+       strings are equal or they reference the same object or array.
+    */
+    class json_value
+    {
+    public:
+        enum class kind : uint8_t
+        {
+            number_float,
+            number_unsigned,
+            number_integer,
+            boolean,
+            null,
+            string,
+            structured
+        };
+
+        constexpr json_value() noexcept
+            : mUnsigned(0)
+            , mKind(kind::null)
+        {
+        }
+
+        constexpr json_value(std::nullptr_t) noexcept
+            : json_value()
+        {
+        }
+
+        constexpr json_value(double value) noexcept
+            : mDouble(value)
+            , mKind(kind::number_float)
+        {
+        }
+
+        // any integer type, so json_value{5} is not ambiguous between the number constructors
+        template <std::unsigned_integral U>
+            requires (!std::same_as<U, bool>)
+        constexpr json_value(U value) noexcept
+            : mUnsigned(value)
+            , mKind(kind::number_unsigned)
+        {
+        }
+
+        template <std::signed_integral I>
+        constexpr json_value(I value) noexcept
+            : mInteger(value)
+            , mKind(kind::number_integer)
+        {
+        }
+
+        // exactly bool, so pointers do not convert to it
+        template <std::same_as<bool> B>
+        constexpr json_value(B value) noexcept
+            : mBoolean(value)
+            , mKind(kind::boolean)
+        {
+        }
+
+        // Strings of 4 GB and more throw std::length_error
+        json_value(std::string_view value)
+            : mChars(value.data())
+            , mSize(static_cast<uint32_t>(value.size()))
+            , mKind(kind::string)
+        {
+            if (value.size() > std::numeric_limits<uint32_t>::max())
+            {
+                throw std::length_error("json_value: string too long");
+            }
+        }
+
+        constexpr json_value(json_ref value) noexcept
+            : mJson(&value.get())
+            , mKind(kind::structured)
+        {
+        }
+
+        constexpr kind type() const noexcept
+        {
+            return mKind;
+        }
+
+        template <typename T>
+        constexpr bool is() const noexcept
+        {
+            return mKind == kind_of<T>();
+        }
+
+        template <typename T>
+        T get() const
+        {
+            if (!is<T>())
+            {
+                throw std::bad_variant_access{};
+            }
+
+            if constexpr (std::is_same_v<T, double>)
+            {
+                return mDouble;
+            }
+            else if constexpr (std::is_same_v<T, uint64_t>)
+            {
+                return mUnsigned;
+            }
+            else if constexpr (std::is_same_v<T, int64_t>)
+            {
+                return mInteger;
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                return mBoolean;
+            }
+            else if constexpr (std::is_same_v<T, std::nullptr_t>)
+            {
+                return nullptr;
+            }
+            else if constexpr (std::is_same_v<T, std::string_view>)
+            {
+                return std::string_view{mChars, mSize};
+            }
+            else
+            {
+                return json_ref{*mJson};
+            }
+        }
+
+        // Calls func with the value as its type; func must return the same type for every one
+        template <typename F>
+        decltype(auto) visit(F&& func) const
+        {
+            switch (mKind)
+            {
+            case kind::number_float:
+                return func(mDouble);
+            case kind::number_unsigned:
+                return func(mUnsigned);
+            case kind::number_integer:
+                return func(mInteger);
+            case kind::boolean:
+                return func(mBoolean);
+            case kind::string:
+                return func(std::string_view{mChars, mSize});
+            case kind::structured:
+                return func(json_ref{*mJson});
+            default:
+                return func(nullptr);
+            }
+        }
+
+        friend bool operator==(const json_value& left, const json_value& right) noexcept
+        {
+            // nlohmann parses every non-negative integer as unsigned, so integers compare by value
+            // whatever their kind
+            if (left.is_integer() && right.is_integer())
+            {
+                const bool leftUnsigned = left.mKind == kind::number_unsigned;
+                const bool rightUnsigned = right.mKind == kind::number_unsigned;
+                return leftUnsigned
+                    ? (rightUnsigned ? left.mUnsigned == right.mUnsigned : std::cmp_equal(left.mUnsigned, right.mInteger))
+                    : (rightUnsigned ? std::cmp_equal(left.mInteger, right.mUnsigned) : left.mInteger == right.mInteger);
+            }
+            if (left.mKind != right.mKind)
+            {
+                return false;
+            }
+            switch (left.mKind)
+            {
+            case kind::number_float:
+                return left.mDouble == right.mDouble;
+            case kind::boolean:
+                return left.mBoolean == right.mBoolean;
+            case kind::null:
+                return true;
+            case kind::string:
+                return std::string_view{left.mChars, left.mSize} == std::string_view{right.mChars, right.mSize};
+            default:
+                return left.mJson == right.mJson;
+            }
+        }
+
+    private:
+        constexpr bool is_integer() const noexcept
+        {
+            return mKind == kind::number_unsigned || mKind == kind::number_integer;
+        }
+
+        template <typename T>
+        static constexpr kind kind_of() noexcept
+        {
+            if constexpr (std::is_same_v<T, double>)
+            {
+                return kind::number_float;
+            }
+            else if constexpr (std::is_same_v<T, uint64_t>)
+            {
+                return kind::number_unsigned;
+            }
+            else if constexpr (std::is_same_v<T, int64_t>)
+            {
+                return kind::number_integer;
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                return kind::boolean;
+            }
+            else if constexpr (std::is_same_v<T, std::nullptr_t>)
+            {
+                return kind::null;
+            }
+            else if constexpr (std::is_same_v<T, std::string_view>)
+            {
+                return kind::string;
+            }
+            else
+            {
+                static_assert(std::is_same_v<T, json_ref>, "json_value holds no such type");
+                return kind::structured;
+            }
+        }
+
+        union
+        {
+            double mDouble;
+            uint64_t mUnsigned;
+            int64_t mInteger;
+            bool mBoolean;
+            const char* mChars;
+            const nlohmann::json* mJson;
+        };
+        uint32_t mSize = 0;
+        kind mKind;
+    };
+
+    static_assert(sizeof(json_value) == 16);
+
+    inline json_value to_json_value(const nlohmann::json& json)
+    {
+        switch (json.type())
+        {
+        case nlohmann::json::value_t::object:
+        case nlohmann::json::value_t::array:
+            return std::cref(json);
+        case nlohmann::json::value_t::boolean:
+            return json.get_ref<const nlohmann::json::boolean_t&>();
+        case nlohmann::json::value_t::number_float:
+            return json.get_ref<const nlohmann::json::number_float_t&>();
+        case nlohmann::json::value_t::number_unsigned:
+            return json.get_ref<const nlohmann::json::number_unsigned_t&>();
+        case nlohmann::json::value_t::number_integer:
+            return json.get_ref<const nlohmann::json::number_integer_t&>();
+        case nlohmann::json::value_t::string:
+            return std::string_view{json.get_ref<const nlohmann::json::string_t&>()};
+        default:
+            return nullptr;
+        }
+    }
+
+    // A member of an object of the document
+    struct json_item
+    {
+        std::string_view key;
+        json_value value;
+    };
+
+    namespace detail
+    {
+        using json_members = std::pair<nlohmann::json::const_iterator, nlohmann::json::const_iterator>;
+
+        inline generator<json_item> traverse(std::pmr::memory_resource* resource, const nlohmann::json& root)
+        {
+            detail::stage_probe probe{"traverse"};
+            if (!root.is_object() || root.empty())
+            {
+                co_return;
+            }
+
+            // one entry per object being walked, so it only grows with the depth of the document
+            std::pmr::vector<json_members> stack{resource};
+            stack.reserve(16);
+            stack.emplace_back(root.cbegin(), root.cend());
+
+            while (!stack.empty())
+            {
+                auto& [member, end] = stack.back();
+                if (member == end)
+                {
+                    stack.pop_back();
+                    continue;
+                }
+
+                const nlohmann::json& value = member.value();
+                const std::string& key = member.key();
+                ++member;
+
+                probe.element_in();
+                co_yield probe.yield(json_item{key, to_json_value(value)});
+                probe.resume();
+
+                if (value.is_object() && !value.empty())
+                {
+                    // invalidates member and end
+                    stack.emplace_back(value.cbegin(), value.cend());
+                }
+            }
+        }
+    }
+
+    /*
+       Walks the objects of root depth first, in document order, and yields each member before
+       the members of its value when that is an object. Keys and string values are views into
+       root, which must outlive the generator; nothing is copied and the only allocation is the
+       stack of the objects being walked.
+    */
+    inline generator<json_item> traverse(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                         const nlohmann::json& root)
+    {
+        frame_resource_scope scope{resource};
+        return detail::traverse(resource, root);
+    }
+
+    inline generator<json_item> traverse(const nlohmann::json& root)
+    {
+        return detail::traverse(current_frame_resource(), root);
+    }
+
+    // A value of the document with its JSON pointer (RFC 6901), such as "/answer/everything" or "/list/0"
+    struct json_path_item
+    {
+        std::string_view path;
+        json_value value;
+    };
+
+    namespace detail
+    {
+        // An object or array being walked, with the length of its path
+        struct json_frame
+        {
+            const nlohmann::json* container;
+            nlohmann::json::const_iterator child;
+            size_t index;
+            size_t pathLength;
+        };
+
+        inline generator<json_path_item> traverse_paths(std::pmr::memory_resource* resource, const nlohmann::json& root)
+        {
+            detail::stage_probe probe{"traverse_paths"};
+            if (!root.is_structured() || root.empty())
+            {
+                co_return;
+            }
+
+            std::pmr::vector<json_frame> stack{resource};
+            stack.reserve(16);
+            stack.push_back({&root, root.cbegin(), 0, 0});
+
+            // the path of the current value; the path of each frame is a prefix of it
+            std::pmr::string path{resource};
+            path.reserve(256);
+
+            while (!stack.empty())
+            {
+                auto& frame = stack.back();
+                if (frame.child == frame.container->cend())
+                {
+                    stack.pop_back();
+                    continue;
+                }
+
+                path.resize(frame.pathLength);
+                if (frame.container->is_object())
+                {
+                    append_pointer_token(path, frame.child.key());
+                }
+                else
+                {
+                    append_pointer_token(path, frame.index);
+                }
+
+                const nlohmann::json& value = *frame.child;
+                ++frame.child;
+                ++frame.index;
+
+                probe.element_in();
+                co_yield probe.yield(json_path_item{path, to_json_value(value)});
+                probe.resume();
+
+                if (value.is_structured() && !value.empty())
+                {
+                    // invalidates frame
+                    stack.push_back({&value, value.cbegin(), 0, path.size()});
+                }
+            }
+        }
+    }
+
+    /*
+       Walks root depth first, in document order, into objects and arrays alike, and yields every
+       value but root with its JSON pointer. The paths are views into one buffer the generator
+       extends and truncates as it goes down and up the document, so a path is only valid until
+       the next value is requested.
+    */
+    inline generator<json_path_item> traverse_paths(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                                    const nlohmann::json& root)
+    {
+        frame_resource_scope scope{resource};
+        return detail::traverse_paths(resource, root);
+    }
+
+    inline generator<json_path_item> traverse_paths(const nlohmann::json& root)
+    {
+        return detail::traverse_paths(current_frame_resource(), root);
+    }
+
+    enum class traversal_order
+    {
+        // every value before its children and their siblings, the order of traverse_paths()
+        depth_first,
+        // the values one depth after the other, each depth in document order
+        breadth_first
+    };
+
+    struct traversal_options
+    {
+        traversal_order order = traversal_order::depth_first;
+        // the deepest values yielded, 1 for the children of root; deeper containers are not entered
+        size_t max_depth = std::numeric_limits<size_t>::max();
+    };
+
+    namespace detail
+    {
+        class json_partitioner;
+        class json_walker;
+    }
+
+    /*
+       A range of consecutive children of an object or an array of a document, with their
+       subtrees, the unit of work of the parallel traversals. The partitions of json_partitions()
+       cover every value of the document once and, walked one after the other, visit them in
+       document order. When split_last() is true the contents of the last child are left out,
+       since they are cut into partitions of their own, which follow.
+    */
+    class json_partition
+    {
+    public:
+        // All the children of document, which is the whole of it but its root
+        explicit json_partition(const nlohmann::json& document)
+            : json_partition(document, document.is_structured() ? document.cbegin() : document.cend(), document.cend(),
+                             0, 1, {}, false)
+        {
+        }
+
+        const nlohmann::json& container() const noexcept
+        {
+            return *mContainer;
+        }
+
+        nlohmann::json::const_iterator begin() const noexcept
+        {
+            return mFirst;
+        }
+
+        nlohmann::json::const_iterator end() const noexcept
+        {
+            return mLast;
+        }
+
+        // The position of the first child in the container
+        size_t index() const noexcept
+        {
+            return mIndex;
+        }
+
+        // Number of containers around the children, 1 for the children of the root
+        size_t depth() const noexcept
+        {
+            return mDepth;
+        }
+
+        // The JSON pointer of the container, "" for the root
+        std::string_view path() const noexcept
+        {
+            return mPath;
+        }
+
+        bool split_last() const noexcept
+        {
+            return mSplitLast;
+        }
+
+    private:
+        friend class detail::json_partitioner;
+
+        json_partition(const nlohmann::json& container, nlohmann::json::const_iterator first,
+                       nlohmann::json::const_iterator last, size_t index, size_t depth, std::string path,
+                       bool splitLast)
+            : mContainer(&container)
+            , mFirst(first)
+            , mLast(last)
+            , mIndex(index)
+            , mDepth(depth)
+            , mPath(std::move(path))
+            , mSplitLast(splitLast)
+        {
+        }
+
+        const nlohmann::json* mContainer;
+        nlohmann::json::const_iterator mFirst;
+        nlohmann::json::const_iterator mLast;
+        size_t mIndex;
+        size_t mDepth;
+        std::string mPath;
+        bool mSplitLast;
+    };
+
+    namespace detail
+    {
+        class json_partitioner
+        {
+        public:
+            static generator<json_partition> partitions(std::pmr::memory_resource* resource, const nlohmann::json& root,
+                                                        size_t size)
+            {
+                struct frame
+                {
+                    const nlohmann::json* container;
+                    nlohmann::json::const_iterator child;
+                    size_t index;
+                    size_t depth;
+                    std::string path;
+                };
+
+                detail::stage_probe probe{"json_partitions"};
+                if (!root.is_structured() || root.empty())
+                {
+                    co_return;
+                }
+                size = std::max(size, size_t{1});
+
+                // the containers being cut, the root and the large containers inside the partitions
+                std::pmr::vector<frame> stack{resource};
+                stack.push_back({&root, root.cbegin(), 0, 1, {}});
+
+                while (!stack.empty())
+                {
+                    auto& current = stack.back();
+                    if (current.child == current.container->cend())
+                    {
+                        stack.pop_back();
+                        continue;
+                    }
+
+                    const auto first = current.child;
+                    const size_t index = current.index;
+                    const nlohmann::json* split = nullptr;
+                    std::string splitPath{};
+                    for (size_t count = 0; count < size && current.child != current.container->cend(); ++count)
+                    {
+                        const nlohmann::json& value = *current.child;
+                        if (value.is_structured() && value.size() > size)
+                        {
+                            split = &value;
+                            splitPath = current.path;
+                            if (current.container->is_object())
+                            {
+                                append_pointer_token(splitPath, current.child.key());
+                            }
+                            else
+                            {
+                                append_pointer_token(splitPath, current.index);
+                            }
+                        }
+                        ++current.child;
+                        ++current.index;
+                        if (split != nullptr)
+                        {
+                            break;
+                        }
+                    }
+
+                    probe.element_in();
+                    const json_partition partition{*current.container, first, current.child, index, current.depth,
+                                                   current.path, split != nullptr};
+                    co_yield probe.yield(partition);
+                    probe.resume();
+
+                    if (split != nullptr)
+                    {
+                        // invalidates current
+                        const size_t depth = current.depth + 1;
+                        stack.push_back({split, split->cbegin(), 0, depth, std::move(splitPath)});
+                    }
+                }
+            }
+        };
+    }
+
+    /*
+       Cuts root into partitions of up to size children of its containers, for the workers of
+       parallel_traverse() and parallel_query(). The children of root are cut in ranges, and so,
+       in turn, are the children of any of them with more than size children, so a root object
+       holding one huge array is cut as finely as a huge root array. Other values are left whole
+       in the partition of their parent, however large their own subtrees.
+    */
+    inline generator<json_partition> json_partitions(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                                     const nlohmann::json& root, size_t size)
+    {
+        frame_resource_scope scope{resource};
+        return detail::json_partitioner::partitions(resource, root, size);
+    }
+
+    inline generator<json_partition> json_partitions(const nlohmann::json& root, size_t size)
+    {
+        return detail::json_partitioner::partitions(current_frame_resource(), root, size);
+    }
+
+    /*
+       A value of the document yielded by traverse_nodes(), with its key or its position in its
+       container and its depth. It is only valid until the next value is requested.
+    */
+    class json_node
+    {
+    public:
+        // The key of a member, empty for an array element
+        std::string_view key() const noexcept
+        {
+            return mKey;
+        }
+
+        // The position in its object or array
+        size_t index() const noexcept
+        {
+            return mIndex;
+        }
+
+        // Number of containers around the value, 1 for the children of root
+        size_t depth() const noexcept
+        {
+            return mDepth;
+        }
+
+        const nlohmann::json& json() const noexcept
+        {
+            return *mJson;
+        }
+
+        json_value value() const
+        {
+            return to_json_value(*mJson);
+        }
+
+        /*
+           On an object or an array, makes the traversal pass over its contents without yielding
+           or visiting any of them. Does nothing on other values.
+        */
+        void skip_children() const noexcept
+        {
+            *mSkip = true;
+        }
+
+    private:
+        friend class detail::json_walker;
+
+        json_node(std::string_view key, size_t index, size_t depth, const nlohmann::json& json, bool& skip) noexcept
+            : mKey(key)
+            , mIndex(index)
+            , mDepth(depth)
+            , mJson(&json)
+            , mSkip(&skip)
+        {
+        }
+
+        std::string_view mKey;
+        size_t mIndex;
+        size_t mDepth;
+        const nlohmann::json* mJson;
+        bool* mSkip;
+    };
+
+    namespace detail
+    {
+        class json_walker
+        {
+        public:
+            static generator<json_node> walk(std::pmr::memory_resource* resource, json_partition partition,
+                                             traversal_options options)
+            {
+                struct frame
+                {
+                    const nlohmann::json* container;
+                    nlohmann::json::const_iterator child;
+                    nlohmann::json::const_iterator end;
+                    size_t index;
+                    size_t depth;
+                };
+
+                detail::stage_probe probe{"traverse_nodes"};
+                if (partition.begin() == partition.end() || partition.depth() > options.max_depth)
+                {
+                    co_return;
+                }
+
+                // the containers being walked: depth first takes the last one, as a stack, and
+                // breadth first the first one, as a queue, so one loop serves both orders
+                const bool breadthFirst = options.order == traversal_order::breadth_first;
+                std::pmr::deque<frame> pending{resource};
+                pending.push_back(
+                    {&partition.container(), partition.begin(), partition.end(), partition.index(), partition.depth()});
+
+                bool skip = false;
+                while (!pending.empty())
+                {
+                    auto& current = breadthFirst ? pending.front() : pending.back();
+                    if (current.child == current.end)
+                    {
+                        breadthFirst ? pending.pop_front() : pending.pop_back();
+                        continue;
+                    }
+
+                    const std::string_view key =
+                        current.container->is_object() ? std::string_view{current.child.key()} : std::string_view{};
+                    const nlohmann::json& value = *current.child;
+                    const size_t index = current.index;
+                    const size_t depth = current.depth;
+                    ++current.child;
+                    ++current.index;
+                    // the contents of a split last child belong to the partitions that follow
+                    skip = partition.split_last() && depth == partition.depth() && current.child == current.end;
+                    probe.element_in();
+                    const json_node node{key, index, depth, value, skip};
+                    co_yield probe.yield(node);
+                    probe.resume();
+
+                    if (!skip && depth < options.max_depth && value.is_structured() && !value.empty())
+                    {
+                        pending.push_back({&value, value.cbegin(), value.cend(), 0, depth + 1});
+                    }
+                }
+            }
+        };
+    }
+
+    /*
+       Walks root into objects and arrays alike and yields every value but root, in the order and
+       down to the depth of options. Calling skip_children() on a yielded object or array passes
+       over its contents, so a caller that only needs a few members of a large document does not
+       walk the rest of it. Keys are views into root, which must outlive the generator; the only
+       allocation is the stack, or queue, of the containers being walked.
+    */
+    inline generator<json_node> traverse_nodes(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                               const nlohmann::json& root, traversal_options options = {})
+    {
+        frame_resource_scope scope{resource};
+        return detail::json_walker::walk(resource, json_partition{root}, options);
+    }
+
+    inline generator<json_node> traverse_nodes(const nlohmann::json& root, traversal_options options = {})
+    {
+        return detail::json_walker::walk(current_frame_resource(), json_partition{root}, options);
+    }
+
+    // Same as above over the values of a partition, with the depths they have in the document
+    inline generator<json_node> traverse_nodes(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                               const json_partition& partition, traversal_options options = {})
+    {
+        frame_resource_scope scope{resource};
+        return detail::json_walker::walk(resource, partition, options);
+    }
+
+    inline generator<json_node> traverse_nodes(const json_partition& partition, traversal_options options = {})
+    {
+        return detail::json_walker::walk(current_frame_resource(), partition, options);
+    }
+
+} //namespace gentools
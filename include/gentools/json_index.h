@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <gentools/json_pointer.h>
+#include <json/json.hpp>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gentools
+{
+    /*
+       An index of a nlohmann::json document built in one depth first pass: every value is a node,
+       numbered in document order from the root, node 0, and every distinct key is interned to an
+       integer id. The nodes of each key are listed in document order, and the parent, depth, key
+       id and position in its container of each node are kept in one array per field.
+       The index refers to the keys and values of the document, which must outlive it and not be
+       modified while it is in use.
+    */
+    class json_index
+    {
+    public:
+        using node_id = uint32_t;
+        using key_id = uint32_t;
+
+        // The key of array elements and of the root, and find_key() of a key absent from the document
+        static constexpr key_id no_key = std::numeric_limits<key_id>::max();
+
+        explicit json_index(const nlohmann::json& document)
+            : mDocument(&document)
+        {
+            build();
+        }
+
+        const nlohmann::json& document() const noexcept
+        {
+            return *mDocument;
+        }
+
+        // The number of nodes, the root included
+        size_t size() const noexcept
+        {
+            return mValues.size();
+        }
+
+        size_t key_count() const noexcept
+        {
+            return mKeyNames.size();
+        }
+
+        key_id find_key(std::string_view key) const noexcept
+        {
+            const auto found = mKeyIds.find(key);
+            return found != mKeyIds.end() ? found->second : no_key;
+        }
+
+        std::string_view key_name(key_id key) const noexcept
+        {
+            return key != no_key ? mKeyNames[key] : std::string_view{};
+        }
+
+        // The members with the given key, in document order
+        std::span<const node_id> nodes(key_id key) const noexcept
+        {
+            if (key == no_key)
+            {
+                return {};
+            }
+            return std::span<const node_id>{mKeyNodes}.subspan(mKeyOffsets[key], mKeyOffsets[key + 1] - mKeyOffsets[key]);
+        }
+
+        std::span<const node_id> nodes(std::string_view key) const noexcept
+        {
+            return nodes(find_key(key));
+        }
+
+        const nlohmann::json& value(node_id node) const noexcept
+        {
+            return *mValues[node];
+        }
+
+        // The parent of every node, the root is its own parent
+        std::span<const node_id> parents() const noexcept
+        {
+            return mParents;
+        }
+
+        // The number of containers around every node, 0 for the root
+        std::span<const uint32_t> depths() const noexcept
+        {
+            return mDepths;
+        }
+
+        std::span<const key_id> keys() const noexcept
+        {
+            return mKeys;
+        }
+
+        // The position of every node in its object or array
+        std::span<const uint32_t> positions() const noexcept
+        {
+            return mPositions;
+        }
+
+        // Appends the JSON pointer of node to path, which holds no more than the pointer of a container
+        template <typename String>
+        void append_path(String& path, node_id node) const
+        {
+            const size_t start = path.size();
+            for (; node != 0; node = mParents[node])
+            {
+                // the tokens are appended leaf first, then reversed as a whole, each token reversed back
+                const size_t tokenStart = path.size();
+                if (mKeys[node] != no_key)
+                {
+                    detail::append_pointer_token(path, mKeyNames[mKeys[node]]);
+                }
+                else
+                {
+                    detail::append_pointer_token(path, size_t{mPositions[node]});
+                }
+                std::reverse(path.begin() + tokenStart, path.end());
+            }
+            std::reverse(path.begin() + start, path.end());
+        }
+
+        std::string path(node_id node) const
+        {
+            std::string result{};
+            append_path(result, node);
+            return result;
+        }
+
+    private:
+        void build()
+        {
+            struct frame
+            {
+                nlohmann::json::const_iterator child;
+                node_id node;
+                uint32_t position;
+            };
+
+            add_node(*mDocument, 0, 0, no_key, 0);
+            std::vector<frame> stack{};
+            if (mDocument->is_structured())
+            {
+                stack.push_back({mDocument->cbegin(), 0, 0});
+            }
+
+            // the nodes of every key, before they are laid out one key after the other
+            std::vector<uint32_t> keyCounts{};
+            while (!stack.empty())
+            {
+                auto& parent = stack.back();
+                const nlohmann::json& container = *mValues[parent.node];
+                if (parent.child == container.cend())
+                {
+                    stack.pop_back();
+                    continue;
+                }
+
+                key_id key = no_key;
+                if (container.is_object())
+                {
+                    const std::string_view name = parent.child.key();
+                    const auto [found, added] = mKeyIds.try_emplace(name, static_cast<key_id>(mKeyNames.size()));
+                    if (added)
+                    {
+                        mKeyNames.push_back(name);
+                        keyCounts.push_back(0);
+                    }
+                    key = found->second;
+                    ++keyCounts[key];
+                }
+
+                const nlohmann::json& value = *parent.child;
+                const node_id node = add_node(value, parent.node, mDepths[parent.node] + 1, key, parent.position);
+                ++parent.child;
+                ++parent.position;
+
+                if (value.is_structured())
+                {
+                    // invalidates parent
+                    stack.push_back({value.cbegin(), node, 0});
+                }
+            }
+
+            // counting sort of the members by key, stable so each list stays in document order
+            mKeyOffsets.assign(mKeyNames.size() + 1, 0);
+            for (size_t key = 0; key < keyCounts.size(); ++key)
+            {
+                mKeyOffsets[key + 1] = mKeyOffsets[key] + keyCounts[key];
+            }
+            mKeyNodes.resize(mKeyOffsets.back());
+            std::vector<uint32_t> next(mKeyOffsets.begin(), mKeyOffsets.end() - 1);
+            for (node_id node = 0; node < mKeys.size(); ++node)
+            {
+                if (mKeys[node] != no_key)
+                {
+                    mKeyNodes[next[mKeys[node]]++] = node;
+                }
+            }
+        }
+
+        node_id add_node(const nlohmann::json& value, node_id parent, uint32_t depth, key_id key, uint32_t position)
+        {
+            if (mValues.size() == std::numeric_limits<node_id>::max())
+            {
+                throw std::length_error("json_index: too many values");
+            }
+            mValues.push_back(&value);
+            mParents.push_back(parent);
+            mDepths.push_back(depth);
+            mKeys.push_back(key);
+            mPositions.push_back(position);
+            return static_cast<node_id>(mValues.size() - 1);
+        }
+
+        const nlohmann::json* mDocument;
+
+        std::unordered_map<std::string_view, key_id> mKeyIds{};
+        std::vector<std::string_view> mKeyNames{};
+        // the members of key k are mKeyNodes[mKeyOffsets[k]] to mKeyNodes[mKeyOffsets[k + 1]]
+        std::vector<uint32_t> mKeyOffsets{};
+        std::vector<node_id> mKeyNodes{};
+
+        // one entry per node
+        std::vector<const nlohmann::json*> mValues{};
+        std::vector<node_id> mParents{};
+        std::vector<uint32_t> mDepths{};
+        std::vector<key_id> mKeys{};
+        std::vector<uint32_t> mPositions{};
+    };
+
+} //namespace gentools
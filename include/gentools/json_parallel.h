@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <gentools.h>
+#include <gentools/json.h>
+#include <gentools/json_query.h>
+#include <gentools/parallel.h>
+#include <gentools/thread_pool.h>
+#include <json/json.hpp>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gentools
+{
+    struct json_parallel_options
+    {
+        // the children of a container per partition, see json_partitions()
+        size_t partition_size = 1024;
+        // partitions in flight, 0 for 4 per worker
+        size_t window = 0;
+        // the workers of the pool the generator owns when it is not given one, 0 for one per hardware thread
+        size_t threads = 0;
+        // whether the results are yielded in document order, or as soon as they are ready
+        bool ordered = true;
+    };
+
+    namespace detail
+    {
+        template <typename F>
+        using json_partition_result_t = range_value_invoke_result_t<generator<json_partition>, F>;
+
+        template <typename F>
+        generator<json_partition_result_t<F>> parallel_traverse(thread_pool* pool, const nlohmann::json& root, F func,
+                                                                json_parallel_options options)
+        {
+            return detail::parallel_transform<generator<json_partition>, F>(
+                pool, options.threads, json_partitions(root, options.partition_size), std::move(func), options.window,
+                options.ordered);
+        }
+
+        // The matches of a partition; their paths are copied into one buffer, as the generator that made them is gone
+        struct json_match_batch
+        {
+            std::vector<json_match> matches;
+            std::string paths;
+            // the path of matches[i] is paths[pathEnds[i - 1], pathEnds[i])
+            std::vector<size_t> pathEnds;
+        };
+
+        // Runs on a pool worker
+        inline json_match_batch json_query_batch(const json_query& query, const json_partition& partition)
+        {
+            json_match_batch batch{};
+            for (const auto& match : query(partition))
+            {
+                batch.matches.push_back({match.key, {}, match.value, match.depth});
+                batch.paths.append(match.path);
+                batch.pathEnds.push_back(batch.paths.size());
+            }
+            return batch;
+        }
+
+        // The query is copied into the frame, so it may be a temporary
+        inline generator<json_match> parallel_query(thread_pool* pool, json_query query, const nlohmann::json& document,
+                                                    json_parallel_options options)
+        {
+            detail::stage_probe probe{"parallel_query"};
+            auto run = [&query](const json_partition& partition) { return json_query_batch(query, partition); };
+
+            for (const auto& batch : detail::parallel_traverse(pool, document, run, options))
+            {
+                const std::string_view paths = batch.paths;
+                size_t pathStart = 0;
+                for (size_t i = 0; i < batch.matches.size(); ++i)
+                {
+                    json_match match = batch.matches[i];
+                    match.path = paths.substr(pathStart, batch.pathEnds[i] - pathStart);
+                    pathStart = batch.pathEnds[i];
+
+                    probe.element_in();
+                    co_yield probe.yield(match);
+                    probe.resume();
+                }
+            }
+        }
+    }
+
+    /*
+       Walks root on the workers of pool: root is cut into partitions by json_partitions(), with
+       options.partition_size children each, and func is called on every partition by one task,
+       typically to walk it with traverse_nodes() or a json_query and return a partial aggregate.
+       The results are yielded in document order, or as soon as they are ready when options.ordered
+       is false, with at most options.window partitions in flight, as in parallel_transform.
+       func is called concurrently; root must outlive the generator and not be modified while it runs.
+    */
+    template <typename F>
+        requires std::is_invocable_v<F&, const json_partition&>
+    generator<detail::json_partition_result_t<std::decay_t<F>>> parallel_traverse(thread_pool& pool,
+                                                                                  const nlohmann::json& root, F&& func,
+                                                                                  json_parallel_options options = {})
+    {
+        return detail::parallel_traverse<std::decay_t<F>>(&pool, root, std::forward<F>(func), options);
+    }
+
+    // Same as above on a pool of options.threads workers owned by the generator
+    template <typename F>
+        requires std::is_invocable_v<F&, const json_partition&>
+    generator<detail::json_partition_result_t<std::decay_t<F>>> parallel_traverse(const nlohmann::json& root, F&& func,
+                                                                                  json_parallel_options options = {})
+    {
+        return detail::parallel_traverse<std::decay_t<F>>(nullptr, root, std::forward<F>(func), options);
+    }
+
+    /*
+       Runs query over document on the workers of pool, one task per partition as in
+       parallel_traverse(), and yields the same matches as query(document), in the same order
+       unless options.ordered is false. The paths of the matches are views into a buffer of the
+       partition, valid until the next match is requested.
+    */
+    inline generator<json_match> parallel_query(thread_pool& pool, const json_query& query,
+                                                const nlohmann::json& document, json_parallel_options options = {})
+    {
+        return detail::parallel_query(&pool, query, document, options);
+    }
+
+    inline generator<json_match> parallel_query(const json_query& query, const nlohmann::json& document,
+                                                json_parallel_options options = {})
+    {
+        return detail::parallel_query(nullptr, query, document, options);
+    }
+
+} //namespace gentools
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+
+namespace gentools
+{
+    namespace detail
+    {
+        // Appends a key to a JSON pointer (RFC 6901), '~' and '/' escaped as "~0" and "~1"
+        template <typename String>
+        void append_pointer_token(String& path, std::string_view key)
+        {
+            path.push_back('/');
+            if (key.find_first_of("~/") == std::string_view::npos)
+            {
+                path.append(key);
+                return;
+            }
+            for (char c : key)
+            {
+                if (c == '~' || c == '/')
+                {
+                    path.push_back('~');
+                    path.push_back(c == '~' ? '0' : '1');
+                }
+                else
+                {
+                    path.push_back(c);
+                }
+            }
+        }
+
+        // Appends an array index to a JSON pointer
+        template <typename String>
+        void append_pointer_token(String& path, size_t index)
+        {
+            char digits[24];
+            path.push_back('/');
+            path.append(digits, std::to_chars(digits, digits + sizeof(digits), index).ptr);
+        }
+    }
+
+} //namespace gentools
@@ -0,0 +1,561 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <gentools.h>
+#include <gentools/json.h>
+#include <gentools/json_index.h>
+#include <gentools/json_pointer.h>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace gentools
+{
+    // What a where() clause tests
+    enum class json_field
+    {
+        // the key of an object member, empty for array elements
+        key,
+        value,
+        // the JSON pointer of the value
+        path,
+        // the number of containers around the value, 1 for the members of the root
+        depth
+    };
+
+    enum class json_op
+    {
+        equals,
+        not_equals,
+        less,
+        less_equal,
+        greater,
+        greater_equal,
+        // strings only
+        starts_with,
+        contains
+    };
+
+    // What the results of a query carry, the other fields are left empty
+    enum class json_select
+    {
+        all,
+        key,
+        value,
+        path
+    };
+
+    // A value matched by a json_query
+    struct json_match
+    {
+        std::string_view key;
+        std::string_view path;
+        json_value value;
+        size_t depth = 0;
+    };
+
+    namespace detail
+    {
+        inline bool json_compare(json_op op, std::partial_ordering order) noexcept
+        {
+            switch (op)
+            {
+            case json_op::equals:
+                return order == 0;
+            case json_op::not_equals:
+                return order != 0;
+            case json_op::less:
+                return order < 0;
+            case json_op::less_equal:
+                return order <= 0;
+            case json_op::greater:
+                return order > 0;
+            case json_op::greater_equal:
+                return order >= 0;
+            default:
+                return false;
+            }
+        }
+
+        inline bool json_compare(json_op op, std::string_view text, std::string_view operand) noexcept
+        {
+            switch (op)
+            {
+            case json_op::equals:
+                // the cheap rejections first: most keys differ in length or in their first byte
+                return text.size() == operand.size() && (text.empty() || text[0] == operand[0]) &&
+                       std::memcmp(text.data(), operand.data(), text.size()) == 0;
+            case json_op::starts_with:
+                return text.starts_with(operand);
+            case json_op::contains:
+                return text.find(operand) != std::string_view::npos;
+            default:
+                return json_compare(op, text <=> operand);
+            }
+        }
+
+        // nullptr_t converts to string_view too, but it is the operand of null values
+        template <typename V>
+        concept json_text_operand =
+            std::is_convertible_v<const V&, std::string_view> && !std::is_same_v<V, std::nullptr_t>;
+
+        // Orders a number of the document against a number operand, exactly when both are integers
+        template <typename V>
+        std::partial_ordering json_number_order(const json_value& value, V operand) noexcept
+        {
+            return value.visit(
+                [operand](const auto& number) -> std::partial_ordering {
+                    using N = std::decay_t<decltype(number)>;
+                    if constexpr (std::is_integral_v<N> && std::is_integral_v<V> && !std::is_same_v<N, bool>)
+                    {
+                        return std::cmp_less(number, operand)    ? std::partial_ordering::less
+                               : std::cmp_equal(number, operand) ? std::partial_ordering::equivalent
+                                                                 : std::partial_ordering::greater;
+                    }
+                    else if constexpr (std::is_arithmetic_v<N> && !std::is_same_v<N, bool>)
+                    {
+                        return static_cast<double>(number) <=> static_cast<double>(operand);
+                    }
+                    else
+                    {
+                        return std::partial_ordering::unordered;
+                    }
+                });
+        }
+
+        // Compiles the test of a value against operand, or returns an empty function when op does not apply to it
+        template <typename V>
+        std::function<bool(const json_value&)> json_value_test(json_op op, V&& operand)
+        {
+            using operand_type = std::decay_t<V>;
+            const bool ordering = op != json_op::starts_with && op != json_op::contains;
+            const bool equality = op == json_op::equals || op == json_op::not_equals;
+
+            if constexpr (json_text_operand<operand_type>)
+            {
+                return [op, text = std::string{std::string_view{operand}}](const json_value& value) {
+                    return value.is<std::string_view>() && json_compare(op, value.get<std::string_view>(), text);
+                };
+            }
+            else if constexpr (std::is_same_v<operand_type, bool>)
+            {
+                if (equality)
+                {
+                    return [op, operand](const json_value& value) {
+                        return value.is<bool>() && (value.get<bool>() == operand) == (op == json_op::equals);
+                    };
+                }
+            }
+            else if constexpr (std::is_same_v<operand_type, std::nullptr_t>)
+            {
+                if (equality)
+                {
+                    return [op](const json_value& value) {
+                        return value.is<std::nullptr_t>() == (op == json_op::equals);
+                    };
+                }
+            }
+            else if constexpr (std::is_arithmetic_v<operand_type>)
+            {
+                if (ordering)
+                {
+                    using number = std::conditional_t<std::is_floating_point_v<operand_type>, double,
+                                                      std::conditional_t<std::is_signed_v<operand_type>, int64_t, uint64_t>>;
+                    return [op, operand = static_cast<number>(operand)](const json_value& value) {
+                        const auto order = json_number_order(value, operand);
+                        return order != std::partial_ordering::unordered && json_compare(op, order);
+                    };
+                }
+            }
+            return {};
+        }
+    }
+
+    class json_query_builder;
+
+    /*
+       A query compiled by json_query_builder::select(). Each where() clause is a closure typed
+       on its operand, and the clauses on the path and the depth also prune the traversal: the
+       subtrees whose values cannot satisfy them are never walked. Calling the query walks a
+       document lazily and yields the values that satisfy every clause.
+       Over a json_index, a query with a key equals clause on a non-empty key only visits the
+       members with that key, and any other query scans the nodes of the index instead of walking
+       the document.
+    */
+    class json_query
+    {
+    public:
+        using predicate = std::function<bool(const json_match&)>;
+
+        // Runs the query over the document or the index given to from(), which must outlive the generator
+        generator<json_match> operator()() const
+        {
+            return mIndex != nullptr ? (*this)(*mIndex) : (*this)(*mDocument);
+        }
+
+        generator<json_match> operator()(const nlohmann::json& document) const
+        {
+            return run(current_frame_resource(), *this, json_partition{document});
+        }
+
+        generator<json_match> operator()(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                         const nlohmann::json& document) const
+        {
+            frame_resource_scope scope{resource};
+            return run(resource, *this, json_partition{document});
+        }
+
+        // Runs the query over the values of a partition, with their paths and depths in the document
+        generator<json_match> operator()(const json_partition& partition) const
+        {
+            return run(current_frame_resource(), *this, partition);
+        }
+
+        generator<json_match> operator()(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                         const json_partition& partition) const
+        {
+            frame_resource_scope scope{resource};
+            return run(resource, *this, partition);
+        }
+
+        generator<json_match> operator()(const json_index& index) const
+        {
+            return run(current_frame_resource(), *this, index);
+        }
+
+        generator<json_match> operator()(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                         const json_index& index) const
+        {
+            frame_resource_scope scope{resource};
+            return run(resource, *this, index);
+        }
+
+    private:
+        friend class json_query_builder;
+
+        // the query is copied into the frame, so it may be a temporary
+        static generator<json_match> run(std::pmr::memory_resource* resource, json_query query,
+                                         json_partition partition)
+        {
+            detail::stage_probe probe{"json_query"};
+            if (partition.begin() == partition.end() || partition.depth() > query.mMaxDepth)
+            {
+                co_return;
+            }
+
+            struct frame
+            {
+                const nlohmann::json* container;
+                nlohmann::json::const_iterator child;
+                nlohmann::json::const_iterator end;
+                size_t index;
+                size_t pathLength;
+                // whether the path already starts with the pruning prefix
+                bool covered;
+            };
+
+            const std::string_view prefix = query.mPathPrefix;
+            std::pmr::string path{resource};
+            path.reserve(query.mTrackPath ? 256 : 0);
+
+            bool covered = prefix.empty();
+            if (query.mTrackPath)
+            {
+                path = partition.path();
+                const size_t length = std::min(path.size(), prefix.size());
+                if (!covered && path.compare(0, length, prefix, 0, length) != 0)
+                {
+                    co_return;
+                }
+                covered = covered || path.size() >= prefix.size();
+            }
+
+            std::pmr::vector<frame> stack{resource};
+            stack.reserve(16);
+            stack.push_back(
+                {&partition.container(), partition.begin(), partition.end(), partition.index(), path.size(), covered});
+
+            while (!stack.empty())
+            {
+                auto& parent = stack.back();
+                if (parent.child == parent.end)
+                {
+                    stack.pop_back();
+                    continue;
+                }
+
+                const bool member = parent.container->is_object();
+                const std::string_view key = member ? std::string_view{parent.child.key()} : std::string_view{};
+                const nlohmann::json& value = *parent.child;
+                const size_t depth = partition.depth() + stack.size() - 1;
+                ++parent.child;
+                ++parent.index;
+                // the contents of a split last child belong to the partitions that follow
+                const bool split = partition.split_last() && stack.size() == 1 && parent.child == parent.end;
+
+                covered = parent.covered;
+                if (query.mTrackPath)
+                {
+                    path.resize(parent.pathLength);
+                    if (member)
+                    {
+                        detail::append_pointer_token(path, key);
+                    }
+                    else
+                    {
+                        detail::append_pointer_token(path, parent.index - 1);
+                    }
+
+                    if (!covered)
+                    {
+                        // the parent's path is a prefix of the pruning prefix, so only the new token is compared
+                        const size_t length = std::min(path.size(), prefix.size());
+                        if (path.compare(parent.pathLength, length - parent.pathLength, prefix, parent.pathLength,
+                                         length - parent.pathLength) != 0)
+                        {
+                            continue;
+                        }
+                        covered = path.size() >= prefix.size();
+                    }
+                }
+
+                probe.element_in();
+                const json_match match{key, path, to_json_value(value), depth};
+                bool selected = true;
+                for (const auto& test : query.mPredicates)
+                {
+                    if (!test(match))
+                    {
+                        selected = false;
+                        break;
+                    }
+                }
+
+                if (selected)
+                {
+                    co_yield probe.yield(query.project(match));
+                    probe.resume();
+                }
+
+                if (value.is_structured() && !value.empty() && depth < query.mMaxDepth && !split)
+                {
+                    // invalidates parent
+                    stack.push_back({&value, value.cbegin(), value.cend(), 0, path.size(), covered});
+                }
+            }
+        }
+
+        static generator<json_match> run(std::pmr::memory_resource* resource, json_query query, const json_index& index)
+        {
+            detail::stage_probe probe{"json_query"};
+
+            // the members with the key of the query, or else every node but the root
+            const bool keyed = query.mKey.has_value();
+            const auto candidates = keyed ? index.nodes(*query.mKey) : std::span<const json_index::node_id>{};
+            const size_t count = keyed ? candidates.size() : std::max(index.size(), size_t{1}) - 1;
+
+            const auto depths = index.depths();
+            const auto keys = index.keys();
+            std::pmr::string path{resource};
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const json_index::node_id node = keyed ? candidates[i] : static_cast<json_index::node_id>(i + 1);
+                const size_t depth = depths[node];
+                if (depth > query.mMaxDepth)
+                {
+                    continue;
+                }
+
+                path.clear();
+                if (query.mTrackPath)
+                {
+                    index.append_path(path, node);
+                    if (!path.starts_with(query.mPathPrefix) && !query.mPathPrefix.starts_with(path))
+                    {
+                        continue;
+                    }
+                }
+
+                probe.element_in();
+                const json_match match{index.key_name(keys[node]), path, to_json_value(index.value(node)), depth};
+                bool selected = true;
+                for (const auto& test : query.mPredicates)
+                {
+                    if (!test(match))
+                    {
+                        selected = false;
+                        break;
+                    }
+                }
+
+                if (selected)
+                {
+                    co_yield probe.yield(query.project(match));
+                    probe.resume();
+                }
+            }
+        }
+
+        json_match project(const json_match& match) const noexcept
+        {
+            switch (mSelect)
+            {
+            case json_select::key:
+                return {match.key, {}, nullptr, match.depth};
+            case json_select::value:
+                return {{}, {}, match.value, match.depth};
+            case json_select::path:
+                return {{}, match.path, nullptr, match.depth};
+            default:
+                return match;
+            }
+        }
+
+        const nlohmann::json* mDocument = nullptr;
+        const json_index* mIndex = nullptr;
+        std::vector<predicate> mPredicates{};
+        json_select mSelect = json_select::all;
+        bool mTrackPath = false;
+        // the values outside of the subtree of this path, or of the paths starting with it, cannot match
+        std::string mPathPrefix{};
+        size_t mMaxDepth = std::numeric_limits<size_t>::max();
+        // the operand of a key equals clause, which selects the candidates of an index
+        std::optional<std::string> mKey{};
+    };
+
+    /*
+       Builds a json_query: from(document).where(json_field::key, json_op::equals, "pi").select().
+       The clauses of several where() calls must all hold. Operands are strings for keys and
+       paths, integers for depths, and strings, numbers, booleans or nullptr for values.
+       Invalid combinations throw std::invalid_argument.
+    */
+    class json_query_builder
+    {
+    public:
+        explicit json_query_builder(const nlohmann::json& document)
+        {
+            mQuery.mDocument = &document;
+        }
+
+        explicit json_query_builder(const json_index& index)
+        {
+            mQuery.mDocument = &index.document();
+            mQuery.mIndex = &index;
+        }
+
+        template <typename V>
+        json_query_builder& where(json_field field, json_op op, V&& operand)
+        {
+            using operand_type = std::decay_t<V>;
+            switch (field)
+            {
+            case json_field::key:
+            case json_field::path:
+                if constexpr (detail::json_text_operand<operand_type>)
+                {
+                    add_text(field, op, std::string{std::string_view{operand}});
+                    return *this;
+                }
+                break;
+            case json_field::depth:
+                if constexpr (std::is_integral_v<operand_type> && !std::is_same_v<operand_type, bool>)
+                {
+                    add_depth(op, static_cast<size_t>(operand));
+                    return *this;
+                }
+                break;
+            case json_field::value:
+                if (auto test = detail::json_value_test(op, std::forward<V>(operand)))
+                {
+                    mQuery.mPredicates.push_back(
+                        [test = std::move(test)](const json_match& match) { return test(match.value); });
+                    return *this;
+                }
+                break;
+            }
+            throw std::invalid_argument("json query: the operand or the operator does not apply to the field");
+        }
+
+        json_query select(json_select select = json_select::all)
+        {
+            mQuery.mSelect = select;
+            mQuery.mTrackPath = mQuery.mTrackPath || select == json_select::all || select == json_select::path;
+            return std::move(mQuery);
+        }
+
+    private:
+        void add_text(json_field field, json_op op, std::string operand)
+        {
+            if (field == json_field::path)
+            {
+                mQuery.mTrackPath = true;
+                const bool prunes = op == json_op::equals || op == json_op::starts_with;
+                if (prunes && operand.size() > mQuery.mPathPrefix.size())
+                {
+                    mQuery.mPathPrefix = operand;
+                }
+                mQuery.mPredicates.push_back([op, operand = std::move(operand)](const json_match& match) {
+                    return detail::json_compare(op, match.path, operand);
+                });
+                return;
+            }
+
+            // array elements have an empty key too, but only object members are in the key index
+            if (op == json_op::equals && !mQuery.mKey && !operand.empty())
+            {
+                mQuery.mKey = operand;
+            }
+            mQuery.mPredicates.push_back([op, operand = std::move(operand)](const json_match& match) {
+                return detail::json_compare(op, match.key, operand);
+            });
+        }
+
+        void add_depth(json_op op, size_t operand)
+        {
+            // a depth bound keeps the traversal from going deeper
+            size_t maxDepth = std::numeric_limits<size_t>::max();
+            if (op == json_op::equals || op == json_op::less_equal)
+            {
+                maxDepth = operand;
+            }
+            else if (op == json_op::less)
+            {
+                maxDepth = operand > 0 ? operand - 1 : 0;
+            }
+            mQuery.mMaxDepth = std::min(mQuery.mMaxDepth, maxDepth);
+
+            mQuery.mPredicates.push_back([op, operand](const json_match& match) {
+                return detail::json_compare(op, match.depth <=> operand);
+            });
+        }
+
+        json_query mQuery{};
+    };
+
+    inline json_query_builder from(const nlohmann::json& document)
+    {
+        return json_query_builder{document};
+    }
+
+    // Builds a query answered from index, see json_index
+    inline json_query_builder from(const json_index& index)
+    {
+        return json_query_builder{index};
+    }
+
+} //namespace gentools
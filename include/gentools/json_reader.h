@@ -0,0 +1,635 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <gentools.h>
+#include <gentools/char_scanner.h>
+#include <gentools/json_pointer.h>
+#include <gentools/lines.h>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace gentools
+{
+    enum class json_token
+    {
+        null,
+        boolean,
+        number,
+        string,
+        begin_object,
+        end_object,
+        begin_array,
+        end_array
+    };
+
+    namespace detail
+    {
+        template <typename Iterator, typename Sentinel>
+        class json_parser;
+    }
+
+    /*
+       A token of a JSON text read by json_events. Its path and text are views into buffers of the
+       parser or into the input, valid until the next event is requested.
+    */
+    class json_event
+    {
+    public:
+        json_token token() const noexcept
+        {
+            return mToken;
+        }
+
+        // JSON pointer of the value, "" for a top-level value; end events have the path of their container
+        std::string_view path() const noexcept
+        {
+            return mPath;
+        }
+
+        // Unescaped contents of a string, or the literal of a number, boolean or null; empty for containers
+        std::string_view text() const noexcept
+        {
+            return mText;
+        }
+
+        // Number of containers around the value
+        size_t depth() const noexcept
+        {
+            return mDepth;
+        }
+
+        bool as_bool() const
+        {
+            expect(json_token::boolean);
+            return mText == "true";
+        }
+
+        int64_t as_int64() const
+        {
+            return as_number<int64_t>();
+        }
+
+        uint64_t as_uint64() const
+        {
+            return as_number<uint64_t>();
+        }
+
+        double as_double() const
+        {
+            return as_number<double>();
+        }
+
+        /*
+           On a begin_object or begin_array event, makes the parser skip the contents of the
+           container, and its end event, without reporting or unescaping any of them.
+           Does nothing on other events.
+        */
+        void skip() const noexcept
+        {
+            if (mSkip != nullptr)
+            {
+                *mSkip = true;
+            }
+        }
+
+    private:
+        template <typename Iterator, typename Sentinel>
+        friend class detail::json_parser;
+
+        void expect(json_token token) const
+        {
+            if (mToken != token)
+            {
+                throw std::logic_error("json_event: the value has another type");
+            }
+        }
+
+        template <typename V>
+        V as_number() const
+        {
+            expect(json_token::number);
+            V value{};
+            const char* last = mText.data() + mText.size();
+            const auto [end, error] = std::from_chars(mText.data(), last, value);
+            if (error != std::errc{} || end != last)
+            {
+                throw std::range_error("json_event: the number does not fit the type: " + std::string{mText});
+            }
+            return value;
+        }
+
+        json_token mToken = json_token::null;
+        std::string_view mPath{};
+        std::string_view mText{};
+        size_t mDepth = 0;
+        bool* mSkip = nullptr;
+    };
+
+    namespace detail
+    {
+        /*
+           Pull parser over a range of text chunks. It keeps the current chunk, the stack of the
+           containers being read and the path of the current value: memory only grows with the
+           depth of the document, the length of its keys and the longest token straddling chunks.
+        */
+        template <typename Iterator, typename Sentinel>
+        class json_parser
+        {
+        public:
+            json_parser(Iterator chunk, Sentinel end, std::pmr::memory_resource* resource)
+                : mChunk(std::move(chunk))
+                , mEnd(std::move(end))
+                , mStack(resource)
+                , mPath(resource)
+                , mToken(resource)
+            {
+                mStack.reserve(16);
+                mPath.reserve(256);
+            }
+
+            // Reads the next event, false at the end of the input
+            bool next(json_event& event)
+            {
+                if (std::exchange(mSkip, false))
+                {
+                    skip_container();
+                    mStack.pop_back();
+                }
+
+                int c = peek();
+                if (mStack.empty())
+                {
+                    if (c < 0)
+                    {
+                        return false;
+                    }
+                    // a sequence of top-level values is read as well, as in newline delimited JSON
+                    mPath.clear();
+                    return value(event, c);
+                }
+
+                auto& frame = mStack.back();
+                mPath.resize(frame.pathLength);
+                if (c == (frame.array ? ']' : '}'))
+                {
+                    ++mPos;
+                    const bool array = frame.array;
+                    mStack.pop_back();
+                    set(event, array ? json_token::end_array : json_token::end_object, {});
+                    return true;
+                }
+
+                if (frame.count > 0)
+                {
+                    if (c != ',')
+                    {
+                        fail(c < 0 ? "unexpected end of input" : "expected ',' or the end of the container");
+                    }
+                    ++mPos;
+                    c = peek();
+                }
+
+                if (frame.array)
+                {
+                    append_pointer_token(mPath, frame.count);
+                }
+                else
+                {
+                    if (c != '"')
+                    {
+                        fail("expected a key");
+                    }
+                    ++mPos;
+                    // appended before reading on, which may move to the next chunk
+                    append_pointer_token(mPath, parse_string());
+                    if (peek() != ':')
+                    {
+                        fail("expected ':'");
+                    }
+                    ++mPos;
+                    c = peek();
+                }
+                ++frame.count;
+                return value(event, c);
+            }
+
+        private:
+            struct frame
+            {
+                bool array;
+                size_t count;
+                size_t pathLength;
+            };
+
+            bool value(json_event& event, int c)
+            {
+                switch (c)
+                {
+                case '{':
+                case '[':
+                    ++mPos;
+                    set(event, c == '{' ? json_token::begin_object : json_token::begin_array, {});
+                    event.mSkip = &mSkip;
+                    mStack.push_back({c == '[', 0, mPath.size()});
+                    return true;
+                case '"':
+                    ++mPos;
+                    set(event, json_token::string, parse_string());
+                    return true;
+                case 't':
+                    set(event, json_token::boolean, parse_literal("true"));
+                    return true;
+                case 'f':
+                    set(event, json_token::boolean, parse_literal("false"));
+                    return true;
+                case 'n':
+                    set(event, json_token::null, parse_literal("null"));
+                    return true;
+                default:
+                    if (c == '-' || (c >= '0' && c <= '9'))
+                    {
+                        set(event, json_token::number, parse_number());
+                        return true;
+                    }
+                    fail(c < 0 ? "unexpected end of input" : "unexpected character");
+                }
+            }
+
+            void set(json_event& event, json_token token, std::string_view text) noexcept
+            {
+                event.mToken = token;
+                event.mPath = mPath;
+                event.mText = text;
+                event.mDepth = mStack.size();
+                event.mSkip = nullptr;
+            }
+
+            // Moves to the next non empty chunk, false at the end of the input
+            bool fill()
+            {
+                while (mPos == mLast)
+                {
+                    if (mChunk == mEnd)
+                    {
+                        return false;
+                    }
+                    if (std::exchange(mStarted, true))
+                    {
+                        ++mChunk;
+                        if (mChunk == mEnd)
+                        {
+                            return false;
+                        }
+                    }
+
+                    const auto text = as_text(*mChunk);
+                    mOffset += static_cast<uint64_t>(mLast - mFirst);
+                    mFirst = mPos = text.data();
+                    mLast = text.data() + text.size();
+                }
+                return true;
+            }
+
+            // Skips whitespace and returns the next character without consuming it, -1 at the end of the input
+            int peek()
+            {
+                do
+                {
+                    for (; mPos != mLast; ++mPos)
+                    {
+                        const char c = *mPos;
+                        if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+                        {
+                            return static_cast<unsigned char>(c);
+                        }
+                    }
+                } while (fill());
+                return -1;
+            }
+
+            char get(const char* error)
+            {
+                if (mPos == mLast && !fill())
+                {
+                    fail(error);
+                }
+                return *mPos++;
+            }
+
+            // Reads a string whose opening quote has been consumed
+            std::string_view parse_string()
+            {
+                // a string without escapes within the chunk is a view into it
+                const auto* quote = static_cast<const char*>(std::memchr(mPos, '"', static_cast<size_t>(mLast - mPos)));
+                if (quote != nullptr && std::memchr(mPos, '\\', static_cast<size_t>(quote - mPos)) == nullptr)
+                {
+                    const std::string_view text{mPos, static_cast<size_t>(quote - mPos)};
+                    mPos = quote + 1;
+                    return text;
+                }
+
+                mToken.clear();
+                while (true)
+                {
+                    const char c = get("unterminated string");
+                    if (c == '"')
+                    {
+                        return mToken;
+                    }
+                    if (c != '\\')
+                    {
+                        mToken.push_back(c);
+                        continue;
+                    }
+
+                    const char escaped = get("unterminated string");
+                    switch (escaped)
+                    {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        mToken.push_back(escaped);
+                        break;
+                    case 'b':
+                        mToken.push_back('\b');
+                        break;
+                    case 'f':
+                        mToken.push_back('\f');
+                        break;
+                    case 'n':
+                        mToken.push_back('\n');
+                        break;
+                    case 'r':
+                        mToken.push_back('\r');
+                        break;
+                    case 't':
+                        mToken.push_back('\t');
+                        break;
+                    case 'u':
+                        append_code_point(parse_code_point());
+                        break;
+                    default:
+                        fail("invalid escape sequence");
+                    }
+                }
+            }
+
+            // Reads the code point of a \u escape, and of the low surrogate escape following a high one
+            uint32_t parse_code_point()
+            {
+                uint32_t code = parse_hex();
+                if (code >= 0xD800 && code <= 0xDBFF)
+                {
+                    if (get("unterminated string") != '\\' || get("unterminated string") != 'u')
+                    {
+                        fail("unpaired surrogate");
+                    }
+                    const uint32_t low = parse_hex();
+                    if (low < 0xDC00 || low > 0xDFFF)
+                    {
+                        fail("unpaired surrogate");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                return code;
+            }
+
+            uint32_t parse_hex()
+            {
+                uint32_t code = 0;
+                for (int i = 0; i < 4; ++i)
+                {
+                    const char c = get("unterminated string");
+                    code <<= 4;
+                    if (c >= '0' && c <= '9')
+                    {
+                        code |= static_cast<uint32_t>(c - '0');
+                    }
+                    else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+                    {
+                        code |= static_cast<uint32_t>((c | 0x20) - 'a' + 10);
+                    }
+                    else
+                    {
+                        fail("invalid \\u escape");
+                    }
+                }
+                return code;
+            }
+
+            void append_code_point(uint32_t code)
+            {
+                if (code < 0x80)
+                {
+                    mToken.push_back(static_cast<char>(code));
+                }
+                else if (code < 0x800)
+                {
+                    mToken.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                    mToken.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else if (code < 0x10000)
+                {
+                    mToken.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                    mToken.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    mToken.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                else
+                {
+                    mToken.push_back(static_cast<char>(0xF0 | (code >> 18)));
+                    mToken.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                    mToken.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    mToken.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+            }
+
+            std::string_view parse_literal(std::string_view literal)
+            {
+                for (char expected : literal)
+                {
+                    if (get("unexpected end of input") != expected)
+                    {
+                        fail("invalid literal");
+                    }
+                }
+                return literal;
+            }
+
+            static bool is_number_char(char c) noexcept
+            {
+                return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+            }
+
+            std::string_view parse_number()
+            {
+                const char* start = mPos;
+                while (mPos != mLast && is_number_char(*mPos))
+                {
+                    ++mPos;
+                }
+
+                std::string_view text{start, static_cast<size_t>(mPos - start)};
+                if (mPos == mLast)
+                {
+                    // the number may go on in the next chunk
+                    mToken.assign(start, mPos);
+                    while ((mPos != mLast || fill()) && is_number_char(*mPos))
+                    {
+                        mToken.push_back(*mPos++);
+                    }
+                    text = mToken;
+                }
+
+                double value{};
+                const char* last = text.data() + text.size();
+                if (std::from_chars(text.data(), last, value).ptr != last)
+                {
+                    fail("invalid number");
+                }
+                return text;
+            }
+
+            // Skips the rest of the container just begun, finding its end with a char_scanner
+            void skip_container()
+            {
+                size_t depth = 1;
+                bool inString = false;
+                // a backslash ended the previous chunk, so the first character of this one is escaped
+                bool escapeFirst = false;
+
+                while (true)
+                {
+                    if (mPos == mLast && !fill())
+                    {
+                        fail("unexpected end of input");
+                    }
+
+                    const char* escaped = std::exchange(escapeFirst, false) ? mPos : nullptr;
+                    char_scanner scanner{mPos, mLast, "\"\\{}[]"};
+                    while (const char* found = scanner.next())
+                    {
+                        if (found == escaped)
+                        {
+                            continue;
+                        }
+
+                        const char c = *found;
+                        if (inString)
+                        {
+                            if (c == '\\')
+                            {
+                                escapeFirst = found + 1 == mLast;
+                                escaped = found + 1;
+                            }
+                            else if (c == '"')
+                            {
+                                inString = false;
+                            }
+                        }
+                        else if (c == '"')
+                        {
+                            inString = true;
+                        }
+                        else if (c == '{' || c == '[')
+                        {
+                            ++depth;
+                        }
+                        else if ((c == '}' || c == ']') && --depth == 0)
+                        {
+                            mPos = found + 1;
+                            return;
+                        }
+                    }
+                    mPos = mLast;
+                }
+            }
+
+            [[noreturn]] void fail(const char* message) const
+            {
+                const auto offset = mOffset + static_cast<uint64_t>(mPos - mFirst);
+                throw std::runtime_error(std::string{"json: "} + message + " at offset " + std::to_string(offset));
+            }
+
+            Iterator mChunk;
+            Sentinel mEnd;
+            bool mStarted = false;
+            const char* mFirst = nullptr;
+            const char* mPos = nullptr;
+            const char* mLast = nullptr;
+            // bytes of the chunks before the current one
+            uint64_t mOffset = 0;
+
+            std::pmr::vector<frame> mStack;
+            std::pmr::string mPath;
+            // a token that could not be a view into the input
+            std::pmr::string mToken;
+            bool mSkip = false;
+        };
+
+        // Takes T by value when json_events is given an rvalue, so an upstream generator lives in this frame
+        template <ranges::range T>
+        generator<json_event> json_events(std::pmr::memory_resource* resource, T chunks)
+        {
+            detail::stage_probe probe{"json_events"};
+            json_parser parser{ranges::begin(chunks), ranges::end(chunks), resource};
+            json_event event{};
+
+            while (parser.next(event))
+            {
+                probe.element_in();
+                co_yield probe.yield(event);
+                probe.resume();
+            }
+        }
+    }
+
+    /*
+       Reads JSON text without building a document, and yields an event per value and per end
+       of a container, in document order, with the JSON pointer of the value. Memory does not
+       grow with the size of the text, and json_event::skip() passes over a container without
+       reporting its contents. A sequence of top-level values, such as newline delimited JSON, is
+       read too. Malformed text throws std::runtime_error with its offset; skipped containers are
+       only checked for balanced brackets.
+
+       The chunks may be a range of text chunks such as file_chunks() or mapped_array::chunks().
+       Rvalue ranges, such as generators, are moved into the generator; lvalue ranges are referenced.
+    */
+    template <ranges::range T>
+        requires detail::text_chunk<range_value_t<T>>
+    generator<json_event> json_events(std::allocator_arg_t, std::pmr::memory_resource* resource, T&& chunks)
+    {
+        frame_resource_scope scope{resource};
+        return detail::json_events<T>(resource, std::forward<T>(chunks));
+    }
+
+    template <ranges::range T>
+        requires detail::text_chunk<range_value_t<T>>
+    generator<json_event> json_events(T&& chunks)
+    {
+        return detail::json_events<T>(current_frame_resource(), std::forward<T>(chunks));
+    }
+
+    // Same as above over text, which must outlive the generator
+    inline generator<json_event> json_events(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                             std::string_view text)
+    {
+        frame_resource_scope scope{resource};
+        return detail::json_events(resource, std::array<std::string_view, 1>{text});
+    }
+
+    inline generator<json_event> json_events(std::string_view text)
+    {
+        return detail::json_events(current_frame_resource(), std::array<std::string_view, 1>{text});
+    }
+
+} //namespace gentools
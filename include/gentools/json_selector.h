@@ -0,0 +1,466 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <gentools.h>
+#include <gentools/json.h>
+#include <gentools/json_pointer.h>
+#include <gentools/json_query.h>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace gentools
+{
+    namespace detail
+    {
+        // A step of a selector, the transition from one state of its automaton to the next
+        struct json_step
+        {
+            enum class kind
+            {
+                // .name or ['name']
+                member,
+                // [2] or [-1]
+                index,
+                // .* or [*]
+                wildcard,
+                // [?(@.qty > 10)]
+                filter
+            };
+
+            kind type;
+            std::string name{};
+            int64_t index = 0;
+            std::function<bool(const nlohmann::json&)> filter{};
+        };
+
+        class json_selector_parser
+        {
+        public:
+            explicit json_selector_parser(std::string_view text) noexcept
+                : mText(text)
+            {
+            }
+
+            std::vector<json_step> parse()
+            {
+                std::vector<json_step> steps{};
+                expect('$');
+                while (mOffset < mText.size())
+                {
+                    if (consume('.'))
+                    {
+                        if (peek() == '.')
+                        {
+                            fail("recursive descent is not supported");
+                        }
+                        steps.push_back(consume('*') ? json_step{json_step::kind::wildcard}
+                                                     : json_step{json_step::kind::member, name(".[")});
+                    }
+                    else if (consume('['))
+                    {
+                        steps.push_back(bracket());
+                    }
+                    else
+                    {
+                        fail("expected . or [");
+                    }
+                }
+                return steps;
+            }
+
+        private:
+            using literal = std::variant<int64_t, uint64_t, double, bool, std::nullptr_t, std::string>;
+
+            json_step bracket()
+            {
+                skip_spaces();
+                json_step step{json_step::kind::wildcard};
+                if (consume('?'))
+                {
+                    expect('(');
+                    step = {json_step::kind::filter, {}, 0, filter()};
+                    expect(')');
+                }
+                else if (peek() == '\'' || peek() == '"')
+                {
+                    step = {json_step::kind::member, quoted()};
+                }
+                else if (!consume('*'))
+                {
+                    step = {json_step::kind::index};
+                    const auto [end, error] = std::from_chars(mText.data() + mOffset, mText.data() + mText.size(), step.index);
+                    if (error != std::errc{})
+                    {
+                        fail("expected a name, an index, * or a filter");
+                    }
+                    mOffset = end - mText.data();
+                }
+                skip_spaces();
+                expect(']');
+                return step;
+            }
+
+            // @.name['other name'] [op literal], an existence test without the comparison
+            std::function<bool(const nlohmann::json&)> filter()
+            {
+                skip_spaces();
+                expect('@');
+                std::vector<std::string> members{};
+                while (true)
+                {
+                    if (consume('.'))
+                    {
+                        members.push_back(name(".[ )=!<>"));
+                    }
+                    else if (peek() == '[')
+                    {
+                        ++mOffset;
+                        members.push_back(quoted());
+                        expect(']');
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+
+                auto target = [members = std::move(members)](const nlohmann::json& node) -> const nlohmann::json* {
+                    const nlohmann::json* current = &node;
+                    for (const auto& member : members)
+                    {
+                        if (!current->is_object())
+                        {
+                            return nullptr;
+                        }
+                        const auto found = current->find(member);
+                        if (found == current->cend())
+                        {
+                            return nullptr;
+                        }
+                        current = &*found;
+                    }
+                    return current;
+                };
+
+                skip_spaces();
+                if (peek() == ')')
+                {
+                    return [target = std::move(target)](const nlohmann::json& node) { return target(node) != nullptr; };
+                }
+
+                const json_op op = comparison();
+                skip_spaces();
+                auto test = std::visit([op](auto&& operand) { return json_value_test(op, std::move(operand)); }, value());
+                if (!test)
+                {
+                    fail("the comparison does not apply to the literal");
+                }
+                skip_spaces();
+                return [target = std::move(target), test = std::move(test)](const nlohmann::json& node) {
+                    const nlohmann::json* value = target(node);
+                    return value != nullptr && test(to_json_value(*value));
+                };
+            }
+
+            json_op comparison()
+            {
+                const std::string_view rest = mText.substr(mOffset);
+                for (const auto& [text, op] : {std::pair{"==", json_op::equals}, std::pair{"!=", json_op::not_equals},
+                                               std::pair{"<=", json_op::less_equal}, std::pair{">=", json_op::greater_equal},
+                                               std::pair{"<", json_op::less}, std::pair{">", json_op::greater}})
+                {
+                    if (rest.starts_with(text))
+                    {
+                        mOffset += std::string_view{text}.size();
+                        return op;
+                    }
+                }
+                fail("expected a comparison or )");
+            }
+
+            literal value()
+            {
+                if (peek() == '\'' || peek() == '"')
+                {
+                    return quoted();
+                }
+
+                for (const auto& [text, constant] : {std::pair{"true", literal{true}}, std::pair{"false", literal{false}},
+                                                      std::pair{"null", literal{nullptr}}})
+                {
+                    if (mText.substr(mOffset).starts_with(text))
+                    {
+                        mOffset += std::string_view{text}.size();
+                        return constant;
+                    }
+                }
+
+                const size_t end = std::min(mText.find_first_not_of("+-0123456789.eE", mOffset), mText.size());
+                const char* first = mText.data() + mOffset;
+                const char* last = mText.data() + end;
+                int64_t integer = 0;
+                uint64_t unsignedInteger = 0;
+                double number = 0;
+                literal result{};
+                if (first == last)
+                {
+                    fail("expected a literal");
+                }
+                else if (std::from_chars(first, last, integer).ptr == last)
+                {
+                    result = integer;
+                }
+                else if (std::from_chars(first, last, unsignedInteger).ptr == last)
+                {
+                    result = unsignedInteger;
+                }
+                else if (std::from_chars(first, last, number).ptr == last)
+                {
+                    result = number;
+                }
+                else
+                {
+                    fail("expected a literal");
+                }
+                mOffset = end;
+                return result;
+            }
+
+            std::string name(std::string_view stops)
+            {
+                const size_t end = std::min(mText.find_first_of(stops, mOffset), mText.size());
+                if (end == mOffset)
+                {
+                    fail("expected a name");
+                }
+                std::string result{mText.substr(mOffset, end - mOffset)};
+                mOffset = end;
+                return result;
+            }
+
+            // 'name' or "name", where a backslash escapes the next character
+            std::string quoted()
+            {
+                const char quote = mText[mOffset++];
+                std::string result{};
+                while (mOffset < mText.size() && mText[mOffset] != quote)
+                {
+                    if (mText[mOffset] == '\\' && mOffset + 1 < mText.size())
+                    {
+                        ++mOffset;
+                    }
+                    result += mText[mOffset++];
+                }
+                expect(quote);
+                return result;
+            }
+
+            char peek() const noexcept
+            {
+                return mOffset < mText.size() ? mText[mOffset] : '\0';
+            }
+
+            bool consume(char c) noexcept
+            {
+                if (peek() == c && mOffset < mText.size())
+                {
+                    ++mOffset;
+                    return true;
+                }
+                return false;
+            }
+
+            void expect(char c)
+            {
+                if (!consume(c))
+                {
+                    fail(std::string{"expected "} + c);
+                }
+            }
+
+            void skip_spaces() noexcept
+            {
+                while (peek() == ' ')
+                {
+                    ++mOffset;
+                }
+            }
+
+            [[noreturn]] void fail(const std::string& message) const
+            {
+                throw std::invalid_argument("json selector: " + message + " at offset " + std::to_string(mOffset));
+            }
+
+            std::string_view mText;
+            size_t mOffset = 0;
+        };
+    }
+
+    /*
+       A JSONPath-style selector such as $.orders[*].items[?(@.qty > 10)].sku, compiled once into
+       a deterministic automaton with one state per step. The steps are .name or ['name'], [2] or
+       [-1] counting from the end, .* or [*], and filters [?(@.member op literal)] or [?(@.member)]
+       comparing with ==, !=, <, <=, > or >= against a number, a quoted string, true, false or null.
+       Recursive descent (..) is not supported. Syntax errors throw std::invalid_argument.
+
+       Calling the selector walks a document and yields the selected values with their JSON
+       pointers, in document order. Each visited value costs one transition, a member step looks
+       its child up instead of scanning the object, and the subtrees of the values that fail a
+       transition are never walked. Like traverse_paths, the paths are valid until the next value.
+    */
+    class json_selector
+    {
+    public:
+        explicit json_selector(std::string_view expression)
+            : mSteps(detail::json_selector_parser{expression}.parse())
+        {
+        }
+
+        generator<json_path_item> operator()(const nlohmann::json& document) const
+        {
+            return run(current_frame_resource(), *this, document);
+        }
+
+        generator<json_path_item> operator()(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                                             const nlohmann::json& document) const
+        {
+            frame_resource_scope scope{resource};
+            return run(resource, *this, document);
+        }
+
+    private:
+        // The children of a value at the state of step
+        struct frame
+        {
+            const nlohmann::json* container;
+            nlohmann::json::const_iterator child;
+            nlohmann::json::const_iterator end;
+            size_t index;
+            size_t pathLength;
+            size_t step;
+        };
+
+        // Pushes the children of value that step may accept, if any
+        template <typename Stack>
+        static void push(Stack& stack, const detail::json_step& step, size_t state, const nlohmann::json& value,
+                         size_t pathLength)
+        {
+            if (!value.is_structured() || value.empty())
+            {
+                return;
+            }
+
+            switch (step.type)
+            {
+            case detail::json_step::kind::member:
+                if (value.is_object())
+                {
+                    const auto found = value.find(step.name);
+                    if (found != value.cend())
+                    {
+                        stack.push_back({&value, found, std::next(found), 0, pathLength, state});
+                    }
+                }
+                break;
+            case detail::json_step::kind::index:
+                if (value.is_array())
+                {
+                    const int64_t size = static_cast<int64_t>(value.size());
+                    const int64_t index = step.index < 0 ? size + step.index : step.index;
+                    if (index >= 0 && index < size)
+                    {
+                        const auto child = value.cbegin() + index;
+                        stack.push_back({&value, child, std::next(child), static_cast<size_t>(index), pathLength, state});
+                    }
+                }
+                break;
+            default:
+                stack.push_back({&value, value.cbegin(), value.cend(), 0, pathLength, state});
+                break;
+            }
+        }
+
+        // the selector is copied into the frame, so it may be a temporary
+        static generator<json_path_item> run(std::pmr::memory_resource* resource, json_selector selector,
+                                             const nlohmann::json& root)
+        {
+            detail::stage_probe probe{"json_selector"};
+            const auto& steps = selector.mSteps;
+            if (steps.empty())
+            {
+                probe.element_in();
+                co_yield probe.yield(json_path_item{{}, to_json_value(root)});
+                probe.resume();
+                co_return;
+            }
+
+            std::pmr::vector<frame> stack{resource};
+            stack.reserve(steps.size());
+            push(stack, steps[0], 0, root, 0);
+
+            std::pmr::string path{resource};
+            path.reserve(256);
+
+            while (!stack.empty())
+            {
+                auto& parent = stack.back();
+                if (parent.child == parent.end)
+                {
+                    stack.pop_back();
+                    continue;
+                }
+
+                const auto child = parent.child;
+                const nlohmann::json& value = *child;
+                const size_t index = parent.index;
+                const size_t state = parent.step;
+                const size_t pathLength = parent.pathLength;
+                const bool member = parent.container->is_object();
+                ++parent.child;
+                ++parent.index;
+
+                probe.element_in();
+                const auto& step = steps[state];
+                if (step.type == detail::json_step::kind::filter && !step.filter(value))
+                {
+                    continue;
+                }
+
+                path.resize(pathLength);
+                if (member)
+                {
+                    detail::append_pointer_token(path, child.key());
+                }
+                else
+                {
+                    detail::append_pointer_token(path, index);
+                }
+
+                if (state + 1 == steps.size())
+                {
+                    co_yield probe.yield(json_path_item{path, to_json_value(value)});
+                    probe.resume();
+                }
+                else
+                {
+                    // invalidates parent
+                    push(stack, steps[state + 1], state + 1, value, path.size());
+                }
+            }
+        }
+
+        std::vector<detail::json_step> mSteps;
+    };
+
+} //namespace gentools
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <gentools.h>
+#include <gentools/char_scanner.h>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace gentools
+{
+    namespace detail
+    {
+        inline std::string_view line_view(const char* first, const char* last) noexcept
+        {
+            if (first != last && *(last - 1) == '\r')
+            {
+                --last;
+            }
+            return {first, static_cast<size_t>(last - first)};
+        }
+
+        // A chunk of text: a contiguous range of bytes or chars, such as the spans of file_chunks
+        template <typename T>
+        concept text_chunk = ranges::contiguous_range<T> && ranges::sized_range<T> &&
+                             sizeof(range_value_t<T>) == 1 && std::is_trivially_copyable_v<range_value_t<T>>;
+
+        template <typename T>
+        std::string_view as_text(T&& chunk) noexcept
+        {
+            return {reinterpret_cast<const char*>(ranges::data(chunk)), static_cast<size_t>(ranges::size(chunk))};
+        }
+    }
+
+    /*
+       Splits text on '\n' and yields each line without its terminator; a '\r' before it is
+       dropped too. The last line is yielded even without a final newline. The lines are views
+       into text, which must outlive the generator.
+    */
+    inline generator<std::string_view> lines(std::string_view text)
+    {
+        detail::stage_probe probe{"lines"};
+        const char* lineStart = text.data();
+        const char* textEnd = text.data() + text.size();
+
+        detail::char_scanner scanner{lineStart, textEnd, "\n"};
+        while (const char* newline = scanner.next())
+        {
+            probe.element_in();
+            co_yield probe.yield(detail::line_view(lineStart, newline));
+            probe.resume();
+            lineStart = newline + 1;
+        }
+
+        if (lineStart != textEnd)
+        {
+            probe.element_in();
+            co_yield probe.yield(detail::line_view(lineStart, textEnd));
+            probe.resume();
+        }
+    }
+
+    namespace detail
+    {
+        // Takes T by value when lines is given an rvalue, so an upstream generator lives in this frame
+        template <ranges::range T>
+        generator<std::string_view> lines(T chunks)
+        {
+            detail::stage_probe probe{"lines"};
+            // the start of a line whose end is in a later chunk
+            std::string carry{};
+
+            for (auto&& chunk : chunks)
+            {
+                const auto text = detail::as_text(chunk);
+                const char* lineStart = text.data();
+                const char* textEnd = text.data() + text.size();
+
+                detail::char_scanner scanner{lineStart, textEnd, "\n"};
+                while (const char* newline = scanner.next())
+                {
+                    probe.element_in();
+                    if (carry.empty())
+                    {
+                        co_yield probe.yield(detail::line_view(lineStart, newline));
+                    }
+                    else
+                    {
+                        carry.append(lineStart, newline);
+                        co_yield probe.yield(detail::line_view(carry.data(), carry.data() + carry.size()));
+                        carry.clear();
+                    }
+                    probe.resume();
+                    lineStart = newline + 1;
+                }
+
+                carry.append(lineStart, textEnd);
+            }
+
+            if (!carry.empty())
+            {
+                probe.element_in();
+                co_yield probe.yield(detail::line_view(carry.data(), carry.data() + carry.size()));
+                probe.resume();
+            }
+        }
+    }
+
+    /*
+       Same as above over a range of text chunks, such as file_chunks() or mapped_array::chunks().
+       Lines within a chunk are views into it, valid until the next line is requested; only a
+       line straddling chunk boundaries is copied, into a buffer the generator reuses.
+       Rvalue ranges, such as generators, are moved into the generator; lvalue ranges are referenced.
+    */
+    template <ranges::range T>
+        requires detail::text_chunk<range_value_t<T>>
+    generator<std::string_view> lines(T&& chunks)
+    {
+        return detail::lines<T>(std::forward<T>(chunks));
+    }
+
+} //namespace gentools
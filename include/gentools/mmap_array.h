@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <gentools.h>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if defined(_WIN32)
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#else
+#    include <cerrno>
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+namespace gentools
+{
+    // Hints on how a mapped file is about to be read, combined with |
+    enum class mmap_advice : unsigned
+    {
+        normal = 0,
+        // read ahead aggressively and drop pages soon after they were read
+        sequential = 1,
+        // do not read ahead
+        random = 2,
+        // start reading the pages in now
+        willneed = 4,
+        // back the mapping with huge pages where the kernel supports it for files
+        hugepage = 8,
+    };
+
+    constexpr mmap_advice operator|(mmap_advice left, mmap_advice right) noexcept
+    {
+        return static_cast<mmap_advice>(static_cast<unsigned>(left) | static_cast<unsigned>(right));
+    }
+
+    constexpr bool has_advice(mmap_advice advice, mmap_advice flag) noexcept
+    {
+        return (static_cast<unsigned>(advice) & static_cast<unsigned>(flag)) != 0;
+    }
+
+    /*
+       Read-only memory mapping of a file of trivially copyable T records, as a contiguous sized
+       range of const T. Pages are read by the kernel when first touched, so files larger than
+       memory can be processed; a trailing partial record is not part of the range.
+       Adaptors reference the array, which must outlive the generators built on it.
+    */
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    class mapped_array
+    {
+    public:
+        using value_type = T;
+        using iterator = const T*;
+
+        mapped_array() noexcept = default;
+
+        explicit mapped_array(const std::filesystem::path& path, mmap_advice advice = mmap_advice::sequential)
+        {
+            map(path);
+            this->advise(advice);
+        }
+
+        mapped_array(mapped_array&& other) noexcept
+            : mData(std::exchange(other.mData, nullptr))
+            , mSize(std::exchange(other.mSize, 0))
+            , mBytes(std::exchange(other.mBytes, 0))
+        {
+        }
+
+        mapped_array& operator=(mapped_array&& other) noexcept
+        {
+            if (this != &other)
+            {
+                unmap();
+                mData = std::exchange(other.mData, nullptr);
+                mSize = std::exchange(other.mSize, 0);
+                mBytes = std::exchange(other.mBytes, 0);
+            }
+            return *this;
+        }
+
+        ~mapped_array()
+        {
+            unmap();
+        }
+
+        const T* data() const noexcept
+        {
+            return mData;
+        }
+
+        size_t size() const noexcept
+        {
+            return mSize;
+        }
+
+        bool empty() const noexcept
+        {
+            return mSize == 0;
+        }
+
+        const T* begin() const noexcept
+        {
+            return mData;
+        }
+
+        const T* end() const noexcept
+        {
+            return mData + mSize;
+        }
+
+        const T& operator[](size_t index) const noexcept
+        {
+            return mData[index];
+        }
+
+        operator std::span<const T>() const noexcept
+        {
+            return {mData, mSize};
+        }
+
+        // Applies advice to the count records starting at first. Hints the platform ignores are no-ops.
+        void advise(mmap_advice advice, size_t first = 0, size_t count = static_cast<size_t>(-1)) const noexcept
+        {
+            if (first >= mSize)
+            {
+                return;
+            }
+            count = std::min(count, mSize - first);
+
+            // the range is extended to whole pages
+            const auto pageSize = page_size();
+            const auto start = reinterpret_cast<uintptr_t>(mData + first) / pageSize * pageSize;
+            const auto stop = reinterpret_cast<uintptr_t>(mData + first + count);
+            void* address = reinterpret_cast<void*>(start);
+            const size_t length = stop - start;
+
+#if defined(_WIN32)
+            if (has_advice(advice, mmap_advice::willneed))
+            {
+                WIN32_MEMORY_RANGE_ENTRY range{address, length};
+                PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+            }
+#else
+            if (has_advice(advice, mmap_advice::sequential))
+            {
+                ::madvise(address, length, MADV_SEQUENTIAL);
+            }
+            if (has_advice(advice, mmap_advice::random))
+            {
+                ::madvise(address, length, MADV_RANDOM);
+            }
+            if (has_advice(advice, mmap_advice::willneed))
+            {
+                ::madvise(address, length, MADV_WILLNEED);
+            }
+#    if defined(MADV_HUGEPAGE)
+            if (has_advice(advice, mmap_advice::hugepage))
+            {
+                ::madvise(address, length, MADV_HUGEPAGE);
+            }
+#    endif
+#endif
+        }
+
+        /*
+           Yields the records in spans of up to count records. While a chunk is processed the
+           kernel is asked to read in the next one, so the consumer rarely waits on a page fault.
+        */
+        generator<std::span<const T>> chunks(size_t count) const
+        {
+            detail::stage_probe probe{"mmap_chunks"};
+            count = std::max<size_t>(count, 1);
+
+            for (size_t first = 0; first < mSize; first += count)
+            {
+                const size_t length = std::min(count, mSize - first);
+                advise(mmap_advice::willneed, first + length, count);
+
+                probe.element_in(length);
+                co_yield probe.yield(std::span<const T>{mData + first, length});
+                probe.resume();
+            }
+        }
+
+    private:
+        static size_t page_size() noexcept
+        {
+#if defined(_WIN32)
+            SYSTEM_INFO info{};
+            GetSystemInfo(&info);
+            return info.dwPageSize;
+#else
+            return static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+        }
+
+        void map(const std::filesystem::path& path)
+        {
+#if defined(_WIN32)
+            HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE)
+            {
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path.string());
+            }
+
+            LARGE_INTEGER size{};
+            GetFileSizeEx(file, &size);
+            mBytes = static_cast<size_t>(size.QuadPart);
+
+            if (mBytes >= sizeof(T))
+            {
+                HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+                const auto error = GetLastError();
+                if (mapping != nullptr)
+                {
+                    CloseHandle(mapping);
+                }
+                CloseHandle(file);
+                if (view == nullptr)
+                {
+                    throw std::system_error(static_cast<int>(error), std::system_category(), path.string());
+                }
+                mData = static_cast<const T*>(view);
+            }
+            else
+            {
+                CloseHandle(file);
+            }
+#else
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat info{};
+            if (fd < 0 || ::fstat(fd, &info) < 0)
+            {
+                const int error = errno;
+                if (fd >= 0)
+                {
+                    ::close(fd);
+                }
+                throw std::system_error(error, std::generic_category(), path.string());
+            }
+            mBytes = static_cast<size_t>(info.st_size);
+
+            // a mapping of 0 bytes is an error, an empty array needs none
+            if (mBytes >= sizeof(T))
+            {
+                void* view = ::mmap(nullptr, mBytes, PROT_READ, MAP_SHARED, fd, 0);
+                const int error = errno;
+                ::close(fd);
+                if (view == MAP_FAILED)
+                {
+                    throw std::system_error(error, std::generic_category(), path.string());
+                }
+                mData = static_cast<const T*>(view);
+            }
+            else
+            {
+                ::close(fd);
+            }
+#endif
+            mSize = mData != nullptr ? mBytes / sizeof(T) : 0;
+        }
+
+        void unmap() noexcept
+        {
+            if (mData == nullptr)
+            {
+                return;
+            }
+#if defined(_WIN32)
+            UnmapViewOfFile(mData);
+#else
+            ::munmap(const_cast<T*>(mData), mBytes);
+#endif
+            mData = nullptr;
+            mSize = 0;
+            mBytes = 0;
+        }
+
+        const T* mData = nullptr;
+        size_t mSize = 0;
+        size_t mBytes = 0;
+    };
+
+    // Maps the file at path as an array of T records, see mapped_array
+    template <typename T>
+        requires std::is_trivially_copyable_v<T>
+    mapped_array<T> mmap_array(const std::filesystem::path& path, mmap_advice advice = mmap_advice::sequential)
+    {
+        return mapped_array<T>{path, advice};
+    }
+
+} //namespace gentools
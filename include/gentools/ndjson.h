@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <gentools.h>
+#include <gentools/char_scanner.h>
+#include <gentools/lines.h>
+#include <gentools/parallel.h>
+#include <gentools/thread_pool.h>
+#include <json/json.hpp>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gentools
+{
+    struct ndjson_options
+    {
+        // the size of the batches of whole lines handed to the workers
+        size_t batch_bytes = size_t{1} << 20;
+        // batches in flight, 0 for 4 per worker
+        size_t window = 0;
+        // the workers of the pool the generator owns when it is not given one, 0 for one per hardware thread
+        size_t threads = 0;
+    };
+
+    namespace detail
+    {
+        // Whole lines of the input; the buffer is shared so copying a batch into a task is cheap
+        struct ndjson_batch
+        {
+            std::shared_ptr<const std::string> storage;
+            std::string_view text;
+        };
+
+        // The batches of text are views into it
+        inline generator<ndjson_batch> ndjson_batches(std::string_view text, size_t batchBytes)
+        {
+            while (!text.empty())
+            {
+                const size_t newline = batchBytes < text.size() ? text.find('\n', batchBytes) : std::string_view::npos;
+                const size_t length = newline != std::string_view::npos ? newline + 1 : text.size();
+                co_yield ndjson_batch{nullptr, text.substr(0, length)};
+                text.remove_prefix(length);
+            }
+        }
+
+        // The chunks are copied into the batches, since they may not outlive the workers' use of them
+        template <ranges::range T>
+        generator<ndjson_batch> ndjson_batches(T chunks, size_t batchBytes)
+        {
+            auto storage = std::make_shared<std::string>();
+            storage->reserve(batchBytes + (batchBytes >> 2));
+
+            for (auto&& chunk : chunks)
+            {
+                storage->append(detail::as_text(chunk));
+                if (storage->size() < batchBytes)
+                {
+                    continue;
+                }
+
+                const size_t newline = storage->rfind('\n');
+                if (newline == std::string::npos)
+                {
+                    // a line longer than a batch
+                    continue;
+                }
+
+                auto next = std::make_shared<std::string>();
+                next->reserve(batchBytes + (batchBytes >> 2));
+                next->append(*storage, newline + 1);
+                storage->resize(newline + 1);
+                {
+                    // named: GCC 12 destroys an aggregate temporary in a co_yield expression twice
+                    const ndjson_batch batch{storage, *storage};
+                    co_yield batch;
+                }
+                storage = std::move(next);
+            }
+
+            if (!storage->empty())
+            {
+                const ndjson_batch batch{storage, *storage};
+                co_yield batch;
+            }
+        }
+
+        // The values of the documents of a batch; an error stops the batch at its line
+        template <typename R>
+        struct ndjson_result
+        {
+            std::vector<R> values;
+            size_t lines = 0;
+            std::exception_ptr error;
+        };
+
+        // Runs on a pool worker
+        template <typename R, typename F>
+        ndjson_result<R> ndjson_parse(const ndjson_batch& batch, F& func) noexcept
+        {
+            ndjson_result<R> result{};
+            const char* lineStart = batch.text.data();
+            const char* textEnd = batch.text.data() + batch.text.size();
+
+            try
+            {
+                detail::char_scanner scanner{lineStart, textEnd, "\n"};
+                while (lineStart != textEnd)
+                {
+                    const char* newline = scanner.next();
+                    const char* lineEnd = newline != nullptr ? newline : textEnd;
+                    const std::string_view line = detail::line_view(lineStart, lineEnd);
+                    lineStart = newline != nullptr ? newline + 1 : textEnd;
+                    ++result.lines;
+
+                    if (line.find_first_not_of(" \t") == std::string_view::npos)
+                    {
+                        continue;
+                    }
+
+                    nlohmann::json document = nlohmann::json::parse(line);
+                    result.values.push_back(func(document));
+                }
+            }
+            catch (...)
+            {
+                result.error = std::current_exception();
+            }
+            return result;
+        }
+
+        // Takes T by value when given an rvalue, so an upstream generator lives in this frame
+        template <typename R, typename T, typename F>
+        generator<R> ndjson_transform(thread_pool* pool, T source, F func, ndjson_options options)
+        {
+            detail::stage_probe probe{"ndjson"};
+            auto parse = [&func](const ndjson_batch& batch) { return ndjson_parse<R>(batch, func); };
+            auto batches = ndjson_batches(std::move(source), options.batch_bytes > 0 ? options.batch_bytes : 1);
+
+            // the lines of the batches already yielded
+            size_t line = 0;
+            for (const auto& result : detail::parallel_transform<decltype(batches), decltype(parse)>(
+                     pool, options.threads, std::move(batches), parse, options.window, true))
+            {
+                for (const auto& value : result.values)
+                {
+                    probe.element_in();
+                    co_yield probe.yield(value);
+                    probe.resume();
+                }
+
+                line += result.lines;
+                if (result.error)
+                {
+                    try
+                    {
+                        std::rethrow_exception(result.error);
+                    }
+                    catch (const nlohmann::json::parse_error& error)
+                    {
+                        throw std::runtime_error("ndjson: line " + std::to_string(line) + ": " + error.what());
+                    }
+                }
+            }
+        }
+
+        template <typename F>
+        using ndjson_result_t = std::decay_t<std::invoke_result_t<F&, nlohmann::json&>>;
+
+        // A source of NDJSON: text, or a range of text chunks such as file_chunks()
+        template <typename T>
+        concept ndjson_source =
+            std::is_convertible_v<T, std::string_view> || (ranges::range<T> && text_chunk<range_value_t<T>>);
+
+        template <typename T>
+        decltype(auto) ndjson_source_arg(T&& source)
+        {
+            if constexpr (std::is_convertible_v<T, std::string_view>)
+            {
+                return std::string_view{source};
+            }
+            else
+            {
+                return std::forward<T>(source);
+            }
+        }
+
+        template <typename T>
+        using ndjson_source_t = std::conditional_t<std::is_convertible_v<T, std::string_view>, std::string_view, T>;
+    }
+
+    /*
+       Parses newline-delimited JSON on the workers of pool: the input is cut into batches of whole
+       lines of about options.batch_bytes, each batch is parsed by one task, and func is applied
+       to every document on the worker that parsed it. The results are yielded in input order,
+       with at most options.window batches in flight, as in parallel_transform. Blank lines are
+       skipped. func is called concurrently and gets a document it may move from.
+
+       A malformed line throws std::runtime_error with its line number, and an exception thrown
+       by func propagates, once the values of the lines before it have been yielded.
+       The source is text, which must outlive the generator, or a range of text chunks, which
+       are copied into the batches. Rvalue ranges, such as generators, are moved into the generator.
+    */
+    template <typename T, typename F>
+        requires detail::ndjson_source<T> && std::is_invocable_v<F&, nlohmann::json&>
+    generator<detail::ndjson_result_t<F>> ndjson_transform(thread_pool& pool, T&& source, F&& func,
+                                                           ndjson_options options = {})
+    {
+        return detail::ndjson_transform<detail::ndjson_result_t<F>, detail::ndjson_source_t<T>, std::decay_t<F>>(
+            &pool, detail::ndjson_source_arg(std::forward<T>(source)), std::forward<F>(func), options);
+    }
+
+    // Same as above on a pool of options.threads workers owned by the generator
+    template <typename T, typename F>
+        requires detail::ndjson_source<T> && std::is_invocable_v<F&, nlohmann::json&>
+    generator<detail::ndjson_result_t<F>> ndjson_transform(T&& source, F&& func, ndjson_options options = {})
+    {
+        return detail::ndjson_transform<detail::ndjson_result_t<F>, detail::ndjson_source_t<T>, std::decay_t<F>>(
+            nullptr, detail::ndjson_source_arg(std::forward<T>(source)), std::forward<F>(func), options);
+    }
+
+    // Parses newline-delimited JSON in parallel like ndjson_transform and yields the documents in order
+    template <typename T>
+        requires detail::ndjson_source<T>
+    generator<nlohmann::json> ndjson_documents(thread_pool& pool, T&& source, ndjson_options options = {})
+    {
+        return ndjson_transform(
+            pool, std::forward<T>(source), [](nlohmann::json& document) { return std::move(document); }, options);
+    }
+
+    template <typename T>
+        requires detail::ndjson_source<T>
+    generator<nlohmann::json> ndjson_documents(T&& source, ndjson_options options = {})
+    {
+        return ndjson_transform(
+            std::forward<T>(source), [](nlohmann::json& document) { return std::move(document); }, options);
+    }
+
+} //namespace gentools
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <gentools.h>
+#include <gentools/thread_pool.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace gentools
+{
+    namespace detail
+    {
+        /*
+           The results of the tasks in flight of a parallel stage, one slot per element of the
+           reorder window. Completion is signalled under a mutex so the destructor, which waits for
+           every task still running, can never free the slots from under a task.
+        */
+        template <typename R>
+        class parallel_window
+        {
+        public:
+            parallel_window(size_t size, bool ordered)
+                : mSize(size)
+                , mOrdered(ordered)
+                , mSlots(std::make_unique<slot[]>(size))
+            {
+            }
+
+            ~parallel_window()
+            {
+                std::unique_lock lock{mMutex};
+                mCompleted.wait(lock, [this] { return mInFlight == 0; });
+            }
+
+            parallel_window(const parallel_window&) = delete;
+            parallel_window& operator=(const parallel_window&) = delete;
+
+            size_t size() const noexcept
+            {
+                return mSize;
+            }
+
+            void started() noexcept
+            {
+                std::lock_guard lock{mMutex};
+                ++mInFlight;
+            }
+
+            // The task of a started() slot could not be submitted
+            void abandoned() noexcept
+            {
+                std::lock_guard lock{mMutex};
+                --mInFlight;
+            }
+
+            // Runs on a pool worker
+            template <typename F>
+            void run(size_t index, F&& func) noexcept
+            {
+                auto& current = mSlots[index];
+                try
+                {
+                    current.result.emplace(func());
+                }
+                catch (...)
+                {
+                    current.exception = std::current_exception();
+                }
+
+                std::lock_guard lock{mMutex};
+                current.ready = true;
+                if (!mOrdered)
+                {
+                    mReady.push_back(index);
+                }
+                --mInFlight;
+                mCompleted.notify_all();
+            }
+
+            // Waits for the given slot, ordered mode
+            R& wait(size_t index)
+            {
+                auto& current = mSlots[index];
+                {
+                    std::unique_lock lock{mMutex};
+                    mCompleted.wait(lock, [&current] { return current.ready; });
+                }
+                return take(current);
+            }
+
+            // Waits for any slot, unordered mode
+            std::pair<size_t, R*> wait_any()
+            {
+                size_t index = 0;
+                {
+                    std::unique_lock lock{mMutex};
+                    mCompleted.wait(lock, [this] { return !mReady.empty(); });
+                    index = mReady.front();
+                    mReady.pop_front();
+                }
+                return {index, &take(mSlots[index])};
+            }
+
+            void reset(size_t index) noexcept
+            {
+                auto& current = mSlots[index];
+                current.result.reset();
+
+                std::lock_guard lock{mMutex};
+                current.ready = false;
+            }
+
+        private:
+            struct slot
+            {
+                std::optional<R> result;
+                std::exception_ptr exception;
+                bool ready = false;
+            };
+
+            static R& take(slot& current)
+            {
+                if (current.exception)
+                {
+                    std::rethrow_exception(current.exception);
+                }
+                return *current.result;
+            }
+
+            const size_t mSize;
+            const bool mOrdered;
+            std::unique_ptr<slot[]> mSlots;
+
+            std::mutex mMutex;
+            std::condition_variable mCompleted;
+            std::deque<size_t> mReady;
+            size_t mInFlight = 0;
+        };
+
+        // Takes T by value when given an rvalue and F always by value: both are used by the
+        // workers after the call that created the generator has returned
+        template <ranges::range T, typename F>
+        generator<range_value_invoke_result_t<T, F>> parallel_transform(thread_pool* pool, size_t threads, T range,
+                                                                        F func, size_t window, bool ordered)
+        {
+            using value_t = range_value_t<T>;
+            using result_t = range_value_invoke_result_t<T, F>;
+
+            detail::stage_probe probe{ordered ? "parallel_transform" : "parallel_transform_unordered"};
+
+            // declared before the window, so it outlives the tasks the window waits for
+            std::unique_ptr<thread_pool> ownPool{};
+            if (pool == nullptr)
+            {
+                ownPool = std::make_unique<thread_pool>(threads);
+                pool = ownPool.get();
+            }
+
+            parallel_window<result_t> slots{window > 0 ? window : 4 * pool->size(), ordered};
+
+            auto iter = ranges::begin(range);
+            const auto rangeEnd = ranges::end(range);
+
+            auto submit = [&](size_t index)
+            {
+                probe.element_in();
+                slots.started();
+                try
+                {
+                    pool->submit([&slots, &func, index, value = value_t(*iter)]() mutable
+                    {
+                        slots.run(index, [&func, &value] { return func(value); });
+                    });
+                }
+                catch (...)
+                {
+                    slots.abandoned();
+                    throw;
+                }
+                ++iter;
+            };
+
+            size_t submitted = 0;
+            while (submitted < slots.size() && iter != rangeEnd)
+            {
+                submit(submitted++);
+            }
+
+            for (size_t yielded = 0; yielded < submitted; ++yielded)
+            {
+                size_t index = 0;
+                result_t* result = nullptr;
+
+                if (ordered)
+                {
+                    index = yielded % slots.size();
+                    result = &slots.wait(index);
+                }
+                else
+                {
+                    std::tie(index, result) = slots.wait_any();
+                }
+
+                co_yield probe.yield(*result);
+                probe.resume();
+                slots.reset(index);
+
+                if (iter != rangeEnd)
+                {
+                    // in ordered mode the freed slot is the one of element yielded + window
+                    submit(ordered ? submitted % slots.size() : index);
+                    ++submitted;
+                }
+            }
+        }
+    }
+
+    /*
+       Applies func to every element of range on the workers of pool and yields the results in
+       input order. At most window elements (4 per worker by default) are in flight; once the
+       oldest one is done it is yielded and the next input element takes its place, so a slow
+       element holds back up to window - 1 finished ones. func is called concurrently and
+       elements are copied into the tasks. An exception thrown by func is rethrown when its
+       element would have been yielded.
+       Rvalue ranges, such as generators, are moved into the generator; lvalue ranges are referenced.
+    */
+    template <ranges::range T, invocable F>
+    generator<range_value_invoke_result_t<T, F>> parallel_transform(thread_pool& pool, T&& range, F&& func,
+                                                                    size_t window = 0)
+    {
+        return detail::parallel_transform<T, std::decay_t<F>>(&pool, 0, std::forward<T>(range), std::forward<F>(func),
+                                                              window, true);
+    }
+
+    // Same as above on a pool of the given number of threads (0 for one per hardware thread)
+    // owned by the generator
+    template <ranges::range T, invocable F>
+    generator<range_value_invoke_result_t<T, F>> parallel_transform(T&& range, F&& func, size_t threads = 0,
+                                                                    size_t window = 0)
+    {
+        return detail::parallel_transform<T, std::decay_t<F>>(nullptr, threads, std::forward<T>(range),
+                                                              std::forward<F>(func), window, true);
+    }
+
+    /*
+       Like parallel_transform, but yields every result as soon as it is ready, in completion
+       order, so a slow element never holds back the others.
+    */
+    template <ranges::range T, invocable F>
+    generator<range_value_invoke_result_t<T, F>> parallel_transform_unordered(thread_pool& pool, T&& range, F&& func,
+                                                                              size_t window = 0)
+    {
+        return detail::parallel_transform<T, std::decay_t<F>>(&pool, 0, std::forward<T>(range), std::forward<F>(func),
+                                                              window, false);
+    }
+
+    template <ranges::range T, invocable F>
+    generator<range_value_invoke_result_t<T, F>> parallel_transform_unordered(T&& range, F&& func, size_t threads = 0,
+                                                                              size_t window = 0)
+    {
+        return detail::parallel_transform<T, std::decay_t<F>>(nullptr, threads, std::forward<T>(range),
+                                                              std::forward<F>(func), window, false);
+    }
+
+} //namespace gentools
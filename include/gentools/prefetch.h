@@ -0,0 +1,316 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <gentools.h>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace gentools
+{
+    namespace detail
+    {
+        /*
+           Bounded single-producer single-consumer queue between the worker thread of prefetch and
+           its consumer. Head and tail are free-running counters, each written by one side only.
+           Both sides publish their counter once per batch rather than once per element, and only
+           block (on an event count, through C++20 atomic wait) when the ring is full or empty.
+           A consumer about to block raises a waiting flag, and the producer publishes every
+           element while it is raised, so an element is never held back waiting for its batch. The
+           consumer also checks the filled flag of the next slot after raising its own, so an
+           element pushed just before the producer could see the flag is not missed either.
+        */
+        template <typename T>
+        class prefetch_channel
+        {
+        public:
+            static constexpr size_t cache_line = 64;
+
+            explicit prefetch_channel(size_t capacity)
+                : mCapacity(round_up_to_power_of_two(capacity))
+                , mMask(mCapacity - 1)
+                , mBatch(mCapacity >= 8 ? mCapacity / 8 : 1)
+                , mSlots(std::make_unique<slot_type[]>(mCapacity))
+            {
+            }
+
+            // ---- producer side ----
+
+            // Blocks while the ring is full. Returns false when the consumer has gone away.
+            template <typename V>
+            bool push(V&& value)
+            {
+                while (mProducerTail - mProducerHeadCache == mCapacity)
+                {
+                    mProducerHeadCache = mHead.load(std::memory_order_acquire);
+                    if (mProducerTail - mProducerHeadCache < mCapacity)
+                    {
+                        break;
+                    }
+
+                    publish();
+
+                    const auto signal = mProducerSignal.load(std::memory_order_acquire);
+                    if (mStop.load(std::memory_order_acquire))
+                    {
+                        return false;
+                    }
+                    if (mProducerTail - mHead.load(std::memory_order_acquire) == mCapacity)
+                    {
+                        mProducerSignal.wait(signal, std::memory_order_acquire);
+                    }
+                }
+
+                auto& slot = mSlots[mProducerTail & mMask];
+                slot.value.emplace(std::forward<V>(value));
+                slot.filled.store(true, std::memory_order_seq_cst);
+                ++mProducerTail;
+
+                if (mProducerTail - mPublishedTail >= mBatch || mConsumerWaiting.load(std::memory_order_seq_cst))
+                {
+                    publish();
+                }
+
+                return !mStop.load(std::memory_order_relaxed);
+            }
+
+            void close(std::exception_ptr exception = nullptr) noexcept
+            {
+                mException = std::move(exception);
+                publish();
+                mDone.store(true, std::memory_order_release);
+                signal(mConsumerSignal);
+            }
+
+            // ---- consumer side ----
+
+            // Blocks until the range [head, tail) of filled slots is not empty, or the producer
+            // closed the channel, in which case head == tail is returned.
+            size_t wait_for_data(size_t head)
+            {
+                while (true)
+                {
+                    const auto signal = mConsumerSignal.load(std::memory_order_acquire);
+                    const bool done = mDone.load(std::memory_order_acquire);
+                    const auto tail = mTail.load(std::memory_order_acquire);
+
+                    // the published tail lags behind head after elements taken through their filled flag
+                    if (tail > head || done)
+                    {
+                        return tail;
+                    }
+
+                    mConsumerWaiting.store(true, std::memory_order_seq_cst);
+                    if (mSlots[head & mMask].filled.load(std::memory_order_seq_cst))
+                    {
+                        // pushed but not published yet
+                        mConsumerWaiting.store(false, std::memory_order_relaxed);
+                        return head + 1;
+                    }
+                    mConsumerSignal.wait(signal, std::memory_order_acquire);
+                    mConsumerWaiting.store(false, std::memory_order_relaxed);
+                }
+            }
+
+            std::optional<T>& slot(size_t index) noexcept
+            {
+                return mSlots[index & mMask].value;
+            }
+
+            // Empties a slot once its element has been consumed
+            void consumed(size_t index) noexcept
+            {
+                auto& slot = mSlots[index & mMask];
+                slot.value.reset();
+                slot.filled.store(false, std::memory_order_relaxed);
+            }
+
+            void release(size_t head) noexcept
+            {
+                mHead.store(head, std::memory_order_release);
+                signal(mProducerSignal);
+            }
+
+            size_t batch() const noexcept
+            {
+                return mBatch;
+            }
+
+            void rethrow_if_failed()
+            {
+                if (mException)
+                {
+                    std::rethrow_exception(mException);
+                }
+            }
+
+            void stop() noexcept
+            {
+                mStop.store(true, std::memory_order_release);
+                signal(mProducerSignal);
+            }
+
+        private:
+            static size_t round_up_to_power_of_two(size_t value) noexcept
+            {
+                size_t result = 1;
+                while (result < value)
+                {
+                    result <<= 1;
+                }
+                return result;
+            }
+
+            static void signal(std::atomic<uint32_t>& eventCount) noexcept
+            {
+                eventCount.fetch_add(1, std::memory_order_release);
+                eventCount.notify_one();
+            }
+
+            void publish() noexcept
+            {
+                if (mPublishedTail != mProducerTail)
+                {
+                    mPublishedTail = mProducerTail;
+                    mTail.store(mProducerTail, std::memory_order_release);
+                    signal(mConsumerSignal);
+                }
+            }
+
+            struct slot_type
+            {
+                std::optional<T> value;
+                std::atomic<bool> filled{false};
+            };
+
+            const size_t mCapacity;
+            const size_t mMask;
+            const size_t mBatch;
+            std::unique_ptr<slot_type[]> mSlots;
+
+            alignas(cache_line) std::atomic<size_t> mHead{0};
+            std::atomic<uint32_t> mProducerSignal{0};
+
+            alignas(cache_line) std::atomic<size_t> mTail{0};
+            std::atomic<uint32_t> mConsumerSignal{0};
+            std::atomic<bool> mDone{false};
+            std::atomic<bool> mStop{false};
+            std::atomic<bool> mConsumerWaiting{false};
+
+            // owned by the producer
+            alignas(cache_line) size_t mProducerTail = 0;
+            size_t mPublishedTail = 0;
+            size_t mProducerHeadCache = 0;
+            std::exception_ptr mException;
+        };
+
+        // Stops and joins the worker before the channel and the upstream range go away
+        class prefetch_worker
+        {
+        public:
+            template <typename F>
+            explicit prefetch_worker(F&& body, std::function<void()> stop)
+                : mStop(std::move(stop))
+                , mThread(std::forward<F>(body))
+            {
+            }
+
+            ~prefetch_worker()
+            {
+                mStop();
+                mThread.join();
+            }
+
+            prefetch_worker(const prefetch_worker&) = delete;
+            prefetch_worker& operator=(const prefetch_worker&) = delete;
+
+        private:
+            std::function<void()> mStop;
+            std::thread mThread;
+        };
+
+        // Takes T by value when prefetch is given an rvalue, so the upstream generator lives in this frame
+        template <ranges::range T>
+        generator<range_value_t<T>> prefetch(T range, size_t capacity)
+        {
+            using value_t = range_value_t<T>;
+
+            detail::stage_probe probe{"prefetch"};
+            // heap allocated: coroutine frames do not honor the cache line alignment of the channel
+            auto channelPtr = std::make_unique<prefetch_channel<value_t>>(capacity);
+            auto& channel = *channelPtr;
+
+            prefetch_worker worker{[&channel, &range]
+                {
+                    try
+                    {
+                        for (auto&& value : range)
+                        {
+                            if (!channel.push(value))
+                            {
+                                break;
+                            }
+                        }
+                        channel.close();
+                    }
+                    catch (...)
+                    {
+                        channel.close(std::current_exception());
+                    }
+                },
+                [&channel] { channel.stop(); }};
+
+            size_t head = 0;
+            while (true)
+            {
+                const auto tail = channel.wait_for_data(head);
+                if (tail == head)
+                {
+                    break;
+                }
+
+                for (; head != tail; ++head)
+                {
+                    auto& slot = channel.slot(head);
+                    probe.element_in();
+                    co_yield probe.yield(*slot);
+                    probe.resume();
+                    channel.consumed(head);
+
+                    if ((head + 1) % channel.batch() == 0)
+                    {
+                        channel.release(head + 1);
+                    }
+                }
+
+                if (head % channel.batch() != 0)
+                {
+                    channel.release(head);
+                }
+            }
+
+            channel.rethrow_if_failed();
+        }
+    }
+
+    /*
+       Runs the upstream range (typically a generator pipeline) on a worker thread that fills a
+       ring buffer of the given capacity ahead of the consumer, so an expensive producer overlaps
+       with the consumer. The worker blocks while the ring is full. An exception thrown upstream
+       is rethrown to the consumer once the elements produced before it have been consumed.
+       Destroying the generator stops and joins the worker.
+       Pass generators and other temporaries as rvalues: they are moved into the prefetch frame.
+       Lvalue ranges are referenced and must not be used by anyone else while the worker runs.
+    */
+    template <ranges::range T>
+    generator<range_value_t<T>> prefetch(T&& range, size_t capacity = 1024)
+    {
+        return detail::prefetch<T>(std::forward<T>(range), capacity);
+    }
+
+} //namespace gentools
@@ -0,0 +1,285 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <gentools.h>
+#include <gentools/thread_pool.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace gentools
+{
+    /*
+       How long a pipeline keeps its worker before it is put back in line: at most elements
+       elements, and no longer than time_slice (checked every few elements, 0 for no time limit).
+    */
+    struct schedule_quota
+    {
+        size_t elements = 256;
+        std::chrono::microseconds time_slice{500};
+    };
+
+    struct scheduler_stats
+    {
+        size_t spawned = 0;
+        size_t completed = 0;
+        size_t slices = 0;
+    };
+
+    namespace detail
+    {
+        class scheduled_pipeline
+        {
+        public:
+            virtual ~scheduled_pipeline() = default;
+
+            // Pulls one element through the pipeline, returns false once it is done
+            virtual bool step() = 0;
+        };
+
+        template <typename T, typename F>
+        class scheduled_range final : public scheduled_pipeline
+        {
+        public:
+            template <typename R, typename S>
+            scheduled_range(R&& range, S&& sink)
+                : mRange(std::forward<R>(range))
+                , mSink(std::forward<S>(sink))
+            {
+            }
+
+            bool step() override
+            {
+                // a generator only starts running on the worker that takes its first slice
+                if (!mIter)
+                {
+                    mIter.emplace(ranges::begin(mRange));
+                }
+
+                auto& iter = *mIter;
+                if (iter == ranges::end(mRange))
+                {
+                    return false;
+                }
+
+                if constexpr (std::is_same_v<std::invoke_result_t<F&, decltype(*iter)>, bool>)
+                {
+                    if (!mSink(*iter))
+                    {
+                        return false;
+                    }
+                }
+                else
+                {
+                    mSink(*iter);
+                }
+
+                ++iter;
+                return true;
+            }
+
+        private:
+            T mRange;
+            F mSink;
+            std::optional<ranges::iterator_t<T>> mIter;
+        };
+    }
+
+    /*
+       Runs many independent pipelines on a fixed pool of workers instead of one thread or one
+       loop per pipeline. Each pipeline is a range whose elements are handed to a sink; a worker
+       pulls elements through it for one quota, then puts it back in line behind the other
+       pipelines of its deque, where idle workers steal from, so pipelines share the cores fairly.
+       A sink returning bool stops its pipeline by returning false. An exception thrown by a
+       pipeline or its sink ends that pipeline only, and is rethrown by wait().
+       A pipeline is resumed by one worker at a time, but not always by the same one.
+    */
+    class scheduler
+    {
+    public:
+        // On a pool of the given number of threads (0 for one per hardware thread) owned by the scheduler
+        explicit scheduler(size_t threads = 0, schedule_quota quota = {})
+            : mOwnPool(std::make_unique<thread_pool>(threads))
+            , mPool(mOwnPool.get())
+            , mQuota(quota)
+        {
+        }
+
+        explicit scheduler(thread_pool& pool, schedule_quota quota = {})
+            : mPool(&pool)
+            , mQuota(quota)
+        {
+        }
+
+        // Cancels the pipelines still running and waits for them to be destroyed
+        ~scheduler()
+        {
+            cancel();
+
+            std::unique_lock lock{mMutex};
+            mIdle.wait(lock, [this] { return mActive == 0; });
+        }
+
+        scheduler(const scheduler&) = delete;
+        scheduler& operator=(const scheduler&) = delete;
+
+        /*
+           Schedules a pipeline. Rvalue ranges, such as generators, are moved into the scheduler;
+           lvalue ranges and the sink's captures are referenced and must outlive the pipeline.
+        */
+        template <ranges::range T, typename F>
+        void spawn(T&& range, F&& sink)
+        {
+            std::shared_ptr<detail::scheduled_pipeline> pipeline =
+                std::make_shared<detail::scheduled_range<T, std::decay_t<F>>>(std::forward<T>(range),
+                                                                              std::forward<F>(sink));
+            {
+                std::lock_guard lock{mMutex};
+                ++mActive;
+                ++mStats.spawned;
+            }
+            submit(std::move(pipeline), mGeneration.load(), false);
+        }
+
+        // Waits until every pipeline spawned so far is done, then rethrows the first exception one of them threw
+        void wait()
+        {
+            std::unique_lock lock{mMutex};
+            mIdle.wait(lock, [this] { return mActive == 0; });
+
+            if (mException)
+            {
+                std::rethrow_exception(std::exchange(mException, nullptr));
+            }
+        }
+
+        // Ends every pipeline at its next slice; pipelines spawned afterwards run normally
+        void cancel() noexcept
+        {
+            mGeneration.fetch_add(1);
+        }
+
+        size_t active() const
+        {
+            std::lock_guard lock{mMutex};
+            return mActive;
+        }
+
+        scheduler_stats stats() const
+        {
+            std::lock_guard lock{mMutex};
+            return mStats;
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        // how many elements are pulled between two reads of the clock
+        static constexpr size_t clock_interval = 16;
+
+        // generation is the value of mGeneration when the pipeline was spawned
+        void submit(std::shared_ptr<detail::scheduled_pipeline> pipeline, size_t generation, bool deferred)
+        {
+            auto work = [this, generation, pipeline = std::move(pipeline)]() mutable
+            {
+                run(std::move(pipeline), generation);
+            };
+
+            try
+            {
+                if (deferred)
+                {
+                    mPool->defer(std::move(work));
+                }
+                else
+                {
+                    mPool->submit(std::move(work));
+                }
+            }
+            catch (...)
+            {
+                finish(std::current_exception());
+            }
+        }
+
+        void run(std::shared_ptr<detail::scheduled_pipeline> pipeline, size_t generation)
+        {
+            if (generation != mGeneration.load())
+            {
+                pipeline.reset();
+                finish(nullptr);
+                return;
+            }
+
+            {
+                std::lock_guard lock{mMutex};
+                ++mStats.slices;
+            }
+
+            const auto deadline = clock::now() + mQuota.time_slice;
+            try
+            {
+                for (size_t pulled = 1;; ++pulled)
+                {
+                    if (!pipeline->step())
+                    {
+                        // destroyed before wait() can return, so nothing it references is used late
+                        pipeline.reset();
+                        finish(nullptr);
+                        return;
+                    }
+
+                    if (pulled >= mQuota.elements)
+                    {
+                        break;
+                    }
+                    if (mQuota.time_slice.count() > 0 && pulled % clock_interval == 0 && clock::now() >= deadline)
+                    {
+                        break;
+                    }
+                }
+            }
+            catch (...)
+            {
+                pipeline.reset();
+                finish(std::current_exception());
+                return;
+            }
+
+            submit(std::move(pipeline), generation, true);
+        }
+
+        void finish(std::exception_ptr exception)
+        {
+            std::lock_guard lock{mMutex};
+            if (exception && !mException)
+            {
+                mException = std::move(exception);
+            }
+
+            ++mStats.completed;
+            if (--mActive == 0)
+            {
+                mIdle.notify_all();
+            }
+        }
+
+        std::unique_ptr<thread_pool> mOwnPool;
+        thread_pool* mPool;
+        const schedule_quota mQuota;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mIdle;
+        size_t mActive = 0;
+        std::atomic<size_t> mGeneration{0};
+        std::exception_ptr mException;
+        scheduler_stats mStats{};
+    };
+
+} //namespace gentools
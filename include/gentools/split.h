@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <gentools.h>
+#include <gentools/char_scanner.h>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace gentools
+{
+    /*
+       The tokenizers yield views into text, which must outlive the generator. A text with n
+       delimiters has n + 1 tokens, some of which may be empty; an empty text has none.
+    */
+
+    // Splits text on every occurrence of delimiter
+    inline generator<std::string_view> split(std::string_view text, char delimiter)
+    {
+        detail::stage_probe probe{"split"};
+        if (text.empty())
+        {
+            co_return;
+        }
+
+        const char delimiters[] = {delimiter};
+        const char* tokenStart = text.data();
+        const char* textEnd = text.data() + text.size();
+
+        detail::char_scanner scanner{tokenStart, textEnd, {delimiters, 1}};
+        while (const char* found = scanner.next())
+        {
+            probe.element_in();
+            co_yield probe.yield(std::string_view{tokenStart, static_cast<size_t>(found - tokenStart)});
+            probe.resume();
+            tokenStart = found + 1;
+        }
+
+        probe.element_in();
+        co_yield probe.yield(std::string_view{tokenStart, static_cast<size_t>(textEnd - tokenStart)});
+        probe.resume();
+    }
+
+    // Splits text on every non-overlapping occurrence of the string delimiter, which must not be empty
+    inline generator<std::string_view> split(std::string_view text, std::string_view delimiter)
+    {
+        detail::stage_probe probe{"split"};
+        if (delimiter.empty())
+        {
+            throw std::invalid_argument("split: empty delimiter");
+        }
+        if (text.empty())
+        {
+            co_return;
+        }
+
+        const char* tokenStart = text.data();
+        const char* textEnd = text.data() + text.size();
+
+        // candidates are the occurrences of the first character of the delimiter
+        detail::char_scanner scanner{tokenStart, textEnd, delimiter.substr(0, 1)};
+        while (const char* found = scanner.next())
+        {
+            if (static_cast<size_t>(textEnd - found) < delimiter.size() ||
+                std::memcmp(found, delimiter.data(), delimiter.size()) != 0)
+            {
+                continue;
+            }
+
+            probe.element_in();
+            co_yield probe.yield(std::string_view{tokenStart, static_cast<size_t>(found - tokenStart)});
+            probe.resume();
+            tokenStart = found + delimiter.size();
+            scanner.skip_to(tokenStart);
+        }
+
+        probe.element_in();
+        co_yield probe.yield(std::string_view{tokenStart, static_cast<size_t>(textEnd - tokenStart)});
+        probe.resume();
+    }
+
+    // Splits text on every occurrence of any of the characters of delimiters, at most 8 of them
+    inline generator<std::string_view> split_any(std::string_view text, std::string_view delimiters)
+    {
+        detail::stage_probe probe{"split_any"};
+        if (text.empty())
+        {
+            co_return;
+        }
+
+        const char* tokenStart = text.data();
+        const char* textEnd = text.data() + text.size();
+
+        detail::char_scanner scanner{tokenStart, textEnd, delimiters};
+        while (const char* found = scanner.next())
+        {
+            probe.element_in();
+            co_yield probe.yield(std::string_view{tokenStart, static_cast<size_t>(found - tokenStart)});
+            probe.resume();
+            tokenStart = found + 1;
+        }
+
+        probe.element_in();
+        co_yield probe.yield(std::string_view{tokenStart, static_cast<size_t>(textEnd - tokenStart)});
+        probe.resume();
+    }
+
+    // Position of a token in the text it was split from
+    struct token_offsets
+    {
+        size_t offset = 0;
+        size_t length = 0;
+
+        std::string_view in(std::string_view text) const noexcept
+        {
+            return text.substr(offset, length);
+        }
+
+        friend bool operator==(const token_offsets&, const token_offsets&) = default;
+    };
+
+    namespace detail
+    {
+        inline generator<std::span<const token_offsets>> split_batches(std::pmr::memory_resource* resource,
+                                                                       std::string_view text, char delimiter,
+                                                                       size_t batchSize)
+        {
+            detail::stage_probe probe{"split_batches"};
+            if (text.empty())
+            {
+                co_return;
+            }
+
+            batchSize = batchSize > 0 ? batchSize : 1;
+            std::pmr::vector<token_offsets> batch{resource};
+            batch.reserve(batchSize);
+            probe.allocated(batchSize * sizeof(token_offsets));
+
+            const char delimiters[] = {delimiter};
+            const char* textStart = text.data();
+            const char* textEnd = text.data() + text.size();
+            size_t tokenStart = 0;
+
+            detail::char_scanner scanner{textStart, textEnd, {delimiters, 1}};
+            while (const char* found = scanner.next())
+            {
+                const auto position = static_cast<size_t>(found - textStart);
+                probe.element_in();
+                batch.push_back({tokenStart, position - tokenStart});
+                tokenStart = position + 1;
+
+                if (batch.size() == batchSize)
+                {
+                    co_yield probe.yield(std::span<const token_offsets>{batch});
+                    probe.resume();
+                    batch.clear();
+                }
+            }
+
+            probe.element_in();
+            batch.push_back({tokenStart, text.size() - tokenStart});
+            co_yield probe.yield(std::span<const token_offsets>{batch});
+            probe.resume();
+        }
+    }
+
+    /*
+       Batch mode of split: yields the offsets of up to batchSize tokens at a time, from one
+       buffer allocated up front and reused for every batch, which is only valid until the next
+       one is requested.
+    */
+    inline generator<std::span<const token_offsets>> split_batches(std::allocator_arg_t,
+                                                                   std::pmr::memory_resource* resource,
+                                                                   std::string_view text, char delimiter,
+                                                                   size_t batchSize = 1024)
+    {
+        frame_resource_scope scope{resource};
+        return detail::split_batches(resource, text, delimiter, batchSize);
+    }
+
+    inline generator<std::span<const token_offsets>> split_batches(std::string_view text, char delimiter,
+                                                                   size_t batchSize = 1024)
+    {
+        return detail::split_batches(current_frame_resource(), text, delimiter, batchSize);
+    }
+
+} //namespace gentools
@@ -0,0 +1,447 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <gentools/frame_allocator.h>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Define to 1 to instrument every gentools adaptor. When 0 (the default) the probes are empty
+// and compile out entirely. Must have the same value in every translation unit.
+#ifndef GENTOOLS_ENABLE_STATS
+#    define GENTOOLS_ENABLE_STATS 0
+#endif
+
+namespace gentools
+{
+    inline constexpr bool stats_enabled = GENTOOLS_ENABLE_STATS != 0;
+
+    /*
+       Counters of one pipeline stage, that is of one generator created by an instrumented adaptor.
+       name is the adaptor and label the innermost stats::label active when the stage started
+       running, empty if none was. elements_in counts the upstream elements the stage examined and
+       elements_out the elements it yielded, so out / in is the selectivity of filter-like stages.
+       nanoseconds is the time spent in the stage body itself: while a stage pulls from an upstream
+       stage the clock runs for the upstream one. allocated_bytes counts the frames created while
+       the stage ran and its own internal buffers.
+    */
+    struct stage_stats
+    {
+        std::string name;
+        std::string label;
+        uint64_t elements_in = 0;
+        uint64_t elements_out = 0;
+        uint64_t resumes = 0;
+        uint64_t nanoseconds = 0;
+        uint64_t allocated_bytes = 0;
+    };
+
+    namespace detail
+    {
+        inline const char*& thread_stats_label() noexcept
+        {
+            thread_local const char* label = nullptr;
+            return label;
+        }
+
+        struct stage_counters
+        {
+            stage_counters(const char* stageName, const char* stageLabel)
+                : name(stageName)
+                , label(stageLabel != nullptr ? stageLabel : "")
+            {
+            }
+
+            const char* name;
+            std::string label;
+            std::atomic<uint64_t> elements_in{0};
+            std::atomic<uint64_t> elements_out{0};
+            std::atomic<uint64_t> resumes{0};
+            std::atomic<uint64_t> nanoseconds{0};
+            std::atomic<uint64_t> allocated_bytes{0};
+            // set by the probe when its stage is destroyed, after which only the registry uses the counters
+            std::atomic<bool> finished{false};
+            stage_counters* next = nullptr;
+        };
+
+        /*
+           Every stage gets counters of its own, pushed on a lock-free list so creating a stage never
+           waits on another thread. The list is newest first and only snapshot() and reset(), which
+           serialize on the mutex, walk it; reset() is the only place counters are freed.
+        */
+        struct stage_registry
+        {
+            std::mutex mutex;
+            std::atomic<stage_counters*> head{nullptr};
+
+            stage_registry() = default;
+            stage_registry(const stage_registry&) = delete;
+            stage_registry& operator=(const stage_registry&) = delete;
+
+            ~stage_registry()
+            {
+                for (auto* stage = head.load(std::memory_order_acquire); stage != nullptr;)
+                {
+                    delete std::exchange(stage, stage->next);
+                }
+            }
+
+            static stage_registry& instance()
+            {
+                static stage_registry registry{};
+                return registry;
+            }
+
+            stage_counters& add(const char* name, const char* label)
+            {
+                auto* stage = new stage_counters{name, label};
+                push(stage);
+                return *stage;
+            }
+
+            void push(stage_counters* stage) noexcept
+            {
+                stage->next = head.load(std::memory_order_relaxed);
+                while (!head.compare_exchange_weak(stage->next, stage, std::memory_order_release,
+                                                   std::memory_order_relaxed))
+                {
+                }
+            }
+
+            // oldest first
+            template <typename F>
+            void for_each(F&& f)
+            {
+                std::vector<stage_counters*> stages;
+                for (auto* stage = head.load(std::memory_order_acquire); stage != nullptr; stage = stage->next)
+                {
+                    stages.push_back(stage);
+                }
+                for (auto it = stages.rbegin(); it != stages.rend(); ++it)
+                {
+                    f(**it);
+                }
+            }
+        };
+
+#if GENTOOLS_ENABLE_STATS
+        /*
+           Lives in the body of an adaptor coroutine, which yields with `co_yield probe.yield(value);`
+           followed by `probe.resume();`. The stage is running from construction until the first
+           yield() and from every resume() until the next yield(); while it runs it is the active
+           stage of the thread and the stage it interrupted is paused.
+        */
+        class stage_probe
+        {
+        public:
+            using clock = std::chrono::steady_clock;
+
+            explicit stage_probe(const char* name)
+                : mCounters(stage_registry::instance().add(name, thread_stats_label()))
+            {
+                resume();
+            }
+
+            ~stage_probe()
+            {
+                if (mRunning)
+                {
+                    pause();
+                }
+                mCounters.finished.store(true, std::memory_order_release);
+            }
+
+            stage_probe(const stage_probe&) = delete;
+            stage_probe& operator=(const stage_probe&) = delete;
+
+            void element_in(uint64_t count = 1) noexcept
+            {
+                mCounters.elements_in.fetch_add(count, std::memory_order_relaxed);
+            }
+
+            void allocated(uint64_t bytes) noexcept
+            {
+                mCounters.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            }
+
+            // Wraps a predicate so each element it is called with counts as an input
+            template <typename F>
+            auto count_in(F& pred) noexcept
+            {
+                return [this, &pred](auto&& value) {
+                    element_in();
+                    return pred(value);
+                };
+            }
+
+            // Wraps a predicate so only the elements it holds for count as inputs
+            template <typename F>
+            auto count_in_while(F& pred) noexcept
+            {
+                return [this, &pred](auto&& value) {
+                    const bool result = pred(value);
+                    if (result)
+                    {
+                        element_in();
+                    }
+                    return result;
+                };
+            }
+
+            // Marks the end of a run of the stage, just before its co_yield suspends it
+            template <typename V>
+            V&& yield(V&& value) noexcept
+            {
+                mCounters.elements_out.fetch_add(1, std::memory_order_relaxed);
+                pause();
+                return std::forward<V>(value);
+            }
+
+            // Marks the start of a run of the stage, right after its co_yield resumes
+            void resume() noexcept
+            {
+                mCounters.resumes.fetch_add(1, std::memory_order_relaxed);
+
+                const auto now = clock::now();
+                mPrevious = std::exchange(active(), this);
+                if (mPrevious != nullptr)
+                {
+                    mPrevious->stop(now);
+                }
+                start(now);
+                mRunning = true;
+            }
+
+        private:
+            static stage_probe*& active() noexcept
+            {
+                thread_local stage_probe* probe = nullptr;
+                return probe;
+            }
+
+            void pause() noexcept
+            {
+                const auto now = clock::now();
+                stop(now);
+                mRunning = false;
+
+                active() = mPrevious;
+                if (mPrevious != nullptr)
+                {
+                    mPrevious->start(now);
+                }
+            }
+
+            void start(clock::time_point now) noexcept
+            {
+                mStart = now;
+                mFrameBytesStart = thread_frame_counters().bytes;
+            }
+
+            void stop(clock::time_point now) noexcept
+            {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mStart);
+                mCounters.nanoseconds.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+                allocated(thread_frame_counters().bytes - mFrameBytesStart);
+            }
+
+            stage_counters& mCounters;
+            stage_probe* mPrevious = nullptr;
+            clock::time_point mStart{};
+            size_t mFrameBytesStart = 0;
+            bool mRunning = false;
+        };
+#else
+        class stage_probe
+        {
+        public:
+            explicit constexpr stage_probe(const char*) noexcept {}
+
+            constexpr void element_in(uint64_t = 1) const noexcept {}
+            constexpr void allocated(uint64_t) const noexcept {}
+
+            template <typename F>
+            constexpr F& count_in(F& pred) const noexcept
+            {
+                return pred;
+            }
+
+            template <typename F>
+            constexpr F& count_in_while(F& pred) const noexcept
+            {
+                return pred;
+            }
+
+            template <typename V>
+            constexpr V&& yield(V&& value) const noexcept
+            {
+                return std::forward<V>(value);
+            }
+
+            constexpr void resume() const noexcept {}
+        };
+#endif
+    }
+
+    /*
+       Snapshot of the counters of every instrumented stage, oldest first. Empty unless
+       GENTOOLS_ENABLE_STATS is 1.
+    */
+    struct stats
+    {
+        std::vector<stage_stats> stages;
+
+        /*
+           Labels the stages that start running on this thread while it is alive, so aggregate() can
+           tell apart the uses of an adaptor in different places. A stage starts running when it is
+           first resumed, not when its generator is created. Labels nest.
+        */
+        class label
+        {
+        public:
+            explicit label(const char* name) noexcept
+                : mPrevious(std::exchange(detail::thread_stats_label(), name))
+            {
+            }
+
+            ~label()
+            {
+                detail::thread_stats_label() = mPrevious;
+            }
+
+            label(const label&) = delete;
+            label& operator=(const label&) = delete;
+
+        private:
+            const char* mPrevious;
+        };
+
+        static stats snapshot()
+        {
+            stats result{};
+            if constexpr (stats_enabled)
+            {
+                auto& registry = detail::stage_registry::instance();
+                std::lock_guard lock{registry.mutex};
+
+                registry.for_each([&](detail::stage_counters& stage) {
+                    result.stages.push_back({stage.name,
+                                             stage.label,
+                                             stage.elements_in.load(std::memory_order_relaxed),
+                                             stage.elements_out.load(std::memory_order_relaxed),
+                                             stage.resumes.load(std::memory_order_relaxed),
+                                             stage.nanoseconds.load(std::memory_order_relaxed),
+                                             stage.allocated_bytes.load(std::memory_order_relaxed)});
+                });
+            }
+            return result;
+        }
+
+        // Forgets the stages that are finished and zeroes the counters of the others
+        static void reset()
+        {
+            auto& registry = detail::stage_registry::instance();
+            std::lock_guard lock{registry.mutex};
+
+            std::vector<detail::stage_counters*> running;
+            for (auto* stage = registry.head.exchange(nullptr, std::memory_order_acquire); stage != nullptr;)
+            {
+                auto* next = stage->next;
+                if (stage->finished.load(std::memory_order_acquire))
+                {
+                    delete stage;
+                }
+                else
+                {
+                    stage->elements_in = 0;
+                    stage->elements_out = 0;
+                    stage->resumes = 0;
+                    stage->nanoseconds = 0;
+                    stage->allocated_bytes = 0;
+                    running.push_back(stage);
+                }
+                stage = next;
+            }
+            // the list is newest first, so pushing back the oldest first keeps the order
+            for (auto it = running.rbegin(); it != running.rend(); ++it)
+            {
+                registry.push(*it);
+            }
+        }
+
+        // Sums the stages with the same adaptor name and label, in the order they first appear
+        stats aggregate() const
+        {
+            stats result{};
+            for (auto& stage : stages)
+            {
+                auto total = std::find_if(result.stages.begin(), result.stages.end(), [&](auto& other) {
+                    return other.name == stage.name && other.label == stage.label;
+                });
+                if (total == result.stages.end())
+                {
+                    result.stages.push_back(stage);
+                    continue;
+                }
+                total->elements_in += stage.elements_in;
+                total->elements_out += stage.elements_out;
+                total->resumes += stage.resumes;
+                total->nanoseconds += stage.nanoseconds;
+                total->allocated_bytes += stage.allocated_bytes;
+            }
+            return result;
+        }
+
+        // The first stage created by the adaptor name under label
+        const stage_stats* find(std::string_view name, std::string_view stageLabel = {}) const noexcept
+        {
+            for (auto& stage : stages)
+            {
+                if (stage.name == name && stage.label == stageLabel)
+                {
+                    return &stage;
+                }
+            }
+            return nullptr;
+        }
+
+        void print(std::ostream& out) const
+        {
+            for (auto& stage : stages)
+            {
+                const double selectivity = stage.elements_in > 0
+                    ? static_cast<double>(stage.elements_out) / static_cast<double>(stage.elements_in)
+                    : 0.;
+
+                if (!stage.label.empty())
+                {
+                    out << stage.label << ' ';
+                }
+                out << stage.name << ": in " << stage.elements_in << ", out " << stage.elements_out
+                    << " (selectivity " << selectivity << "), resumes " << stage.resumes << ", "
+                    << stage.nanoseconds / 1000 << " us, " << stage.allocated_bytes << " bytes allocated\n";
+            }
+        }
+
+        void print_json(std::ostream& out) const
+        {
+            out << '[';
+            for (size_t i = 0; i < stages.size(); ++i)
+            {
+                auto& stage = stages[i];
+                out << (i > 0 ? "," : "") << "{\"name\":\"" << stage.name << "\",\"label\":\"" << stage.label
+                    << "\",\"elements_in\":" << stage.elements_in << ",\"elements_out\":" << stage.elements_out
+                    << ",\"resumes\":" << stage.resumes << ",\"nanoseconds\":" << stage.nanoseconds
+                    << ",\"allocated_bytes\":" << stage.allocated_bytes << '}';
+            }
+            out << ']';
+        }
+    };
+
+} //namespace gentools
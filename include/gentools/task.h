@@ -0,0 +1,245 @@
+#pragma once
+
+#include <exception>
+#include <experimental/coroutine>
+#include <gentools/frame_allocator.h>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace gentools
+{
+    template <typename T = void>
+    class task;
+
+    namespace detail
+    {
+        using std::experimental::coroutine_handle;
+        using std::experimental::noop_coroutine;
+        using std::experimental::suspend_always;
+
+        // Transfers control to the coroutine waiting for the one that suspends, if any
+        struct continuation_awaiter
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            template <typename P>
+            coroutine_handle<> await_suspend(coroutine_handle<P> handle) noexcept
+            {
+                return handle.promise().continuation();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        // Frames of the async coroutines come from the same allocator as the generator frames
+        template <typename Tag>
+        struct frame_allocated
+        {
+            static void* operator new(size_t size)
+            {
+                return frame_allocator<char, Tag>{}.allocate(size);
+            }
+
+            static void operator delete(void* frame, size_t size) noexcept
+            {
+                frame_allocator<char, Tag>{}.deallocate(static_cast<char*>(frame), size);
+            }
+        };
+
+        template <typename T>
+        class task_promise_base : public frame_allocated<T>
+        {
+        public:
+            suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            continuation_awaiter final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception() noexcept
+            {
+                mException = std::current_exception();
+            }
+
+            coroutine_handle<> continuation() const noexcept
+            {
+                return mContinuation ? mContinuation : noop_coroutine();
+            }
+
+            void set_continuation(coroutine_handle<> continuation) noexcept
+            {
+                mContinuation = continuation;
+            }
+
+        protected:
+            void rethrow_if_failed()
+            {
+                if (mException)
+                {
+                    std::rethrow_exception(mException);
+                }
+            }
+
+        private:
+            coroutine_handle<> mContinuation{};
+            std::exception_ptr mException;
+        };
+
+        template <typename T>
+        class task_promise : public task_promise_base<T>
+        {
+        public:
+            task<T> get_return_object() noexcept;
+
+            template <typename V>
+            void return_value(V&& value)
+            {
+                mValue.emplace(std::forward<V>(value));
+            }
+
+            T result()
+            {
+                this->rethrow_if_failed();
+                return std::move(*mValue);
+            }
+
+        private:
+            std::optional<T> mValue;
+        };
+
+        template <>
+        class task_promise<void> : public task_promise_base<void>
+        {
+        public:
+            task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void result()
+            {
+                rethrow_if_failed();
+            }
+        };
+
+        template <typename T>
+        struct is_task : std::false_type {};
+
+        template <typename T>
+        struct is_task<task<T>> : std::true_type {};
+    }
+
+    template <typename T>
+    inline constexpr bool is_task_v = detail::is_task<std::remove_cvref_t<T>>::value;
+
+    /*
+       Lazily started coroutine producing a T. It starts running when it is co_awaited, the
+       awaiting coroutine is resumed once it returns, and an exception it throws is rethrown by
+       the co_await. Awaiting a task runs it inline: it only gives up the thread when it co_awaits
+       something that suspends, such as the I/O and timer awaitables of event_loop.
+    */
+    template <typename T>
+    class [[nodiscard]] task
+    {
+    public:
+        using promise_type = detail::task_promise<T>;
+        using handle_type = detail::coroutine_handle<promise_type>;
+        using value_type = T;
+
+        task() noexcept = default;
+
+        explicit task(handle_type handle) noexcept
+            : mHandle(handle)
+        {
+        }
+
+        task(task&& other) noexcept
+            : mHandle(std::exchange(other.mHandle, nullptr))
+        {
+        }
+
+        task& operator=(task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (mHandle)
+                {
+                    mHandle.destroy();
+                }
+                mHandle = std::exchange(other.mHandle, nullptr);
+            }
+            return *this;
+        }
+
+        ~task()
+        {
+            if (mHandle)
+            {
+                mHandle.destroy();
+            }
+        }
+
+        bool done() const noexcept
+        {
+            return !mHandle || mHandle.done();
+        }
+
+        // Throws std::logic_error on a default constructed or moved from task
+        auto operator co_await()
+        {
+            if (!mHandle)
+            {
+                throw std::logic_error("task: co_await on an empty task");
+            }
+
+            struct awaiter
+            {
+                handle_type handle;
+
+                bool await_ready() noexcept
+                {
+                    return handle.done();
+                }
+
+                detail::coroutine_handle<> await_suspend(detail::coroutine_handle<> awaiting) noexcept
+                {
+                    handle.promise().set_continuation(awaiting);
+                    return handle;
+                }
+
+                T await_resume()
+                {
+                    return handle.promise().result();
+                }
+            };
+
+            return awaiter{mHandle};
+        }
+
+    private:
+        handle_type mHandle{};
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        task<T> task_promise<T>::get_return_object() noexcept
+        {
+            return task<T>{task<T>::handle_type::from_promise(*this)};
+        }
+
+        inline task<void> task_promise<void>::get_return_object() noexcept
+        {
+            return task<void>{task<void>::handle_type::from_promise(*this)};
+        }
+    }
+
+} //namespace gentools
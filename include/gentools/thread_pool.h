@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace gentools
+{
+    /*
+       Fixed-size pool of worker threads with one task deque per worker. A worker pops its own
+       deque from the back (most recently pushed first, for locality) and, when it is empty,
+       steals from the front of the other workers' deques. Tasks submitted by a worker go to its
+       own deque, tasks submitted from outside the pool are spread round-robin.
+       The destructor runs every task already submitted before joining the workers.
+    */
+    class thread_pool
+    {
+    public:
+        using task = std::function<void()>;
+
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // 0 threads means one per hardware thread
+        explicit thread_pool(size_t threads = 0)
+        {
+            if (threads == 0)
+            {
+                threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+            }
+
+            mQueues.reserve(threads);
+            for (size_t i = 0; i < threads; ++i)
+            {
+                mQueues.push_back(std::make_unique<worker_queue>());
+            }
+
+            mThreads.reserve(threads);
+            for (size_t i = 0; i < threads; ++i)
+            {
+                mThreads.emplace_back([this, i] { run(i); });
+            }
+        }
+
+        ~thread_pool()
+        {
+            {
+                std::lock_guard lock{mSleepMutex};
+                mStop = true;
+            }
+            mWakeUp.notify_all();
+
+            for (auto& thread : mThreads)
+            {
+                thread.join();
+            }
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        void submit(task work)
+        {
+            const size_t worker = current_worker();
+            const size_t index = worker != npos ? worker : mNextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+
+            // counted before it is visible, so a worker never sees the counter drop below zero
+            mPending.fetch_add(1);
+            {
+                auto& queue = *mQueues[index];
+                std::lock_guard lock{queue.mutex};
+                queue.tasks.push_back(std::move(work));
+            }
+
+            wake_one();
+        }
+
+        /*
+           Resubmits a task that gave up its worker before it was done. From a worker it goes to the
+           front of the worker's own deque, behind the tasks already queued there and first in line
+           for thieves, so tasks that keep yielding take turns instead of starving the others.
+        */
+        void defer(task work)
+        {
+            const size_t worker = current_worker();
+            if (worker == npos)
+            {
+                submit(std::move(work));
+                return;
+            }
+
+            mPending.fetch_add(1);
+            {
+                auto& queue = *mQueues[worker];
+                std::lock_guard lock{queue.mutex};
+                queue.tasks.push_front(std::move(work));
+            }
+
+            wake_one();
+        }
+
+        size_t size() const noexcept
+        {
+            return mThreads.size();
+        }
+
+        // Index of the calling thread among the workers of this pool, or npos
+        size_t current_worker() const noexcept
+        {
+            return current().pool == this ? current().index : npos;
+        }
+
+    private:
+        struct worker_queue
+        {
+            std::mutex mutex;
+            std::deque<task> tasks;
+        };
+
+        struct worker_identity
+        {
+            const thread_pool* pool = nullptr;
+            size_t index = npos;
+        };
+
+        static worker_identity& current() noexcept
+        {
+            thread_local worker_identity identity{};
+            return identity;
+        }
+
+        void wake_one()
+        {
+            if (mSleeping.load() > 0)
+            {
+                std::lock_guard lock{mSleepMutex};
+                mWakeUp.notify_one();
+            }
+        }
+
+        bool try_pop(size_t index, task& work)
+        {
+            auto& queue = *mQueues[index];
+            std::lock_guard lock{queue.mutex};
+            if (queue.tasks.empty())
+            {
+                return false;
+            }
+
+            work = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+
+        bool try_steal(size_t thief, task& work)
+        {
+            for (size_t offset = 1; offset < mQueues.size(); ++offset)
+            {
+                auto& queue = *mQueues[(thief + offset) % mQueues.size()];
+                std::unique_lock lock{queue.mutex, std::try_to_lock};
+                if (!lock.owns_lock() || queue.tasks.empty())
+                {
+                    continue;
+                }
+
+                work = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+            return false;
+        }
+
+        void run(size_t index)
+        {
+            current() = {this, index};
+
+            task work;
+            while (true)
+            {
+                if (try_pop(index, work) || try_steal(index, work))
+                {
+                    mPending.fetch_sub(1);
+                    work();
+                    work = nullptr;
+                    continue;
+                }
+
+                std::unique_lock lock{mSleepMutex};
+                mSleeping.fetch_add(1);
+                mWakeUp.wait(lock, [this] { return mPending.load() > 0 || mStop; });
+                mSleeping.fetch_sub(1);
+
+                if (mStop && mPending.load() == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+        std::vector<std::unique_ptr<worker_queue>> mQueues;
+        std::vector<std::thread> mThreads;
+
+        std::atomic<size_t> mPending{0};
+        std::atomic<size_t> mSleeping{0};
+        std::atomic<size_t> mNextQueue{0};
+
+        std::mutex mSleepMutex;
+        std::condition_variable mWakeUp;
+        bool mStop = false;
+    };
+
+} //namespace gentools
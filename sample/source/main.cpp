@@ -13,6 +13,8 @@
 #include <vector>
 
 #include <gentools.h>
+#include <gentools/json.h>
+#include <gentools/json_query.h>
 
 void print(const nlohmann::json& js)
 {
@@ -30,81 +32,6 @@ void print(const nlohmann::json& js)
     }
 }
 
-using json_ref = std::reference_wrapper<nlohmann::json>;
-using json_value = std::variant<double, uint64_t, int64_t, bool, nullptr_t, std::string, json_ref>;
-
-json_value convert(nlohmann::json& json)
-{
-    if (json.is_structured()) return {std::ref(json)};
-    if (json.is_null()) return {nullptr};
-    if (json.is_boolean()) return {json.get<bool>()};
-    if (json.is_number_float()) return {json.get<double>()};
-    if (json.is_number_unsigned()) return {json.get<uint64_t>()};
-    if (json.is_number_integer()) return {json.get<int64_t>()};
-    if (json.is_string()) return {json.get<std::string>()}; //{std::string_view{json.get_ref<std::string&>()}};
-    return {nullptr};
-}
-
-struct traverse_recursive_fn
-{
-    auto operator()(nlohmann::json& jsonRoot) const -> gentools::generator<std::pair<std::string, json_value>>
-    {
-        for (auto&& item : jsonRoot.items())
-        {
-            co_yield std::make_pair(item.key(), convert(item.value()));
-
-            if (item.value().is_object())
-            {
-                for (auto&& [key, value] : (*this)(item.value()))
-                {
-                    co_yield std::make_pair(std::move(key), std::move(value));
-                }
-            }
-        }
-    }
-};
-
-inline constexpr traverse_recursive_fn traverse_recursive{};
-
-struct traverse_fn
-{
-    auto operator()(nlohmann::json& jsonRoot) const -> gentools::generator<std::pair<std::string, json_value>>
-    {
-        using namespace nlohmann;
-        std::vector<std::pair<std::string, json_ref>> stack{};
-        stack.reserve(jsonRoot.size());
-    
-        auto pushToStack = [&stack](json& jsonObject)
-        {
-            //std::cout << " - pustToStack ";
-            for (auto&& item : jsonObject.items())
-            {
-                //std::cout << item.key() << ' ' << item.value();
-                stack.emplace_back(item.key(), item.value());
-            }
-            //std::cout << '\n';
-        };
-        
-        pushToStack(jsonRoot);
-    
-        while (!stack.empty())
-        {
-            auto [jsonKey, jsonRef] = stack.back();
-            stack.pop_back();
-    
-            if (jsonRef.get().is_object())
-            {
-                //std::cout << jsonValue;
-                pushToStack(jsonRef.get());
-            }
-            
-            co_yield std::make_pair(/*std::move*/(jsonKey), convert(jsonRef.get()));
-        }
-    }
-};
-
-inline constexpr traverse_fn traverse{};
-
 namespace gentools
 {
     template <typename Range>
@@ -164,21 +91,30 @@ int main()
 
     //print(jdata);
     
-    //for (auto&& [jsonKey, jsonValue] : jdata | ranges::make_view_closure(traverse) | ranges::views::take(2))
-    auto gen = traverse_recursive(jdata);
-    for (auto&& [jsonKey, jsonValue] : traverse_recursive(jdata) | gentools::take(2))
+    //for (auto&& [jsonKey, jsonValue] : jdata | ranges::make_view_closure(gentools::traverse) | ranges::views::take(2))
+    for (auto&& [jsonKey, jsonValue] : gentools::traverse(jdata) | gentools::take(2))
     {
         std::cout << jsonKey << " asd "/* << value.second*/ << '\n';
         //std::cout << (jsonItem.value().is_object() ? jsonItem.key() : "k") << " - " << jsonItem.value() << '\n';
     }
 
-    //auto query = from(jdata).where(KEY, equals, "pi").select(ALL);
-    //auto result = query();
-    //// result == {"pi", 3.141}
-    //
-    //auto query = from(jdata).where(KEY, equals, "happy").select(VALUE);
-    //auto result = query();
-    //// result == true
+    using gentools::json_field;
+    using gentools::json_op;
+    using gentools::json_select;
+
+    auto query = gentools::from(jdata).where(json_field::key, json_op::equals, "pi").select(json_select::all);
+    for (const auto& match : query())
+    {
+        // {"pi", 3.141}
+        std::cout << match.key << " = " << match.value.get<double>() << '\n';
+    }
+
+    auto happy = gentools::from(jdata).where(json_field::key, json_op::equals, "happy").select(json_select::value);
+    for (const auto& match : happy())
+    {
+        // true
+        std::cout << std::boolalpha << match.value.get<bool>() << '\n';
+    }
 
     return 0;
 }
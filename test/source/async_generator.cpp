@@ -0,0 +1,166 @@
+#include <chrono>
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <gentools/async_generator.h>
+#include <gentools/event_loop.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#    include <fcntl.h>
+#    include <unistd.h>
+#endif
+
+namespace
+{
+	template <typename T>
+	gentools::task<std::vector<T>> collect(gentools::async_generator<T> source)
+	{
+		std::vector<T> results{};
+		while (const T* value = co_await source.next())
+		{
+			results.push_back(*value);
+		}
+		co_return results;
+	}
+
+	gentools::async_generator<int> ticks(gentools::event_loop& loop, int first, int count,
+	                                      std::chrono::milliseconds period)
+	{
+		for (int i = first; i < first + count; ++i)
+		{
+			co_await loop.sleep_for(period);
+			co_yield i;
+		}
+	}
+}
+
+TEST_SUITE("async_generator")
+{
+	TEST_CASE("async_transform and async_filter")
+	{
+		const std::vector<int> input{1, 2, 3, 4, 5, 6};
+		gentools::event_loop loop{};
+
+		auto squares = gentools::async_transform(gentools::to_async(input), [](int x) { return x * x; });
+		auto even = gentools::async_filter(std::move(squares), [](int x) { return x % 2 == 0; });
+
+		const std::vector<int> expected{4, 16, 36};
+		CHECK(loop.run(collect(std::move(even))) == expected);
+	}
+
+	TEST_CASE("async stages await tasks and timers")
+	{
+		gentools::event_loop loop{};
+
+		auto labelled = gentools::async_transform(ticks(loop, 1, 3, std::chrono::milliseconds{1}),
+			[&loop](int x) -> gentools::task<std::string>
+			{
+				co_await loop.schedule();
+				co_return std::to_string(x);
+			});
+
+		const std::vector<std::string> expected{"1", "2", "3"};
+		CHECK(loop.run(collect(std::move(labelled))) == expected);
+	}
+
+	TEST_CASE("async_chain")
+	{
+		const std::vector<int> first{1, 2};
+		const std::vector<int> second{3};
+		gentools::event_loop loop{};
+
+		auto chained = gentools::async_chain(gentools::to_async(first), gentools::async_generator<int>{},
+		                                     gentools::to_async(second));
+
+		const std::vector<int> expected{1, 2, 3};
+		CHECK(loop.run(collect(std::move(chained))) == expected);
+	}
+
+	TEST_CASE("async_generator rethrows the exception of its producer")
+	{
+		gentools::event_loop loop{};
+
+		auto failing = gentools::async_transform(ticks(loop, 1, 3, std::chrono::milliseconds{0}), [](int x)
+		{
+			if (x == 2)
+			{
+				throw std::runtime_error("producer failure");
+			}
+			return x;
+		});
+
+		CHECK_THROWS_AS(loop.run(collect(std::move(failing))), std::runtime_error);
+	}
+
+	TEST_CASE("waiting pipelines overlap")
+	{
+		gentools::event_loop loop{};
+		std::vector<int> results{};
+
+		auto consume = [&results](gentools::async_generator<int> source) -> gentools::task<void>
+		{
+			while (const int* value = co_await source.next())
+			{
+				results.push_back(*value);
+			}
+		};
+
+		loop.spawn(consume(ticks(loop, 0, 5, std::chrono::milliseconds{20})));
+		loop.spawn(consume(ticks(loop, 100, 5, std::chrono::milliseconds{20})));
+		loop.run();
+
+		// run one after the other, the second pipeline would only start after the first one ended
+		REQUIRE(results.size() == 10);
+		const auto firstEnd = std::find(results.begin(), results.end(), 4);
+		const auto secondStart = std::find(results.begin(), results.end(), 100);
+		CHECK(secondStart < firstEnd);
+	}
+
+	TEST_CASE("awaiting an empty task throws")
+	{
+		gentools::event_loop loop{};
+
+		auto awaitEmpty = []() -> gentools::task<void>
+		{
+			co_await gentools::task<int>{};
+		};
+
+		CHECK_THROWS_AS(loop.run(awaitEmpty()), std::logic_error);
+	}
+
+#if defined(__linux__)
+	TEST_CASE("async_read_some waits on a pipe")
+	{
+		int fds[2];
+		REQUIRE(pipe2(fds, O_NONBLOCK) == 0);
+		gentools::event_loop loop{};
+
+		auto writer = [&loop](int fd) -> gentools::task<void>
+		{
+			for (const char* chunk : {"gen", "tools"})
+			{
+				co_await loop.sleep_for(std::chrono::milliseconds{5});
+				CHECK(write(fd, chunk, std::char_traits<char>::length(chunk)) > 0);
+			}
+			close(fd);
+		};
+
+		auto reader = [&loop](int fd) -> gentools::task<std::string>
+		{
+			std::string text{};
+			std::byte buffer[16];
+			while (size_t count = co_await gentools::async_read_some(loop, fd, buffer))
+			{
+				text.append(reinterpret_cast<const char*>(buffer), count);
+			}
+			co_return text;
+		};
+
+		loop.spawn(writer(fds[1]));
+		CHECK(loop.run(reader(fds[0])) == "gentools");
+		close(fds[0]);
+	}
+#endif
+}
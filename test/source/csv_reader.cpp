@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <gentools/csv_reader.h>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	using rows = std::vector<std::vector<std::string>>;
+
+	template <typename T>
+	rows collect(T&& records)
+	{
+		rows results{};
+		for (auto fields : records)
+		{
+			results.emplace_back(fields.begin(), fields.end());
+		}
+		return results;
+	}
+
+	std::vector<std::span<const char>> make_chunks(const std::string& text, size_t chunkSize)
+	{
+		std::vector<std::span<const char>> chunks{};
+		for (size_t i = 0; i < text.size(); i += chunkSize)
+		{
+			chunks.emplace_back(text.data() + i, std::min(chunkSize, text.size() - i));
+		}
+		return chunks;
+	}
+
+	// Records with quoted fields, doubled quotes, newlines within quotes and "\r\n"
+	void make_table(std::string& text, rows& expected)
+	{
+		text = "id,name,score\r\n";
+		for (int i = 0; i < 200; ++i)
+		{
+			std::string name = std::string(i % 23, static_cast<char>('a' + i % 26));
+			std::string quoted = name;
+			if (i % 3 == 0)
+			{
+				name += ",\"x\"\n";
+				quoted = "\"" + name.substr(0, name.size() - 5) + ",\"\"x\"\"\n\"";
+			}
+			else if (i % 4 == 0)
+			{
+				quoted = "\"" + name + "\"";
+			}
+			else if (i % 7 == 1)
+			{
+				// a quote within an unquoted field is kept as is
+				name += "\"q";
+				quoted = name;
+			}
+			text += std::to_string(i) + "," + quoted + "," + std::to_string(i * 0.5) + (i % 5 == 0 ? "\r\n" : "\n");
+			expected.push_back({std::to_string(i), name, std::to_string(i * 0.5)});
+		}
+	}
+}
+
+TEST_SUITE("csv_reader")
+{
+	TEST_CASE("csv rows")
+	{
+		const rows expected{{"a", "b", "c"}, {"", "x,y", ""}, {"say \"hi\"", "two\nlines", "last"}};
+		CHECK(collect(gentools::csv_rows("a,b,c\n,\"x,y\",\n\"say \"\"hi\"\"\",\"two\nlines\",last")) == expected);
+		CHECK(collect(gentools::csv_rows("a,b,c\r\n\r\n,\"x,y\",\n\n\"say \"\"hi\"\"\",\"two\nlines\",last\n")) ==
+			  expected);
+		CHECK(collect(gentools::csv_rows("")).empty());
+		CHECK(collect(gentools::csv_rows("a;b\n1;2", {';', '"', true})) == rows{{"1", "2"}});
+		CHECK(collect(gentools::csv_rows("a\"b,'c,d'", {',', '\''})) == rows{{"a\"b", "c,d"}});
+		CHECK_THROWS_AS(collect(gentools::csv_rows("a,\"b")), std::runtime_error);
+	}
+
+	TEST_CASE("csv rows straddling chunks")
+	{
+		std::string text{};
+		rows expected{};
+		make_table(text, expected);
+
+		CHECK(collect(gentools::csv_rows(text, {',', '"', true})) == expected);
+		for (size_t chunkSize : {1, 2, 3, 5, 63, 64, 65, 1000})
+		{
+			const auto chunks = make_chunks(text, chunkSize);
+			CHECK(collect(gentools::csv_rows(chunks, {',', '"', true})) == expected);
+		}
+
+		// a stray quote in a carried record does not open a quoted field
+		const std::string stray = "a,bc\"d\ne,f\ng,h\n";
+		const std::vector<std::string_view> strayChunks{std::string_view{stray}.substr(0, 3),
+														 std::string_view{stray}.substr(3)};
+		CHECK(collect(gentools::csv_rows(strayChunks)) == rows{{"a", "bc\"d"}, {"e", "f"}, {"g", "h"}});
+		CHECK(collect(gentools::csv_rows(strayChunks)) == collect(gentools::csv_rows(stray)));
+	}
+
+	TEST_CASE("csv rows with a single column keep blank lines")
+	{
+		const std::string text = "name\nx\n\ny\r\n\r\nz\n";
+		const rows expected{{"name"}, {"x"}, {""}, {"y"}, {""}, {"z"}};
+		CHECK(collect(gentools::csv_rows(text)) == expected);
+		for (size_t chunkSize : {1, 2, 3, 4, 100})
+		{
+			CHECK(collect(gentools::csv_rows(make_chunks(text, chunkSize))) == expected);
+		}
+
+		CHECK(collect(gentools::csv_rows("\na,b\n\nc,d\n")) == rows{{"a", "b"}, {"c", "d"}});
+	}
+
+	TEST_CASE("csv rows bound the records carried across chunks")
+	{
+		// a quoted field spanning many lines is scanned once per chunk
+		std::string text = "a,\"";
+		for (int i = 0; i < 100000; ++i)
+		{
+			text += "x\n";
+		}
+		text += "\",z\n";
+		const auto records = collect(gentools::csv_rows(make_chunks(text, 64)));
+		REQUIRE(records.size() == 1);
+		CHECK(records[0][1].size() == 200000);
+		CHECK(records[0][2] == "z");
+
+		// an unterminated quote makes the rest of the input one record
+		std::string unterminated = "a,b\n1,\"open\n";
+		for (int i = 0; i < 1000; ++i)
+		{
+			unterminated += "line,\n";
+		}
+		gentools::csv_options options{};
+		options.max_record_bytes = 1000;
+		CHECK_THROWS_AS(collect(gentools::csv_rows(make_chunks(unterminated, 64), options)), std::runtime_error);
+		CHECK_THROWS_AS(collect(gentools::csv_rows(make_chunks(unterminated, 64))), std::runtime_error);
+	}
+
+	TEST_CASE("csv columns")
+	{
+		std::string text{};
+		rows expected{};
+		make_table(text, expected);
+
+		for (size_t chunkSize : {7, 100000})
+		{
+			const auto chunks = make_chunks(text, chunkSize);
+			rows results{};
+			size_t batches = 0;
+			for (const auto& batch : gentools::csv_columns(
+					 chunks, {gentools::csv_type::int64, gentools::csv_type::string, gentools::csv_type::float64},
+					 {',', '"', true}, 64))
+			{
+				REQUIRE(batch.columns() == 3);
+				CHECK(batch.size() <= 64);
+				CHECK(batch.type(1) == gentools::csv_type::string);
+				CHECK_THROWS_AS(batch.float64s(0), std::invalid_argument);
+				for (size_t i = 0; i < batch.size(); ++i)
+				{
+					results.push_back({std::to_string(batch.int64s(0)[i]), std::string{batch.strings(1)[i]},
+									   std::to_string(batch.float64s(2)[i])});
+				}
+				++batches;
+			}
+			CHECK(results == expected);
+			CHECK(batches == (expected.size() + 63) / 64);
+		}
+	}
+
+	TEST_CASE("csv columns from a memory resource")
+	{
+		std::pmr::monotonic_buffer_resource resource{};
+		int64_t sum = 0;
+		for (const auto& batch : gentools::csv_columns(std::allocator_arg, &resource, "1,x\n2,y\n3,z",
+													   {gentools::csv_type::int64, gentools::csv_type::string}))
+		{
+			for (auto value : batch.int64s(0))
+			{
+				sum += value;
+			}
+			CHECK(batch.strings(1)[2] == "z");
+		}
+		CHECK(sum == 6);
+	}
+
+	TEST_CASE("csv columns reject malformed records")
+	{
+		auto parse = [](std::string_view text) {
+			size_t rows = 0;
+			for (const auto& batch : gentools::csv_columns(text, {gentools::csv_type::int64, gentools::csv_type::float64}))
+			{
+				rows += batch.size();
+			}
+			return rows;
+		};
+
+		CHECK(parse("1,2.5\n-3,1e3") == 2);
+		CHECK_THROWS_AS(parse("1,2.5\nx,1"), std::runtime_error);
+		CHECK_THROWS_AS(parse("1,\n"), std::runtime_error);
+		CHECK_THROWS_AS(parse("1,2,3\n"), std::runtime_error);
+	}
+}
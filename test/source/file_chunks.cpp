@@ -0,0 +1,156 @@
+#include <cstddef>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <fstream>
+#include <gentools/file_chunks.h>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <sys/stat.h>
+#endif
+
+#include "temporary_file.h"
+
+namespace
+{
+	std::string make_content(size_t size)
+	{
+		std::string content(size, '\0');
+		for (size_t i = 0; i < size; ++i)
+		{
+			content[i] = static_cast<char>('a' + (i * 7) % 26);
+		}
+		return content;
+	}
+
+	std::string read_all(const std::filesystem::path& path, gentools::file_chunk_options options, size_t& chunks)
+	{
+		std::string result{};
+		chunks = 0;
+		for (auto chunk : gentools::file_chunks(path, options))
+		{
+			CHECK(chunk.size() <= options.chunk_size);
+			result.append(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+			++chunks;
+		}
+		return result;
+	}
+}
+
+TEST_SUITE("file_chunks")
+{
+	TEST_CASE("file_chunks reads the whole file")
+	{
+		const auto content = make_content(100000);
+		gentools_tests::temporary_file file{"gentools_file_chunks", content};
+
+		for (bool useIoUring : {true, false})
+		{
+			size_t chunks = 0;
+			CHECK(read_all(file.path, {4096, 3, useIoUring}, chunks) == content);
+			CHECK(chunks == 25);
+		}
+	}
+
+	TEST_CASE("file_chunks of an empty file")
+	{
+		gentools_tests::temporary_file file{"gentools_file_chunks", ""};
+		size_t chunks = 0;
+		CHECK(read_all(file.path, {}, chunks).empty());
+		CHECK(chunks == 0);
+	}
+
+	TEST_CASE("file_chunks stops early with reads in flight")
+	{
+		const auto content = make_content(64 * 1024);
+		gentools_tests::temporary_file file{"gentools_file_chunks", content};
+
+		for (auto chunk : gentools::file_chunks(file.path, {1024, 8, true}))
+		{
+			CHECK(std::string(reinterpret_cast<const char*>(chunk.data()), chunk.size()) == content.substr(0, 1024));
+			break;
+		}
+	}
+
+	TEST_CASE("file_chunks reads what a file grows by while it is read")
+	{
+		const auto content = make_content(10000);
+
+		for (bool useIoUring : {true, false})
+		{
+			gentools_tests::temporary_file file{"gentools_file_chunks", content};
+			std::string result{};
+			for (auto chunk : gentools::file_chunks(file.path, {4096, 2, useIoUring}))
+			{
+				if (result.empty())
+				{
+					std::ofstream out{file.path, std::ios::binary | std::ios::app};
+					out << "tail";
+				}
+				result.append(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+			}
+			CHECK(result == content + "tail");
+		}
+	}
+
+	TEST_CASE("file_chunks of a file truncated while it is read")
+	{
+		const auto content = make_content(100000);
+
+		for (bool useIoUring : {true, false})
+		{
+			gentools_tests::temporary_file file{"gentools_file_chunks", content};
+			std::string result{};
+			for (auto chunk : gentools::file_chunks(file.path, {4096, 3, useIoUring}))
+			{
+				if (result.empty())
+				{
+					std::filesystem::resize_file(file.path, 10000);
+				}
+				// both readers end at the first empty read, rather than yield empty chunks
+				CHECK(!chunk.empty());
+				result.append(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+			}
+			// the chunks already in flight may have been read before the truncation
+			CHECK(result.size() >= 10000);
+			CHECK(content.starts_with(result));
+		}
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	TEST_CASE("file_chunks of a pipe")
+	{
+		const auto content = make_content(100000);
+
+		for (bool useIoUring : {true, false})
+		{
+			gentools_tests::temporary_file fifo{"gentools_file_chunks_fifo"};
+			REQUIRE(::mkfifo(fifo.path.c_str(), 0600) == 0);
+
+			// opening a fifo blocks until the other end is opened too
+			std::thread writer{[&] {
+				std::ofstream out{fifo.path, std::ios::binary};
+				for (size_t offset = 0; offset < content.size(); offset += 10000)
+				{
+					out << content.substr(offset, 10000);
+					out.flush();
+				}
+			}};
+
+			size_t chunks = 0;
+			CHECK(read_all(fifo.path, {4096, 3, useIoUring}, chunks) == content);
+			CHECK(chunks == 25);
+			writer.join();
+		}
+	}
+#endif
+
+	TEST_CASE("file_chunks throws on a missing file")
+	{
+		auto chunks = gentools::file_chunks(std::filesystem::temp_directory_path() / "gentools_missing_file");
+		CHECK_THROWS_AS(chunks.begin(), std::system_error);
+	}
+}
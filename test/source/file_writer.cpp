@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <fstream>
+#include <gentools.h>
+#include <gentools/file_writer.h>
+#include <gentools/lines.h>
+#include <gentools/mmap_array.h>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "temporary_file.h"
+
+namespace
+{
+	struct record
+	{
+		uint32_t id;
+		double value;
+	};
+
+	std::string read_all(const std::filesystem::path& path)
+	{
+		std::ifstream in{path, std::ios::binary};
+		return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+	}
+}
+
+TEST_SUITE("file_writer")
+{
+	TEST_CASE("write records")
+	{
+		const gentools_tests::temporary_file file{"gentools_write_records"};
+		const auto& path = file.path;
+		auto toRecord = [](uint32_t id) { return record{id, id * 0.5}; };
+
+		// buffers smaller than, and not a multiple of, the record size exercise the splitting
+		for (auto options : {gentools::file_write_options{}, gentools::file_write_options{7, 2, true},
+							 gentools::file_write_options{100, 3, false, gentools::fsync_policy::every_flush},
+							 gentools::file_write_options{4096, 1, true, gentools::fsync_policy::on_close}})
+		{
+			std::vector<uint32_t> ids{};
+			for (uint32_t i = 0; i < 1000; ++i)
+			{
+				ids.push_back(i);
+			}
+
+			CHECK(gentools::write_records(gentools::transform(ids, toRecord), path, options) == 1000);
+
+			const auto mapped = gentools::mmap_array<record>(path);
+			REQUIRE(mapped.size() == 1000);
+			for (uint32_t i = 0; i < 1000; ++i)
+			{
+				CHECK(mapped.data()[i].id == i);
+				CHECK(mapped.data()[i].value == i * 0.5);
+			}
+		}
+
+		CHECK(gentools::write_records(std::vector<bool>{true, false, true}, path) == 3);
+		CHECK(read_all(path) == std::string{"\1\0\1", 3});
+
+		CHECK(gentools::write_records(std::vector<int>{}, path) == 0);
+		CHECK(std::filesystem::file_size(path) == 0);
+	}
+
+	TEST_CASE("write lines")
+	{
+		const gentools_tests::temporary_file file{"gentools_write_lines"};
+		const auto& path = file.path;
+		std::vector<std::string> lines{};
+		std::string expected{};
+		for (size_t i = 0; i < 500; ++i)
+		{
+			lines.push_back(std::string(i % 41, static_cast<char>('a' + i % 26)));
+			expected += lines.back() + "\n";
+		}
+
+		for (auto options : {gentools::file_write_options{}, gentools::file_write_options{16, 4, true},
+							 gentools::file_write_options{16, 4, false}})
+		{
+			CHECK(gentools::write_lines(lines, path, options) == lines.size());
+			CHECK(read_all(path) == expected);
+		}
+
+		// a round trip through the line splitter
+		CHECK(gentools::write_lines(gentools::lines(expected), path) == lines.size());
+		CHECK(read_all(path) == expected);
+	}
+
+	TEST_CASE("write to a missing directory")
+	{
+		const gentools_tests::temporary_file directory{"gentools_missing_directory"};
+		const auto path = directory.path / "file";
+		CHECK_THROWS_AS(gentools::write_lines(std::vector<std::string>{"a"}, path), std::system_error);
+	}
+}
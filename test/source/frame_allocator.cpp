@@ -0,0 +1,254 @@
+#include <doctest/doctest.h>
+#include <cstddef>
+#include <gentools.h>
+#include <memory_resource>
+#include <optional>
+#include <range/v3/algorithm/equal.hpp>
+#include <range/v3/range/conversion.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+template <typename T>
+inline auto genToVec(T&& gen)
+{
+	return ranges::make_subrange(std::forward<T>(gen)) | ranges::to<std::vector>;
+}
+
+TEST_SUITE("frame_allocator")
+{
+	TEST_CASE("frame counters track generator frames")
+	{
+		const std::vector<int> input{1, 2, 3};
+		const auto before = gentools::thread_frame_counters();
+		{
+			auto gen = gentools::transform(input, [](auto x) { return x * 2; });
+			int sum = 0;
+			for (auto v : gen)
+			{
+				sum += v;
+			}
+			CHECK(sum == 12);
+
+			// the one frame of the transform, still alive
+			const auto live = gentools::thread_frame_counters() - before;
+			CHECK(live.allocations == 1);
+			CHECK(live.deallocations == 0);
+			CHECK(live.bytes > 0);
+			CHECK(live.live_bytes == live.bytes);
+		}
+		const auto after = gentools::thread_frame_counters() - before;
+
+		CHECK(after.allocations == 1);
+		CHECK(after.deallocations == 1);
+		CHECK(after.live_bytes == 0);
+	}
+}
+
+namespace
+{
+	struct counting_resource : std::pmr::memory_resource
+	{
+		size_t allocations = 0;
+		size_t deallocations = 0;
+
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			++allocations;
+			return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+		}
+
+		void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+		{
+			++deallocations;
+			std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+	};
+}
+
+TEST_SUITE("memory_resource")
+{
+	TEST_CASE("adaptor frame from resource")
+	{
+		counting_resource resource{};
+		const std::vector<int> input{1, 2, 3, 4};
+		{
+			auto gen = gentools::filter(std::allocator_arg, &resource, input, [](auto x) { return x % 2 == 0; });
+			const int expected[2] = { 2, 4 };
+			CHECK(ranges::equal(genToVec(gen), expected));
+			CHECK(resource.allocations == 1);
+		}
+		CHECK(resource.deallocations == resource.allocations);
+		CHECK(gentools::current_frame_resource() == std::pmr::get_default_resource());
+	}
+
+	TEST_CASE("chain frames and buffers from resource")
+	{
+		counting_resource resource{};
+		const std::vector<int> a{1, 2};
+		const std::vector<int> b{3};
+		{
+			auto gen = gentools::chain(std::allocator_arg, &resource, a, b);
+			const int expected[3] = { 1, 2, 3 };
+			CHECK(ranges::equal(genToVec(gen), expected));
+
+			// chain frame + generator list + one frame per range
+			CHECK(resource.allocations == 4);
+		}
+		CHECK(resource.deallocations == resource.allocations);
+	}
+
+	TEST_CASE("frame resource scope")
+	{
+		std::byte buffer[4096];
+		std::pmr::monotonic_buffer_resource arena{buffer, sizeof(buffer), std::pmr::null_memory_resource()};
+		const std::vector<int> input{1, 2, 3};
+		const std::string text{"ab"};
+
+		gentools::frame_resource_scope scope{&arena};
+		CHECK(gentools::current_frame_resource() == &arena);
+
+		auto gen = gentools::chain_heterogeneous(input, text);
+		size_t items = 0;
+		for (auto&& v : gen)
+		{
+			items += v.index() + 1;
+		}
+		CHECK(items == 7);
+	}
+}
+
+TEST_SUITE("frame_pool")
+{
+	TEST_CASE("pipeline frames are recycled")
+	{
+		auto& pool = gentools::thread_frame_pool();
+		const std::vector<int> input{1, 2, 3};
+		auto run = [&input]
+		{
+			auto doubled = gentools::transform(input, [](auto x) { return x * 2; });
+			return genToVec(gentools::filter(doubled, [](auto x) { return x > 2; }));
+		};
+
+		run();
+		const auto before = pool.stats();
+		const auto results = run();
+		const auto after = pool.stats();
+
+		const int expected[2] = { 4, 6 };
+		CHECK(ranges::equal(results, expected));
+		CHECK(after.misses == before.misses);
+		CHECK(after.hits - before.hits == after.recycled - before.recycled);
+	}
+
+	TEST_CASE("pool capacity bounds the free lists")
+	{
+		gentools::frame_pool pool{};
+		pool.set_capacity(1);
+
+		void* a = pool.allocate(100);
+		void* b = pool.allocate(100);
+		pool.deallocate(a, 100);
+		pool.deallocate(b, 100);
+
+		CHECK(pool.cached(100) == 1);
+		CHECK(pool.stats().recycled == 1);
+		CHECK(pool.stats().released == 1);
+
+		CHECK(pool.allocate(100) == a);
+		CHECK(pool.stats().hits == 1);
+		pool.deallocate(a, 100);
+
+		pool.set_capacity(0);
+		CHECK(pool.cached(100) == 0);
+		CHECK(pool.stats().cached_bytes == 0);
+	}
+
+	TEST_CASE("frames outliving the thread pool are released")
+	{
+		using generator_type = decltype(gentools::count<int>());
+
+		// destroyed after the thread_frame_pool(), like a static owning a pipeline on the main thread
+		struct owner
+		{
+			std::optional<generator_type> gen;
+			bool* poolAlive;
+
+			~owner()
+			{
+				*poolAlive = gentools::thread_frame_pool_alive();
+				gen.reset();
+			}
+		};
+
+		bool poolAlive = true;
+		std::thread{[&poolAlive]
+		{
+			thread_local owner late{std::nullopt, &poolAlive};
+			CHECK(gentools::thread_frame_pool_alive());
+			late.gen.emplace(gentools::count<int>());
+			CHECK(*late.gen->begin() == 0);
+		}}.join();
+
+		CHECK_FALSE(poolAlive);
+	}
+}
+
+TEST_SUITE("frame_introspection")
+{
+	TEST_CASE("frame sizes are reported per generator function")
+	{
+		gentools::reset_frame_size_report();
+		gentools::enable_frame_introspection();
+
+		const std::vector<int> input{1, 2, 3};
+		auto doubled = gentools::transform(input, [](auto x) { return x * 2.0; });
+		CHECK(genToVec(doubled).size() == 3);
+
+		gentools::enable_frame_introspection(false);
+		const auto report = gentools::frame_size_report();
+
+		REQUIRE(report.size() == 1);
+		CHECK(report[0].function == "transform");
+		CHECK(report[0].type_name == "double");
+		CHECK(report[0].frame_bytes > 0);
+		CHECK(report[0].allocations == 1);
+
+		std::ostringstream out;
+		gentools::print_frame_size_report(out);
+		CHECK(out.str().find("transform generator<double>") != std::string::npos);
+
+		gentools::reset_frame_size_report();
+		CHECK(gentools::frame_size_report().empty());
+	}
+
+	TEST_CASE("nested frames are reported under the function creating them")
+	{
+		gentools::reset_frame_size_report();
+		gentools::enable_frame_introspection();
+
+		const std::vector<int> numbers{1, 2, 3};
+		const std::string letters{"ab"};
+		CHECK(genToVec(gentools::chain_heterogeneous(numbers, letters)).size() == 5);
+
+		gentools::enable_frame_introspection(false);
+
+		size_t chainFrames = 0;
+		size_t transformFrames = 0;
+		for (auto&& entry : gentools::frame_size_report())
+		{
+			chainFrames += entry.function == "chain_heterogeneous" ? entry.allocations : 0;
+			transformFrames += entry.function == "transform" ? entry.allocations : 0;
+		}
+		CHECK(chainFrames == 1);
+		CHECK(transformFrames == 2);
+
+		gentools::reset_frame_size_report();
+	}
+}
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <gentools/json.h>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace
+{
+	const nlohmann::json& sample()
+	{
+		static const nlohmann::json document = {
+			{"pi", 3.141},
+			{"happy", true},
+			{"name", "Niels"},
+			{"nothing", nullptr},
+			{"answer", {{"everything", 42}}},
+			{"list", {1, 0, 2}},
+			{"object", {{"currency", "USD"}, {"value", 42.99}, {"empty", nlohmann::json::object()}}},
+			{"unsigned", 7u},
+		};
+		return document;
+	}
+
+	template <typename T>
+	std::vector<std::string> keys(T&& items)
+	{
+		std::vector<std::string> results{};
+		for (const auto& item : items)
+		{
+			results.emplace_back(item.key);
+		}
+		return results;
+	}
+}
+
+TEST_SUITE("json")
+{
+	TEST_CASE("json values")
+	{
+		const auto& document = sample();
+		CHECK(gentools::to_json_value(document["pi"]).get<double>() == 3.141);
+		CHECK(gentools::to_json_value(document["happy"]).get<bool>());
+		CHECK(gentools::to_json_value(document["answer"]["everything"]).get<int64_t>() == 42);
+		CHECK(gentools::to_json_value(document["unsigned"]).get<uint64_t>() == 7);
+		CHECK(gentools::to_json_value(document["nothing"]).is<std::nullptr_t>());
+		CHECK(&gentools::to_json_value(document["list"]).get<gentools::json_ref>().get() == &document["list"]);
+
+		// strings reference the document
+		const auto name = gentools::to_json_value(document["name"]).get<std::string_view>();
+		CHECK(name == "Niels");
+		CHECK(name.data() == document["name"].get_ref<const std::string&>().data());
+
+		const gentools::json_value value = gentools::to_json_value(document["pi"]);
+		static_assert(sizeof(value) == 16);
+		CHECK(value.type() == gentools::json_value::kind::number_float);
+		CHECK_FALSE(value.is<int64_t>());
+		CHECK_THROWS_AS(value.get<int64_t>(), std::bad_variant_access);
+		CHECK(value.visit([](const auto& v) { return std::is_same_v<std::decay_t<decltype(v)>, double>; }));
+
+		// strings compare by content, objects and arrays by identity
+		const std::string copy = "Niels";
+		CHECK(gentools::json_value{std::string_view{copy}} == gentools::to_json_value(document["name"]));
+		CHECK(gentools::to_json_value(document["list"]) == gentools::to_json_value(document["list"]));
+		const nlohmann::json list = document["list"];
+		CHECK_FALSE(gentools::to_json_value(document["list"]) == gentools::to_json_value(list));
+		CHECK_FALSE(gentools::json_value{} == gentools::json_value{false});
+		CHECK(gentools::json_value{} == gentools::json_value{nullptr});
+
+		const int answer = 42;
+		const gentools::json_value fromInt = answer;
+		CHECK(fromInt.type() == gentools::json_value::kind::number_integer);
+		CHECK(fromInt.get<int64_t>() == 42);
+		CHECK(gentools::json_value{5u}.get<uint64_t>() == 5);
+		CHECK(gentools::json_value{true}.type() == gentools::json_value::kind::boolean);
+
+		// non-negative integers parse as unsigned, and still equal the same signed value
+		const auto parsedDocument = nlohmann::json::parse(R"({"answer": 42})");
+		const auto parsed = gentools::to_json_value(parsedDocument["answer"]);
+		REQUIRE(parsed.type() == gentools::json_value::kind::number_unsigned);
+		CHECK(parsed == gentools::json_value{42});
+		CHECK(gentools::json_value{42} == parsed);
+		CHECK_FALSE(parsed == gentools::json_value{-42});
+		CHECK_FALSE(gentools::json_value{-1} == gentools::json_value{std::numeric_limits<uint64_t>::max()});
+		CHECK_FALSE(parsed == gentools::json_value{42.});
+	}
+
+	TEST_CASE("traverse in document order")
+	{
+		const std::vector<std::string> expected{"answer", "everything", "happy", "list", "name", "nothing",
+												"object", "currency", "empty", "value", "pi", "unsigned"};
+		CHECK(keys(gentools::traverse(sample())) == expected);
+
+		CHECK(keys(gentools::traverse(nlohmann::json::object())).empty());
+		CHECK(keys(gentools::traverse(nlohmann::json::array({1, 2}))).empty());
+		CHECK(keys(gentools::traverse(nlohmann::json(1))).empty());
+	}
+
+	TEST_CASE("traverse yields views into the document")
+	{
+		const auto& document = sample();
+		for (const auto& item : gentools::traverse(document))
+		{
+			if (item.key == "currency")
+			{
+				CHECK(item.value.get<std::string_view>().data() ==
+					  document["object"]["currency"].get_ref<const std::string&>().data());
+			}
+			if (item.key == "answer")
+			{
+				CHECK(&item.value.get<gentools::json_ref>().get() == &document["answer"]);
+			}
+		}
+	}
+
+	TEST_CASE("traverse deep documents")
+	{
+		nlohmann::json document = nlohmann::json::object();
+		nlohmann::json* inner = &document;
+		for (int i = 0; i < 1000; ++i)
+		{
+			inner = &((*inner)["k" + std::to_string(i)] = nlohmann::json::object());
+		}
+
+		std::pmr::monotonic_buffer_resource resource{};
+		size_t count = 0;
+		for (const auto& item : gentools::traverse(std::allocator_arg, &resource, document))
+		{
+			CHECK(item.key == "k" + std::to_string(count));
+			++count;
+		}
+		CHECK(count == 1000);
+	}
+
+	TEST_CASE("traverse paths")
+	{
+		std::vector<std::string> paths{};
+		for (const auto& item : gentools::traverse_paths(sample()))
+		{
+			paths.emplace_back(item.path);
+		}
+
+		const std::vector<std::string> expected{
+			"/answer", "/answer/everything", "/happy", "/list", "/list/0", "/list/1", "/list/2", "/name", "/nothing",
+			"/object", "/object/currency", "/object/empty", "/object/value", "/pi", "/unsigned"};
+		CHECK(paths == expected);
+
+		// every path leads back to its value
+		for (const auto& item : gentools::traverse_paths(sample()))
+		{
+			const auto& pointed = sample().at(nlohmann::json::json_pointer{std::string{item.path}});
+			CHECK(gentools::to_json_value(pointed) == item.value);
+		}
+	}
+
+	TEST_CASE("traverse paths of arrays and escaped keys")
+	{
+		const auto document = nlohmann::json::parse(R"([{"a/b": [true, {"~": null}]}, [], 3])");
+		std::vector<std::string> paths{};
+		for (const auto& item : gentools::traverse_paths(document))
+		{
+			paths.emplace_back(item.path);
+			CHECK(gentools::to_json_value(document.at(nlohmann::json::json_pointer{paths.back()})) == item.value);
+		}
+
+		const std::vector<std::string> expected{"/0", "/0/a~1b", "/0/a~1b/0", "/0/a~1b/1", "/0/a~1b/1/~0", "/1", "/2"};
+		CHECK(paths == expected);
+	}
+
+	TEST_CASE("traverse nodes depth first and breadth first")
+	{
+		const auto document = nlohmann::json::parse(R"({"a": {"b": [1, {"c": 2}]}, "d": [3], "e": 4})");
+		const auto describe = [&](gentools::traversal_options options) {
+			std::vector<std::string> nodes{};
+			for (const auto& node : gentools::traverse_nodes(document, options))
+			{
+				nodes.push_back((node.key().empty() ? std::to_string(node.index()) : std::string{node.key()}) + '#' +
+								std::to_string(node.depth()));
+			}
+			return nodes;
+		};
+
+		using gentools::traversal_order;
+		CHECK(describe({}) == std::vector<std::string>{"a#1", "b#2", "0#3", "1#3", "c#4", "d#1", "0#2", "e#1"});
+		CHECK(describe({traversal_order::breadth_first}) ==
+			  std::vector<std::string>{"a#1", "d#1", "e#1", "b#2", "0#2", "0#3", "1#3", "c#4"});
+		CHECK(describe({traversal_order::depth_first, 2}) ==
+			  std::vector<std::string>{"a#1", "b#2", "d#1", "0#2", "e#1"});
+		CHECK(describe({traversal_order::breadth_first, 1}) == std::vector<std::string>{"a#1", "d#1", "e#1"});
+		CHECK(describe({traversal_order::depth_first, 0}).empty());
+		CHECK(describe({traversal_order::breadth_first, 3}).back() == "1#3");
+		CHECK(gentools::traverse_nodes(nlohmann::json(42)).begin() == gentools::traverse_nodes(nlohmann::json(42)).end());
+	}
+
+	TEST_CASE("traverse nodes skips children")
+	{
+		for (auto order : {gentools::traversal_order::depth_first, gentools::traversal_order::breadth_first})
+		{
+			std::vector<std::string> keys{};
+			for (const auto& node : gentools::traverse_nodes(sample(), {order}))
+			{
+				keys.emplace_back(node.key());
+				CHECK(gentools::to_json_value(node.json()) == node.value());
+				if (node.key() != "object")
+				{
+					node.skip_children();
+				}
+			}
+			// top-level members, and the members of "object" only
+			CHECK(keys.size() == 8 + 3);
+			CHECK(std::count(keys.begin(), keys.end(), "currency") == 1);
+			CHECK(std::count(keys.begin(), keys.end(), "everything") == 0);
+		}
+	}
+}
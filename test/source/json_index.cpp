@@ -0,0 +1,93 @@
+#include <doctest/doctest.h>
+#include <gentools/json_index.h>
+#include <gentools/json_query.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const auto document = nlohmann::json::parse(R"({
+		"name": "root",
+		"orders": [{"id": 7, "name": "first"}, {"id": -1, "name": "second", "nested": {"name": "third"}}],
+		"a/b": {"~x": [10, 20]}
+	})");
+
+	template <typename T>
+	std::vector<std::string> describe(T&& matches)
+	{
+		std::vector<std::string> results{};
+		for (const auto& match : matches)
+		{
+			results.push_back(std::string{match.key} + '@' + std::string{match.path} + '#' + std::to_string(match.depth));
+		}
+		return results;
+	}
+}
+
+TEST_SUITE("json_index")
+{
+	TEST_CASE("json index nodes")
+	{
+		const gentools::json_index index{document};
+		// the root, its 3 members, 2 orders with 2 and 3 members, 1 nested member, the array ~x and its 2 elements
+		CHECK(index.size() == 1 + 3 + 2 + 5 + 1 + 1 + 2);
+		CHECK(index.key_count() == 6);
+		CHECK(index.find_key("missing") == gentools::json_index::no_key);
+		CHECK(index.nodes("missing").empty());
+
+		std::vector<std::string> names{};
+		for (auto node : index.nodes("name"))
+		{
+			names.push_back(index.path(node) + '=' + index.value(node).get<std::string>());
+			CHECK(index.key_name(index.keys()[node]) == "name");
+		}
+		CHECK(names == std::vector<std::string>{"/name=root", "/orders/0/name=first", "/orders/1/name=second",
+												"/orders/1/nested/name=third"});
+
+		const auto elements = index.nodes("~x");
+		REQUIRE(elements.size() == 1);
+		const auto array = elements[0];
+		CHECK(index.path(array) == "/a~1b/~0x");
+		CHECK(index.depths()[array] == 2);
+		CHECK(index.path(index.parents()[array]) == "/a~1b");
+		CHECK(index.path(array + 2) == "/a~1b/~0x/1");
+		CHECK(index.positions()[array + 2] == 1);
+		CHECK(index.keys()[array + 2] == gentools::json_index::no_key);
+		CHECK(index.path(0).empty());
+	}
+
+	TEST_CASE("queries over an index agree with queries over the document")
+	{
+		using namespace gentools;
+
+		const json_index index{document};
+		const std::vector<json_query> queries{
+			from(document).where(json_field::key, json_op::equals, "name").select(),
+			from(document).where(json_field::key, json_op::equals, "name").where(json_field::depth, json_op::greater, 1).select(),
+			from(document).where(json_field::key, json_op::equals, "id").select(json_select::key),
+			from(document).where(json_field::key, json_op::equals, "missing").select(),
+			from(document).where(json_field::value, json_op::greater, 5).select(),
+			from(document).where(json_field::path, json_op::starts_with, "/orders/1").select(),
+			from(document).where(json_field::depth, json_op::less_equal, 1).select(json_select::value),
+		};
+		for (const auto& query : queries)
+		{
+			CHECK(describe(query(index)) == describe(query(document)));
+		}
+
+		CHECK(describe(from(index).where(json_field::key, json_op::equals, "id").select()()) ==
+			  std::vector<std::string>{"id@/orders/0/id#3", "id@/orders/1/id#3"});
+	}
+
+	TEST_CASE("an empty key matches array elements over an index too")
+	{
+		using namespace gentools;
+
+		const auto withEmptyKey = nlohmann::json::parse(R"({"": 1, "list": [2, {"": 3}]})");
+		const json_index index{withEmptyKey};
+
+		const auto expected = describe(from(withEmptyKey).where(json_field::key, json_op::equals, "").select()());
+		CHECK(expected == std::vector<std::string>{"@/#1", "@/list/0#2", "@/list/1#2", "@/list/1/#3"});
+		CHECK(describe(from(index).where(json_field::key, json_op::equals, "").select()()) == expected);
+	}
+}
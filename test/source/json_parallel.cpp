@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <gentools/json_parallel.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	nlohmann::json make_document()
+	{
+		nlohmann::json records = nlohmann::json::array();
+		for (int i = 0; i < 50; ++i)
+		{
+			records.push_back({{"id", i}, {"name", "record " + std::to_string(i)}, {"tags", {"a", "b"}}});
+		}
+		nlohmann::json logins = nlohmann::json::array();
+		for (int i = 0; i < 30; ++i)
+		{
+			logins.push_back(i);
+		}
+		return {{"meta", {{"count", 50}}}, {"records", std::move(records)}, {"stats", {{"logins", std::move(logins)}}}};
+	}
+
+	const nlohmann::json document = make_document();
+
+	template <typename T>
+	std::vector<std::string> describe_nodes(T&& nodes)
+	{
+		std::vector<std::string> results{};
+		for (const auto& node : nodes)
+		{
+			const std::string value = node.json().is_structured() ? "" : node.json().dump();
+			results.push_back((node.key().empty() ? std::to_string(node.index()) : std::string{node.key()}) + '#' +
+							  std::to_string(node.depth()) + '=' + value);
+		}
+		return results;
+	}
+
+	template <typename T>
+	std::vector<std::string> describe_matches(T&& matches)
+	{
+		std::vector<std::string> results{};
+		for (const auto& match : matches)
+		{
+			results.push_back(std::string{match.key} + '@' + std::string{match.path} + '#' + std::to_string(match.depth));
+		}
+		return results;
+	}
+}
+
+TEST_SUITE("json_parallel")
+{
+	TEST_CASE("json partitions cover the document in document order")
+	{
+		std::vector<std::string> nodes{};
+		std::vector<std::string> containers{};
+		for (const auto& partition : gentools::json_partitions(document, 8))
+		{
+			CHECK(std::distance(partition.begin(), partition.end()) <= 8);
+			containers.emplace_back(partition.path());
+			const auto partitionNodes = describe_nodes(gentools::traverse_nodes(partition));
+			nodes.insert(nodes.end(), partitionNodes.begin(), partitionNodes.end());
+		}
+		CHECK(nodes == describe_nodes(gentools::traverse_nodes(document)));
+
+		// the root up to records, 7 partitions of records, then the rest of the root: stats has a
+		// single child, so it is not cut and its logins are walked with it
+		const std::vector<std::string> expected{"", "/records", "/records", "/records", "/records",
+												"/records", "/records", "/records", ""};
+		CHECK(containers == expected);
+		CHECK(gentools::json_partitions(nlohmann::json(1), 8).begin() == gentools::json_partitions(nlohmann::json(1), 8).end());
+	}
+
+	TEST_CASE("parallel queries agree with queries")
+	{
+		using namespace gentools;
+
+		const std::vector<json_query> queries{
+			from(document).where(json_field::key, json_op::equals, "id").select(),
+			from(document).where(json_field::value, json_op::greater_equal, 20).select(),
+			from(document).where(json_field::path, json_op::starts_with, "/records/1").select(),
+			from(document).where(json_field::path, json_op::starts_with, "/stats/logins/2").select(json_select::path),
+			from(document).where(json_field::depth, json_op::less_equal, 2).select(json_select::key),
+			from(document).where(json_field::key, json_op::equals, "missing").select(),
+		};
+
+		thread_pool pool{3};
+		for (const auto& query : queries)
+		{
+			const auto expected = describe_matches(query(document));
+			CHECK(describe_matches(parallel_query(pool, query, document, {4})) == expected);
+
+			auto unordered = describe_matches(parallel_query(query, document, {4, 2, 2, false}));
+			auto sorted = expected;
+			std::sort(unordered.begin(), unordered.end());
+			std::sort(sorted.begin(), sorted.end());
+			CHECK(unordered == sorted);
+		}
+	}
+
+	TEST_CASE("parallel traverse aggregates the partitions")
+	{
+		const auto sumIds = [](const gentools::json_partition& partition) {
+			int sum = 0;
+			for (const auto& node : gentools::traverse_nodes(partition))
+			{
+				if (node.key() == "id")
+				{
+					sum += node.json().get<int>();
+				}
+			}
+			return sum;
+		};
+
+		gentools::thread_pool pool{2};
+		for (bool ordered : {true, false})
+		{
+			int sum = 0;
+			size_t partitions = 0;
+			for (int partial : gentools::parallel_traverse(pool, document, sumIds, {5, 0, 0, ordered}))
+			{
+				sum += partial;
+				++partitions;
+			}
+			CHECK(sum == 49 * 50 / 2);
+			CHECK(partitions > 10);
+		}
+
+		const auto fail = [](const gentools::json_partition& partition) {
+			if (partition.path() == "/records" && partition.index() >= 40)
+			{
+				throw std::runtime_error("failed");
+			}
+			return partition.index();
+		};
+		CHECK_THROWS_AS(
+			[&] {
+				for ([[maybe_unused]] size_t index : gentools::parallel_traverse(document, fail, {4, 0, 2}))
+				{
+				}
+			}(),
+			std::runtime_error);
+	}
+}
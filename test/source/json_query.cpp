@@ -0,0 +1,136 @@
+#include <doctest/doctest.h>
+#include <gentools/json_query.h>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	const auto document = nlohmann::json::parse(R"({
+		"pi": 3.141, "happy": true, "name": "Niels", "nothing": null,
+		"answer": {"everything": 42},
+		"list": [1, 0, 2],
+		"object": {"currency": "USD", "value": 42.99},
+		"orders": [{"id": 7, "name": "first"}, {"id": -1, "name": "second", "nested": {"name": "third"}}]
+	})");
+
+	template <typename T>
+	std::vector<std::string> paths(T&& matches)
+	{
+		std::vector<std::string> results{};
+		for (const auto& match : matches)
+		{
+			results.emplace_back(match.path);
+		}
+		return results;
+	}
+}
+
+TEST_SUITE("json_query")
+{
+	TEST_CASE("select by key")
+	{
+		using namespace gentools;
+
+		auto query = from(document).where(json_field::key, json_op::equals, "pi").select(json_select::all);
+		size_t count = 0;
+		for (const auto& match : query())
+		{
+			// the views are valid until the generator resumes
+			CHECK(match.key == "pi");
+			CHECK(match.path == "/pi");
+			CHECK(match.depth == 1);
+			CHECK(match.value.get<double>() == 3.141);
+			++count;
+		}
+		CHECK(count == 1);
+
+		count = 0;
+		for (const auto& match : from(document).where(json_field::key, json_op::equals, "happy").select(json_select::value)())
+		{
+			CHECK(match.key.empty());
+			CHECK(match.path.empty());
+			CHECK(match.value.get<bool>());
+			++count;
+		}
+		CHECK(count == 1);
+
+		const std::vector<std::string> names{"/name", "/orders/0/name", "/orders/1/name", "/orders/1/nested/name"};
+		CHECK(paths(from(document).where(json_field::key, json_op::equals, std::string{"name"}).select()()) == names);
+	}
+
+	TEST_CASE("value predicates")
+	{
+		using namespace gentools;
+
+		const std::vector<std::string> large{"/answer/everything", "/object/value", "/orders/0/id"};
+		CHECK(paths(from(document).where(json_field::value, json_op::greater_equal, 7).select()()) == large);
+		CHECK(paths(from(document).where(json_field::value, json_op::greater, 42.5).select()()) ==
+			  std::vector<std::string>{"/object/value"});
+		CHECK(paths(from(document).where(json_field::value, json_op::less, 0u).select()()) ==
+			  std::vector<std::string>{"/orders/1/id"});
+		CHECK(paths(from(document).where(json_field::value, json_op::equals, 0).select()()) ==
+			  std::vector<std::string>{"/list/1"});
+
+		CHECK(paths(from(document).where(json_field::value, json_op::starts_with, "th").select()()) ==
+			  std::vector<std::string>{"/orders/1/nested/name"});
+		CHECK(paths(from(document).where(json_field::value, json_op::contains, "ie").select()()) ==
+			  std::vector<std::string>{"/name"});
+		CHECK(paths(from(document).where(json_field::value, json_op::equals, nullptr).select()()) ==
+			  std::vector<std::string>{"/nothing"});
+		CHECK(paths(from(document).where(json_field::value, json_op::equals, true).select()()) ==
+			  std::vector<std::string>{"/happy"});
+
+		// clauses combine with and
+		CHECK(paths(from(document)
+						.where(json_field::key, json_op::equals, "name")
+						.where(json_field::value, json_op::not_equals, "Niels")
+						.where(json_field::depth, json_op::less, 4)
+						.select()()) == std::vector<std::string>{"/orders/0/name", "/orders/1/name"});
+	}
+
+	TEST_CASE("path and depth predicates prune the traversal")
+	{
+		using namespace gentools;
+
+		CHECK(paths(from(document).where(json_field::path, json_op::starts_with, "/orders/1").select()()) ==
+			  std::vector<std::string>{"/orders/1", "/orders/1/id", "/orders/1/name", "/orders/1/nested",
+									   "/orders/1/nested/name"});
+		CHECK(paths(from(document).where(json_field::path, json_op::equals, "/object/currency").select()()) ==
+			  std::vector<std::string>{"/object/currency"});
+		// "/orders/10" does not start with "/orders/1/"
+		CHECK(paths(from(document).where(json_field::path, json_op::starts_with, "/orders/1/").select()()).size() == 4);
+
+		std::vector<std::string> keys{};
+		for (const auto& match : from(document).where(json_field::depth, json_op::equals, 1).select(json_select::key)())
+		{
+			CHECK(match.path.empty());
+			keys.emplace_back(match.key);
+		}
+		CHECK(keys == std::vector<std::string>{"answer", "happy", "list", "name", "nothing", "object", "orders", "pi"});
+	}
+
+	TEST_CASE("query reuse")
+	{
+		using namespace gentools;
+
+		const auto query = from(document).where(json_field::key, json_op::equals, "id").select(json_select::path);
+		std::pmr::monotonic_buffer_resource resource{};
+		CHECK(paths(query(std::allocator_arg, &resource, document)) ==
+			  std::vector<std::string>{"/orders/0/id", "/orders/1/id"});
+		CHECK(paths(query(nlohmann::json::parse(R"({"id": 1})"))) == std::vector<std::string>{"/id"});
+		CHECK(paths(query(nlohmann::json::parse("[]"))).empty());
+	}
+
+	TEST_CASE("invalid clauses")
+	{
+		using namespace gentools;
+
+		CHECK_THROWS_AS(from(document).where(json_field::key, json_op::equals, 1), std::invalid_argument);
+		CHECK_THROWS_AS(from(document).where(json_field::depth, json_op::equals, "1"), std::invalid_argument);
+		CHECK_THROWS_AS(from(document).where(json_field::value, json_op::contains, 1), std::invalid_argument);
+		CHECK_THROWS_AS(from(document).where(json_field::value, json_op::less, true), std::invalid_argument);
+	}
+}
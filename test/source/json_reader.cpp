@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <gentools/json.h>
+#include <gentools/json_reader.h>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	// "path token text" per event
+	template <typename T>
+	std::vector<std::string> describe(T&& events)
+	{
+		std::vector<std::string> results{};
+		for (const auto& event : events)
+		{
+			results.push_back(std::string{event.path()} + ' ' + std::to_string(static_cast<int>(event.token())) + ' ' +
+							  std::string{event.text()});
+		}
+		return results;
+	}
+
+	std::vector<std::span<const char>> make_chunks(const std::string& text, size_t chunkSize)
+	{
+		std::vector<std::span<const char>> chunks{};
+		for (size_t i = 0; i < text.size(); i += chunkSize)
+		{
+			chunks.emplace_back(text.data() + i, std::min(chunkSize, text.size() - i));
+		}
+		return chunks;
+	}
+
+	const std::string document = R"({
+		"pi": 3.141, "happy": true, "name": "Niels", "nothing": null,
+		"answer": {"everything": 42},
+		"list": [1, 0, -2e3, [], {}],
+		"escaped": "tab\t quote\" slash\/ \u00e9 \ud83d\ude00",
+		"a/b~c": {"deep": [{"x": "\\"}]}
+	})";
+}
+
+TEST_SUITE("json_reader")
+{
+	TEST_CASE("json events")
+	{
+		const std::vector<std::string> expected{
+			" 4 ",
+			"/pi 2 3.141",
+			"/happy 1 true",
+			"/name 3 Niels",
+			"/nothing 0 null",
+			"/answer 4 ",
+			"/answer/everything 2 42",
+			"/answer 5 ",
+			"/list 6 ",
+			"/list/0 2 1",
+			"/list/1 2 0",
+			"/list/2 2 -2e3",
+			"/list/3 6 ",
+			"/list/3 7 ",
+			"/list/4 4 ",
+			"/list/4 5 ",
+			"/list 7 ",
+			"/escaped 3 tab\t quote\" slash/ \xc3\xa9 \xf0\x9f\x98\x80",
+			"/a~1b~0c 4 ",
+			"/a~1b~0c/deep 6 ",
+			"/a~1b~0c/deep/0 4 ",
+			"/a~1b~0c/deep/0/x 3 \\",
+			"/a~1b~0c/deep/0 5 ",
+			"/a~1b~0c/deep 7 ",
+			"/a~1b~0c 5 ",
+			" 5 ",
+		};
+		CHECK(describe(gentools::json_events(document)) == expected);
+
+		for (size_t chunkSize : {1, 2, 3, 5, 7, 64, 1000})
+		{
+			const auto chunks = make_chunks(document, chunkSize);
+			CHECK(describe(gentools::json_events(chunks)) == expected);
+		}
+	}
+
+	TEST_CASE("json events agree with nlohmann")
+	{
+		const auto parsed = nlohmann::json::parse(document);
+		std::vector<std::string> expected{};
+		for (const auto& item : gentools::traverse_paths(parsed))
+		{
+			if (item.value.is<std::string_view>())
+			{
+				expected.push_back(std::string{item.path} + '=' + std::string{item.value.get<std::string_view>()});
+			}
+		}
+
+		std::vector<std::string> strings{};
+		for (const auto& event : gentools::json_events(document))
+		{
+			if (event.token() == gentools::json_token::string)
+			{
+				strings.push_back(std::string{event.path()} + '=' + std::string{event.text()});
+			}
+		}
+		std::sort(expected.begin(), expected.end());
+		std::sort(strings.begin(), strings.end());
+		CHECK(strings == expected);
+	}
+
+	TEST_CASE("json event values")
+	{
+		std::vector<double> doubles{};
+		for (const auto& event : gentools::json_events("[1.5, -3, 18446744073709551615, true, \"x\"]"))
+		{
+			switch (event.token())
+			{
+			case gentools::json_token::number:
+				doubles.push_back(event.as_double());
+				break;
+			case gentools::json_token::boolean:
+				CHECK(event.as_bool());
+				break;
+			case gentools::json_token::string:
+				CHECK_THROWS_AS(event.as_int64(), std::logic_error);
+				break;
+			default:
+				break;
+			}
+			if (event.path() == "/1")
+			{
+				CHECK(event.as_int64() == -3);
+				CHECK_THROWS_AS(event.as_uint64(), std::range_error);
+			}
+			if (event.path() == "/2")
+			{
+				CHECK(event.as_uint64() == 18446744073709551615ull);
+			}
+		}
+		CHECK(doubles.size() == 3);
+	}
+
+	TEST_CASE("json events skip containers")
+	{
+		const std::string text = R"({"skipped": {"a": [1, "}]\"", {"b": "\\"}], "c": {}}, "kept": [{"d": 1}], "last": 2})";
+		for (size_t chunkSize : {1, 2, 3, 1000})
+		{
+			const auto chunks = make_chunks(text, chunkSize);
+			std::vector<std::string> paths{};
+			for (const auto& event : gentools::json_events(chunks))
+			{
+				paths.emplace_back(event.path());
+				if (event.path() == "/skipped" || event.path() == "/kept/0")
+				{
+					event.skip();
+				}
+			}
+
+			const std::vector<std::string> expected{"", "/skipped", "/kept", "/kept/0", "/kept", "/last", ""};
+			CHECK(paths == expected);
+		}
+	}
+
+	TEST_CASE("json event sequences")
+	{
+		std::pmr::monotonic_buffer_resource resource{};
+		const std::vector<std::string> expected{" 4 ", "/a 2 1", " 5 ", " 2 2", " 3 x"};
+		CHECK(describe(gentools::json_events(std::allocator_arg, &resource, "{\"a\": 1}\n2\n\"x\"\n")) == expected);
+		CHECK(describe(gentools::json_events("")).empty());
+	}
+
+	TEST_CASE("json events reject malformed text")
+	{
+		for (const char* text : {"{", "[1,]", "{\"a\" 1}", "{\"a\": tru}", "[1 2]", "\"abc", "[\"\\x\"]", "{1: 2}",
+								 "[1}", "[-]", "[\"\\ud800\"]"})
+		{
+			CHECK_THROWS_AS(describe(gentools::json_events(text)), std::runtime_error);
+		}
+	}
+}
@@ -0,0 +1,94 @@
+#include <doctest/doctest.h>
+#include <gentools/json_selector.h>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	const auto document = nlohmann::json::parse(R"({
+		"store": "north",
+		"orders": [
+			{"id": 1, "items": [{"sku": "a1", "qty": 5}, {"sku": "a2", "qty": 12}], "paid": true},
+			{"id": 2, "items": [{"sku": "b1", "qty": 11, "tags": {"fragile": true}}], "paid": false},
+			{"id": 3, "items": [{"sku": "c1"}, {"sku": "c2", "qty": 10.5}, {"sku": "c3", "qty": "many"}]}
+		],
+		"a/b": {"~x": [10, 20, 30]}
+	})");
+
+	std::vector<std::string> select(std::string_view expression, const nlohmann::json& json = document)
+	{
+		std::vector<std::string> results{};
+		for (const auto& item : gentools::json_selector{expression}(json))
+		{
+			results.emplace_back(item.path);
+		}
+		return results;
+	}
+
+	using paths = std::vector<std::string>;
+}
+
+TEST_SUITE("json_selector")
+{
+	TEST_CASE("member, wildcard and index steps")
+	{
+		CHECK(select("$.store") == paths{"/store"});
+		CHECK(select("$.orders[*].id") == paths{"/orders/0/id", "/orders/1/id", "/orders/2/id"});
+		CHECK(select("$.orders.*.paid") == paths{"/orders/0/paid", "/orders/1/paid"});
+		CHECK(select("$.orders[1].items[0].sku") == paths{"/orders/1/items/0/sku"});
+		CHECK(select("$.orders[-1].items[-1].sku") == paths{"/orders/2/items/2/sku"});
+		CHECK(select("$['a/b'][\"~x\"][ 2 ]") == paths{"/a~1b/~0x/2"});
+		CHECK(select("$.orders[3]").empty());
+		CHECK(select("$.store.name").empty());
+		CHECK(select("$.orders.id").empty());
+		CHECK(select("$") == paths{""});
+	}
+
+	TEST_CASE("filters")
+	{
+		CHECK(select("$.orders[*].items[?(@.qty > 10)].sku") ==
+			  paths{"/orders/0/items/1/sku", "/orders/1/items/0/sku", "/orders/2/items/1/sku"});
+		CHECK(select("$.orders[*].items[?(@.qty <= 10)].sku") == paths{"/orders/0/items/0/sku"});
+		CHECK(select("$.orders[*].items[?(@.qty == 'many')]") == paths{"/orders/2/items/2"});
+		CHECK(select("$.orders[*].items[?(@.qty)].sku").size() == 5);
+		CHECK(select("$.orders[*].items[?(@.tags.fragile == true)].sku") == paths{"/orders/1/items/0/sku"});
+		CHECK(select("$.orders[?(@.paid != false)].id") == paths{"/orders/0/id"});
+		CHECK(select("$.orders[?(@['id'] >= 2)].items[*].sku") ==
+			  paths{"/orders/1/items/0/sku", "/orders/2/items/0/sku", "/orders/2/items/1/sku", "/orders/2/items/2/sku"});
+		CHECK(select("$['a/b']['~x'][?(@ > 15)]") == paths{"/a~1b/~0x/1", "/a~1b/~0x/2"});
+		CHECK(select("$.orders[?(@.missing == null)]").empty());
+	}
+
+	TEST_CASE("selected values")
+	{
+		const gentools::json_selector selector{"$.orders[*].items[?(@.qty > 10)].qty"};
+		std::pmr::monotonic_buffer_resource resource{};
+		std::vector<double> quantities{};
+		for (const auto& item : selector(std::allocator_arg, &resource, document))
+		{
+			item.value.visit([&](const auto& value) {
+				if constexpr (std::is_arithmetic_v<std::decay_t<decltype(value)>>)
+				{
+					quantities.push_back(static_cast<double>(value));
+				}
+			});
+		}
+		CHECK(quantities == std::vector<double>{12, 11, 10.5});
+
+		// a selector is reusable across documents
+		CHECK(select("$[*].qty", nlohmann::json::parse(R"([{"qty": 1}, {"qty": 2}])")) == paths{"/0/qty", "/1/qty"});
+	}
+
+	TEST_CASE("invalid selectors")
+	{
+		for (const char* expression : {"", "orders", "$..sku", "$.", "$[", "$[x]", "$['a]", "$[?(@.qty > )]",
+									   "$[?(@.qty ~ 1)]", "$[?(qty > 1)]", "$[?(@.qty < true)]"})
+		{
+			CHECK_THROWS_AS(gentools::json_selector{expression}, std::invalid_argument);
+		}
+	}
+}
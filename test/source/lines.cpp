@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <gentools/file_chunks.h>
+#include <gentools/lines.h>
+#include <gentools/mmap_array.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "temporary_file.h"
+
+namespace
+{
+	template <typename T>
+	std::vector<std::string> collect(T&& lines)
+	{
+		std::vector<std::string> results{};
+		for (auto line : lines)
+		{
+			results.emplace_back(line);
+		}
+		return results;
+	}
+
+	// Reference split, one line per '\n' with a final '\r' dropped
+	std::vector<std::string> split(const std::string& text)
+	{
+		std::vector<std::string> results{};
+		size_t start = 0;
+		while (start < text.size())
+		{
+			size_t end = std::min(text.find('\n', start), text.size());
+			std::string line = text.substr(start, end - start);
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.pop_back();
+			}
+			results.push_back(line);
+			start = end + 1;
+		}
+		return results;
+	}
+
+	std::string make_text()
+	{
+		std::string text{};
+		for (size_t i = 0; i < 300; ++i)
+		{
+			text += std::string(i % 97, static_cast<char>('a' + i % 26));
+			text += i % 5 == 0 ? "\r\n" : "\n";
+		}
+		text += "no final newline";
+		return text;
+	}
+}
+
+TEST_SUITE("lines")
+{
+	TEST_CASE("lines of a buffer")
+	{
+		const std::vector<std::string> expected{"first", "", "third", "last"};
+		CHECK(collect(gentools::lines("first\n\r\nthird\r\nlast")) == expected);
+		CHECK(collect(gentools::lines("first\n\r\nthird\r\nlast\n")) == expected);
+		CHECK(collect(gentools::lines("")).empty());
+	}
+
+	TEST_CASE("lines of a long buffer")
+	{
+		const auto text = make_text();
+		CHECK(collect(gentools::lines(text)) == split(text));
+	}
+
+	TEST_CASE("lines straddling chunks")
+	{
+		const auto text = make_text();
+		const auto expected = split(text);
+
+		for (size_t chunkSize : {1, 2, 3, 7, 63, 64, 65, 1000})
+		{
+			std::vector<std::span<const char>> chunks{};
+			for (size_t i = 0; i < text.size(); i += chunkSize)
+			{
+				chunks.emplace_back(text.data() + i, std::min(chunkSize, text.size() - i));
+			}
+			CHECK(collect(gentools::lines(chunks)) == expected);
+		}
+	}
+
+	TEST_CASE("lines of a file")
+	{
+		const auto text = make_text();
+		const gentools_tests::temporary_file file{"gentools_lines", text};
+		const auto& path = file.path;
+
+		CHECK(collect(gentools::lines(gentools::file_chunks(path, {256, 2, true}))) == split(text));
+
+		const auto mapped = gentools::mmap_array<char>(path);
+		CHECK(collect(gentools::lines(std::string_view{mapped.data(), mapped.size()})) == split(text));
+		CHECK(collect(gentools::lines(mapped.chunks(100))) == split(text));
+	}
+}
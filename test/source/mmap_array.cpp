@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <doctest/doctest.h>
+#include <filesystem>
+#include <gentools/mmap_array.h>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "temporary_file.h"
+
+namespace
+{
+	struct sample
+	{
+		uint32_t sensor;
+		int32_t value;
+	};
+
+	// The bytes of records followed by extraBytes bytes that do not make a whole record
+	std::string record_bytes(const std::vector<sample>& records, size_t extraBytes = 0)
+	{
+		std::string bytes(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(sample));
+		bytes.append("\1\2\3", extraBytes);
+		return bytes;
+	}
+
+	const std::vector<sample> samples{{1, 10}, {1, -3}, {2, 7}, {3, 1}, {3, 2}, {3, 3}};
+}
+
+TEST_SUITE("mmap_array")
+{
+	TEST_CASE("mmap_array maps the records of a file")
+	{
+		gentools_tests::temporary_file file{"gentools_mmap_array_records", record_bytes(samples, 3)};
+		auto records = gentools::mmap_array<sample>(file.path, gentools::mmap_advice::sequential |
+		                                                       gentools::mmap_advice::willneed);
+
+		REQUIRE(records.size() == samples.size());
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			CHECK(records[i].sensor == samples[i].sensor);
+			CHECK(records[i].value == samples[i].value);
+		}
+	}
+
+	TEST_CASE("mmap_array feeds the adaptors")
+	{
+		gentools_tests::temporary_file file{"gentools_mmap_array_adaptors", record_bytes(samples)};
+		const auto records = gentools::mmap_array<sample>(file.path);
+
+		auto positive = [](const sample& s) { return s.value > 0; };
+		int positives = 0;
+		for (auto&& s : gentools::filter(records, positive))
+		{
+			CHECK(s.value > 0);
+			++positives;
+		}
+		CHECK(positives == 5);
+
+		auto bySensor = [](const sample& s) { return s.sensor; };
+		std::vector<size_t> groupSizes{};
+		for (auto&& [sensor, group] : gentools::group_by(records, bySensor))
+		{
+			groupSizes.push_back(static_cast<size_t>(group.size()));
+		}
+		CHECK(groupSizes == std::vector<size_t>{2, 1, 3});
+
+		const std::vector<bool> selectors{false, false, true};
+		std::vector<uint32_t> selected{};
+		for (auto&& s : gentools::compress(records, selectors))
+		{
+			selected.push_back(s.sensor);
+		}
+		CHECK(selected == std::vector<uint32_t>{2});
+
+		auto addValues = [](sample total, const sample& s) { return sample{s.sensor, total.value + s.value}; };
+		int32_t total = 0;
+		for (auto&& s : gentools::accumulate(records, addValues, std::nullopt))
+		{
+			total = s.value;
+		}
+		CHECK(total == 20);
+	}
+
+	TEST_CASE("mmap_array chunks")
+	{
+		gentools_tests::temporary_file file{"gentools_mmap_array_chunks", record_bytes(samples)};
+		const auto records = gentools::mmap_array<sample>(file.path);
+
+		std::vector<size_t> chunkSizes{};
+		const sample* next = records.data();
+		for (auto chunk : records.chunks(4))
+		{
+			CHECK(chunk.data() == next);
+			next += chunk.size();
+			chunkSizes.push_back(chunk.size());
+		}
+		CHECK(chunkSizes == std::vector<size_t>{4, 2});
+	}
+
+	TEST_CASE("mmap_array of an empty file")
+	{
+		gentools_tests::temporary_file file{"gentools_mmap_array_empty", record_bytes({}, 3)};
+		const auto records = gentools::mmap_array<sample>(file.path);
+		CHECK(records.empty());
+		CHECK(records.begin() == records.end());
+	}
+
+	TEST_CASE("mmap_array throws on a missing file")
+	{
+		CHECK_THROWS_AS(gentools::mmap_array<sample>(std::filesystem::temp_directory_path() / "gentools_missing_file"),
+		                std::system_error);
+	}
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <gentools/ndjson.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	std::string make_text(int count)
+	{
+		std::string text{};
+		for (int i = 0; i < count; ++i)
+		{
+			text += R"({"id": )" + std::to_string(i) + R"(, "name": "item )" + std::to_string(i) + "\"}";
+			// blank lines and windows line ends are allowed
+			text += i % 10 == 3 ? "\r\n\n" : "\n";
+		}
+		return text;
+	}
+
+	std::vector<std::span<const char>> make_chunks(const std::string& text, size_t chunkSize)
+	{
+		std::vector<std::span<const char>> chunks{};
+		for (size_t i = 0; i < text.size(); i += chunkSize)
+		{
+			chunks.emplace_back(text.data() + i, std::min(chunkSize, text.size() - i));
+		}
+		return chunks;
+	}
+
+	template <typename T>
+	std::vector<int> ids(T&& documents)
+	{
+		std::vector<int> results{};
+		for (const auto& document : documents)
+		{
+			results.push_back(document["id"].template get<int>());
+		}
+		return results;
+	}
+
+	std::vector<int> iota(int count)
+	{
+		std::vector<int> results(count);
+		for (int i = 0; i < count; ++i)
+		{
+			results[i] = i;
+		}
+		return results;
+	}
+}
+
+TEST_SUITE("ndjson")
+{
+	TEST_CASE("ndjson documents are yielded in input order")
+	{
+		const std::string text = make_text(500);
+		gentools::thread_pool pool{3};
+		for (size_t batchBytes : {1, 64, 1000, 1 << 20})
+		{
+			CHECK(ids(gentools::ndjson_documents(pool, text, {batchBytes, 2})) == iota(500));
+
+			for (size_t chunkSize : {1, 7, 4096})
+			{
+				CHECK(ids(gentools::ndjson_documents(pool, make_chunks(text, chunkSize), {batchBytes})) == iota(500));
+			}
+		}
+
+		// the text must outlive the generator
+		const std::string_view unterminated{text.data(), text.size() - 1};
+		CHECK(ids(gentools::ndjson_documents(unterminated, {100, 0, 2})) == iota(500));
+		CHECK(ids(gentools::ndjson_documents("")).empty());
+		CHECK(ids(gentools::ndjson_documents("\n \n")).empty());
+	}
+
+	TEST_CASE("ndjson transform runs on the workers")
+	{
+		const std::string text = make_text(200);
+		std::vector<std::string> names{};
+		for (const auto& name : gentools::ndjson_transform(
+				 text, [](nlohmann::json& document) { return document["name"].get<std::string>(); }, {128, 4, 4}))
+		{
+			names.push_back(name);
+		}
+		REQUIRE(names.size() == 200);
+		CHECK(names.front() == "item 0");
+		CHECK(names.back() == "item 199");
+	}
+
+	TEST_CASE("ndjson errors")
+	{
+		const std::string text = "{\"id\": 0}\n{\"id\": 1}\n\n{\"id\": 2\n{\"id\": 3}\n";
+		for (size_t batchBytes : {1, 12, 1000})
+		{
+			std::vector<int> seen{};
+			std::string message{};
+			try
+			{
+				for (const auto& document : gentools::ndjson_documents(text, {batchBytes, 0, 2}))
+				{
+					seen.push_back(document["id"].get<int>());
+				}
+			}
+			catch (const std::runtime_error& error)
+			{
+				message = error.what();
+			}
+			CHECK(message.starts_with("ndjson: line 4: "));
+			CHECK(seen == std::vector<int>{0, 1});
+		}
+
+		auto failing = [](nlohmann::json& document) {
+			if (document["id"] == 1)
+			{
+				throw std::logic_error("rejected");
+			}
+			return document["id"].get<int>();
+		};
+		std::vector<int> seen{};
+		CHECK_THROWS_AS(
+			[&] {
+				for (int id : gentools::ndjson_transform("{\"id\": 0}\n{\"id\": 1}\n{\"id\": 2}\n", failing, {1, 0, 2}))
+				{
+					seen.push_back(id);
+				}
+			}(),
+			std::logic_error);
+		CHECK(seen == std::vector<int>{0});
+	}
+}
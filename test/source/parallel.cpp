@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <atomic>
+#include <doctest/doctest.h>
+#include <gentools/parallel.h>
+#include <numeric>
+#include <range/v3/view/iota.hpp>
+#include <stdexcept>
+#include <vector>
+
+TEST_SUITE("thread_pool")
+{
+	TEST_CASE("thread_pool runs every task")
+	{
+		std::atomic<int> sum{0};
+		{
+			gentools::thread_pool pool{3};
+			CHECK(pool.size() == 3);
+			CHECK(pool.current_worker() == gentools::thread_pool::npos);
+
+			for (int i = 1; i <= 100; ++i)
+			{
+				pool.submit([&sum, &pool, i]
+				{
+					CHECK(pool.current_worker() < pool.size());
+					sum += i;
+				});
+			}
+		}
+		CHECK(sum == 5050);
+	}
+}
+
+TEST_SUITE("parallel_transform")
+{
+	TEST_CASE("parallel_transform preserves input order")
+	{
+		std::vector<int> input(500);
+		std::iota(input.begin(), input.end(), 0);
+
+		std::vector<int> results{};
+		for (auto v : gentools::parallel_transform(input, [](auto x) { return x * x; }, 4, 8))
+		{
+			results.push_back(v);
+		}
+
+		REQUIRE(results.size() == input.size());
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			CHECK(results[i] == input[i] * input[i]);
+		}
+	}
+
+	TEST_CASE("parallel_transform over a generator on a shared pool")
+	{
+		gentools::thread_pool pool{2};
+		const std::vector<int> input{1, 2, 3, 4, 5};
+		auto twice = [](auto x) { return x * 2; };
+		auto doubled = gentools::transform(input, twice);
+
+		std::vector<int> results{};
+		for (auto v : gentools::parallel_transform(pool, doubled, [](auto x) { return x + 1; }))
+		{
+			results.push_back(v);
+		}
+
+		const std::vector<int> expected{3, 5, 7, 9, 11};
+		CHECK(results == expected);
+	}
+
+	TEST_CASE("parallel_transform_unordered yields every result")
+	{
+		std::vector<int> input(300);
+		std::iota(input.begin(), input.end(), 0);
+
+		std::vector<int> results{};
+		for (auto v : gentools::parallel_transform_unordered(input, [](auto x) { return -x; }, 3, 5))
+		{
+			results.push_back(-v);
+		}
+
+		std::sort(results.begin(), results.end());
+		CHECK(results == input);
+	}
+
+	TEST_CASE("parallel_transform propagates exceptions")
+	{
+		const std::vector<int> input{1, 2, 3, 4, 5, 6};
+		std::vector<int> results{};
+
+		CHECK_THROWS_AS(
+			for (auto v : gentools::parallel_transform(input, [](auto x)
+			{
+				if (x == 4)
+				{
+					throw std::runtime_error("bad element");
+				}
+				return x;
+			}, 2, 3))
+			{
+				results.push_back(v);
+			},
+			std::runtime_error);
+
+		const std::vector<int> expected{1, 2, 3};
+		CHECK(results == expected);
+	}
+
+	TEST_CASE("parallel_transform stops early")
+	{
+		auto numbers = ranges::views::iota(0);
+		int sum = 0;
+		for (auto v : gentools::parallel_transform(gentools::to_generator(numbers), [](auto x) { return x; }, 2))
+		{
+			if (v == 10)
+			{
+				break;
+			}
+			sum += v;
+		}
+		CHECK(sum == 45);
+	}
+}
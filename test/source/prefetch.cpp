@@ -0,0 +1,131 @@
+#include <atomic>
+#include <chrono>
+#include <doctest/doctest.h>
+#include <gentools/prefetch.h>
+#include <numeric>
+#include <range/v3/view/iota.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("prefetch")
+{
+	TEST_CASE("prefetch preserves order with backpressure")
+	{
+		std::vector<int> input(1000);
+		std::iota(input.begin(), input.end(), 0);
+
+		auto triple = [](auto x) { return x * 3; };
+		std::vector<int> results{};
+		for (auto v : gentools::prefetch(gentools::transform(input, triple), 4))
+		{
+			results.push_back(v);
+		}
+
+		REQUIRE(results.size() == input.size());
+		for (size_t i = 0; i < input.size(); ++i)
+		{
+			CHECK(results[i] == input[i] * 3);
+		}
+	}
+
+	TEST_CASE("prefetch hands over each element while the consumer waits")
+	{
+		std::vector<int> input(10);
+		std::iota(input.begin(), input.end(), 0);
+
+		// the producer only makes element x once the consumer has read x elements, so it would
+		// wait forever if elements were held back until a batch is full
+		std::atomic<int> consumed{0};
+		std::atomic<bool> starved{false};
+		auto afterConsumer = [&consumed, &starved](int x)
+		{
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+			while (consumed.load() < x && !starved.load())
+			{
+				if (std::chrono::steady_clock::now() > deadline)
+				{
+					starved = true;
+				}
+				std::this_thread::yield();
+			}
+			return x;
+		};
+
+		std::vector<int> results{};
+		for (auto v : gentools::prefetch(gentools::transform(input, afterConsumer)))
+		{
+			results.push_back(v);
+			++consumed;
+		}
+
+		CHECK_FALSE(starved.load());
+		CHECK(results == input);
+	}
+
+	TEST_CASE("prefetch runs the producer on another thread")
+	{
+		const std::vector<int> input{1, 2, 3};
+		std::thread::id producerThread{};
+
+		auto recordThread = [&producerThread](auto x)
+		{
+			producerThread = std::this_thread::get_id();
+			return x;
+		};
+		auto gen = gentools::prefetch(gentools::transform(input, recordThread));
+
+		int sum = 0;
+		for (auto v : gen)
+		{
+			sum += v;
+		}
+
+		CHECK(sum == 6);
+		CHECK(producerThread != std::thread::id{});
+		CHECK(producerThread != std::this_thread::get_id());
+	}
+
+	TEST_CASE("prefetch propagates exceptions")
+	{
+		const std::vector<int> input{1, 2, 3, 4};
+		auto failOnThree = [](auto x)
+		{
+			if (x == 3)
+			{
+				throw std::runtime_error("upstream failure");
+			}
+			return x;
+		};
+		auto gen = gentools::prefetch(gentools::transform(input, failOnThree), 2);
+
+		std::vector<int> results{};
+		CHECK_THROWS_AS(
+			for (auto v : gen)
+			{
+				results.push_back(v);
+			},
+			std::runtime_error);
+
+		const std::vector<int> expected{1, 2};
+		CHECK(results == expected);
+	}
+
+	TEST_CASE("prefetch stops an infinite producer")
+	{
+		auto numbers = ranges::views::iota(0);
+		int sum = 0;
+		{
+			auto gen = gentools::prefetch(gentools::to_generator(numbers), 8);
+			for (auto v : gen)
+			{
+				if (v == 100)
+				{
+					break;
+				}
+				sum += v;
+			}
+		}
+		CHECK(sum == 4950);
+	}
+}
@@ -0,0 +1,120 @@
+#include <atomic>
+#include <doctest/doctest.h>
+#include <gentools/scheduler.h>
+#include <range/v3/view/iota.hpp>
+#include <range/v3/view/take.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_SUITE("scheduler")
+{
+	TEST_CASE("scheduler runs every pipeline")
+	{
+		const std::vector<int> input{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+		auto triple = [](auto x) { return x * 3; };
+		std::atomic<int> sum{0};
+
+		gentools::scheduler scheduler{4, {3, {}}};
+		for (int i = 0; i < 100; ++i)
+		{
+			scheduler.spawn(gentools::transform(input, triple), [&sum](int v) { sum += v; });
+		}
+		scheduler.wait();
+
+		CHECK(sum == 100 * 165);
+		CHECK(scheduler.active() == 0);
+		CHECK(scheduler.stats().spawned == 100);
+		CHECK(scheduler.stats().completed == 100);
+		CHECK(scheduler.stats().slices >= 400);
+	}
+
+	TEST_CASE("scheduler interleaves pipelines on a single worker")
+	{
+		auto numbers = ranges::views::iota(0) | ranges::views::take(20);
+		std::vector<int> order{};
+
+		gentools::thread_pool pool{1};
+		gentools::scheduler scheduler{pool, {4, std::chrono::microseconds{0}}};
+
+		// holds the worker until both pipelines are queued
+		std::atomic<bool> spawned{false};
+		pool.submit([&spawned]
+		{
+			while (!spawned)
+			{
+				std::this_thread::yield();
+			}
+		});
+		scheduler.spawn(gentools::to_generator(numbers), [&order](int) { order.push_back(0); });
+		scheduler.spawn(gentools::to_generator(numbers), [&order](int) { order.push_back(1); });
+		spawned = true;
+		scheduler.wait();
+
+		REQUIRE(order.size() == 40);
+		size_t switches = 0;
+		for (size_t i = 1; i < order.size(); ++i)
+		{
+			switches += order[i] != order[i - 1] ? 1 : 0;
+		}
+		CHECK(switches == 9);
+	}
+
+	TEST_CASE("scheduler stops a pipeline whose sink returns false")
+	{
+		auto numbers = ranges::views::iota(0);
+		int last = -1;
+
+		gentools::scheduler scheduler{2};
+		scheduler.spawn(gentools::to_generator(numbers), [&last](int v)
+		{
+			last = v;
+			return v < 100;
+		});
+		scheduler.wait();
+
+		CHECK(last == 100);
+	}
+
+	TEST_CASE("scheduler rethrows the exception of a failed pipeline")
+	{
+		const std::vector<int> input{1, 2, 3};
+		std::atomic<int> completed{0};
+
+		gentools::scheduler scheduler{2};
+		scheduler.spawn(input, [](int v)
+		{
+			if (v == 2)
+			{
+				throw std::runtime_error("pipeline failure");
+			}
+		});
+		scheduler.spawn(input, [&completed](int) { ++completed; });
+
+		CHECK_THROWS_AS(scheduler.wait(), std::runtime_error);
+		CHECK(completed == 3);
+		CHECK_NOTHROW(scheduler.wait());
+	}
+
+	TEST_CASE("scheduler cancels endless pipelines")
+	{
+		auto numbers = ranges::views::iota(0);
+		std::atomic<int> pulled{0};
+
+		gentools::scheduler scheduler{2, {16, {}}};
+		for (int i = 0; i < 4; ++i)
+		{
+			scheduler.spawn(gentools::to_generator(numbers), [&pulled](int) { ++pulled; });
+		}
+
+		while (pulled < 1000)
+		{
+			std::this_thread::yield();
+		}
+		scheduler.cancel();
+		scheduler.wait();
+
+		CHECK(scheduler.active() == 0);
+		CHECK(scheduler.stats().completed == 4);
+	}
+}
@@ -0,0 +1,147 @@
+#include <doctest/doctest.h>
+#include <gentools/split.h>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	template <typename T>
+	std::vector<std::string> collect(T&& tokens)
+	{
+		std::vector<std::string> results{};
+		for (auto token : tokens)
+		{
+			results.emplace_back(token);
+		}
+		return results;
+	}
+
+	// Reference split on any of the characters of delimiters
+	std::vector<std::string> reference(const std::string& text, std::string_view delimiters)
+	{
+		std::vector<std::string> results{};
+		if (text.empty())
+		{
+			return results;
+		}
+		size_t start = 0;
+		while (true)
+		{
+			const size_t end = text.find_first_of(delimiters, start);
+			results.push_back(text.substr(start, end == std::string::npos ? std::string::npos : end - start));
+			if (end == std::string::npos)
+			{
+				return results;
+			}
+			start = end + 1;
+		}
+	}
+
+	std::string make_text()
+	{
+		std::string text{};
+		for (size_t i = 0; i < 200; ++i)
+		{
+			text += std::string(i % 37, static_cast<char>('a' + i % 26));
+			text += i % 3 == 0 ? ";" : ",";
+		}
+		text += "last";
+		return text;
+	}
+}
+
+TEST_SUITE("split")
+{
+	TEST_CASE("split on a character")
+	{
+		const std::vector<std::string> expected{"a", "", "bc", ""};
+		CHECK(collect(gentools::split("a,,bc,", ',')) == expected);
+		CHECK(collect(gentools::split("abc", ',')) == std::vector<std::string>{"abc"});
+		CHECK(collect(gentools::split(",", ',')) == std::vector<std::string>{"", ""});
+		CHECK(collect(gentools::split("", ',')).empty());
+
+		const auto text = make_text();
+		CHECK(collect(gentools::split(text, ',')) == reference(text, ","));
+	}
+
+	TEST_CASE("split on a string")
+	{
+		const std::vector<std::string> expected{"a", "b", "-c", ""};
+		CHECK(collect(gentools::split("a--b---c--", "--")) == expected);
+		CHECK(collect(gentools::split("a-b", "--")) == std::vector<std::string>{"a-b"});
+		CHECK(collect(gentools::split("ab-", "--")) == std::vector<std::string>{"ab-"});
+		CHECK(collect(gentools::split("x", "x")) == std::vector<std::string>{"", ""});
+		CHECK_THROWS_AS(collect(gentools::split("a", "")), std::invalid_argument);
+
+		// delimiters straddling the 64 byte blocks of the scanner
+		std::string text{};
+		std::vector<std::string> pieces{};
+		for (size_t i = 0; i < 100; ++i)
+		{
+			pieces.push_back(std::string(i % 13, 'x'));
+			text += pieces.back();
+			if (i + 1 < 100)
+			{
+				text += "<=>";
+			}
+		}
+		CHECK(collect(gentools::split(text, "<=>")) == pieces);
+	}
+
+	TEST_CASE("split on a set of characters")
+	{
+		const std::vector<std::string> expected{"a", "b", "", "c"};
+		CHECK(collect(gentools::split_any("a,b;,c", ",;")) == expected);
+
+		const auto text = make_text();
+		CHECK(collect(gentools::split_any(text, ",;")) == reference(text, ",;"));
+		CHECK_THROWS_AS(collect(gentools::split_any("a", "")), std::invalid_argument);
+		CHECK_THROWS_AS(collect(gentools::split_any("a", "123456789")), std::invalid_argument);
+	}
+
+	TEST_CASE("split in batches")
+	{
+		const auto text = make_text();
+		const auto expected = reference(text, ",");
+
+		for (size_t batchSize : {1, 7, 64, 1000})
+		{
+			std::vector<std::string> tokens{};
+			size_t batches = 0;
+			for (auto batch : gentools::split_batches(text, ',', batchSize))
+			{
+				CHECK(batch.size() <= batchSize);
+				for (const auto& offsets : batch)
+				{
+					tokens.emplace_back(offsets.in(text));
+				}
+				++batches;
+			}
+			CHECK(tokens == expected);
+			CHECK(batches == (expected.size() + batchSize - 1) / batchSize);
+		}
+
+		size_t emptyBatches = 0;
+		for (auto batch : gentools::split_batches("", ','))
+		{
+			emptyBatches += batch.size() + 1;
+		}
+		CHECK(emptyBatches == 0);
+	}
+
+	TEST_CASE("split in batches from a memory resource")
+	{
+		std::pmr::monotonic_buffer_resource resource{};
+		std::vector<gentools::token_offsets> offsets{};
+		for (auto batch : gentools::split_batches(std::allocator_arg, &resource, "ab,,c", ',', 2))
+		{
+			offsets.insert(offsets.end(), batch.begin(), batch.end());
+		}
+
+		const std::vector<gentools::token_offsets> expected{{0, 2}, {3, 0}, {4, 1}};
+		CHECK(offsets == expected);
+	}
+}
@@ -0,0 +1,191 @@
+#include <doctest/doctest.h>
+#include <gentools.h>
+#include <gentools/lines.h>
+#include <gentools/split.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST_SUITE("stats")
+{
+	TEST_CASE("filter selectivity")
+	{
+		gentools::stats::reset();
+
+		const std::vector<int> input{1, 2, 3, 4, 5, 6, 7, 8};
+		auto squares = gentools::transform(input, [](auto x) { return x * x; });
+		int sum = 0;
+		for (auto v : gentools::filter(squares, [](auto x) { return x % 2 == 0; }))
+		{
+			sum += v;
+		}
+		CHECK(sum == 120);
+
+		const auto snapshot = gentools::stats::snapshot();
+		const auto* filterStage = snapshot.find("filter");
+		const auto* transformStage = snapshot.find("transform");
+
+		if constexpr (gentools::stats_enabled)
+		{
+			REQUIRE(filterStage != nullptr);
+			REQUIRE(transformStage != nullptr);
+
+			CHECK(transformStage->elements_in == 8);
+			CHECK(transformStage->elements_out == 8);
+			CHECK(filterStage->elements_in == 8);
+			CHECK(filterStage->elements_out == 4);
+			CHECK(filterStage->resumes == 5);
+		}
+		else
+		{
+			CHECK(snapshot.stages.empty());
+			CHECK(filterStage == nullptr);
+		}
+	}
+
+	TEST_CASE("text sources count their tokens in")
+	{
+		gentools::stats::reset();
+
+		size_t tokens = 0;
+		for (auto line : gentools::lines("a,b\nc\nd,e,f"))
+		{
+			for ([[maybe_unused]] auto field : gentools::split(line, ','))
+			{
+				++tokens;
+			}
+			for ([[maybe_unused]] auto field : gentools::split_any(line, ",;"))
+			{
+				++tokens;
+			}
+		}
+		CHECK(tokens == 12);
+
+		const auto snapshot = gentools::stats::snapshot();
+		if constexpr (gentools::stats_enabled)
+		{
+			for (const char* name : {"lines", "split", "split_any"})
+			{
+				const auto* stage = snapshot.find(name);
+				REQUIRE(stage != nullptr);
+				CHECK(stage->elements_in == stage->elements_out);
+			}
+			CHECK(snapshot.find("split")->elements_in == 2);
+			CHECK(snapshot.aggregate().find("split")->elements_in == 6);
+		}
+		else
+		{
+			CHECK(snapshot.stages.empty());
+		}
+	}
+
+	TEST_CASE("every stage has counters of its own")
+	{
+		gentools::stats::reset();
+
+		const std::vector<int> input{1, 2, 3, 4, 5, 6, 7, 8};
+		auto odd = gentools::filter(input, [](auto x) { return x % 2 == 1; });
+		int sum = 0;
+		for (auto v : gentools::filter(odd, [](auto x) { return x < 5; }))
+		{
+			sum += v;
+		}
+		CHECK(sum == 4);
+
+		const auto snapshot = gentools::stats::snapshot();
+		if constexpr (gentools::stats_enabled)
+		{
+			// the downstream filter runs first, so it is the older stage
+			REQUIRE(snapshot.stages.size() == 2);
+			CHECK(snapshot.stages[0].elements_in == 4);
+			CHECK(snapshot.stages[0].elements_out == 2);
+			CHECK(snapshot.stages[1].elements_in == 8);
+			CHECK(snapshot.stages[1].elements_out == 4);
+			CHECK(snapshot.aggregate().stages.size() == 1);
+		}
+		else
+		{
+			CHECK(snapshot.stages.empty());
+		}
+	}
+
+	TEST_CASE("labels tell apart the uses of an adaptor")
+	{
+		gentools::stats::reset();
+
+		const std::vector<int> input{1, 2, 3, 4, 5, 6, 7, 8};
+		for (int round = 0; round < 2; ++round)
+		{
+			gentools::stats::label label{"evens"};
+			for ([[maybe_unused]] auto v : gentools::filter(input, [](auto x) { return x % 2 == 0; }))
+			{
+			}
+		}
+		{
+			gentools::stats::label label{"small"};
+			for ([[maybe_unused]] auto v : gentools::filter(input, [](auto x) { return x < 3; }))
+			{
+			}
+		}
+
+		const auto snapshot = gentools::stats::snapshot().aggregate();
+		if constexpr (gentools::stats_enabled)
+		{
+			REQUIRE(snapshot.stages.size() == 2);
+			REQUIRE(snapshot.find("filter", "evens") != nullptr);
+			REQUIRE(snapshot.find("filter", "small") != nullptr);
+			CHECK(snapshot.find("filter") == nullptr);
+			CHECK(snapshot.find("filter", "evens")->elements_in == 16);
+			CHECK(snapshot.find("filter", "evens")->elements_out == 8);
+			CHECK(snapshot.find("filter", "small")->elements_out == 2);
+		}
+		else
+		{
+			CHECK(snapshot.stages.empty());
+		}
+	}
+
+	TEST_CASE("reset forgets finished stages")
+	{
+		const std::vector<int> input{1, 2, 3};
+		auto running = gentools::filter(input, [](auto x) { return x > 1; });
+		auto it = running.begin();
+		CHECK(*it == 2);
+		for ([[maybe_unused]] auto v : gentools::filter(input, [](auto x) { return x > 1; }))
+		{
+		}
+
+		gentools::stats::reset();
+		++it;
+		CHECK(*it == 3);
+
+		const auto snapshot = gentools::stats::snapshot();
+		if constexpr (gentools::stats_enabled)
+		{
+			REQUIRE(snapshot.stages.size() == 1);
+			CHECK(snapshot.stages[0].elements_in == 1);
+			CHECK(snapshot.stages[0].elements_out == 1);
+		}
+		else
+		{
+			CHECK(snapshot.stages.empty());
+		}
+	}
+
+	TEST_CASE("stats dumps")
+	{
+		gentools::stats snapshot{};
+		snapshot.stages.push_back({"filter", "parse", 10, 5, 6, 1000, 64});
+
+		std::ostringstream text;
+		snapshot.print(text);
+		CHECK(text.str().find("parse filter: in 10") == 0);
+		CHECK(text.str().find("selectivity 0.5") != std::string::npos);
+
+		std::ostringstream json;
+		snapshot.print_json(json);
+		CHECK(json.str()
+			  == "[{\"name\":\"filter\",\"label\":\"parse\",\"elements_in\":10,\"elements_out\":5,\"resumes\":6,"
+				 "\"nanoseconds\":1000,\"allocated_bytes\":64}]");
+	}
+}
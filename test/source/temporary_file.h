@@ -0,0 +1,47 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace gentools_tests
+{
+	// Different on every call and in every process, so tests running in parallel never share a file
+	inline std::string unique_suffix()
+	{
+		static std::random_device device{};
+		static size_t counter = 0;
+		return std::to_string(device()) + "_" + std::to_string(++counter);
+	}
+
+	// Unique path in the temporary directory, whatever the test leaves there is removed at the end
+	struct temporary_file
+	{
+		explicit temporary_file(std::string_view name)
+			: path(std::filesystem::temp_directory_path() / (std::string{name} + "_" + unique_suffix()))
+		{
+		}
+
+		// The file created with content
+		temporary_file(std::string_view name, std::string_view content)
+			: temporary_file(name)
+		{
+			std::ofstream out{path, std::ios::binary};
+			out.write(content.data(), static_cast<std::streamsize>(content.size()));
+		}
+
+		~temporary_file()
+		{
+			std::error_code error{};
+			std::filesystem::remove(path, error);
+		}
+
+		temporary_file(const temporary_file&) = delete;
+		temporary_file& operator=(const temporary_file&) = delete;
+
+		std::filesystem::path path;
+	};
+}